@@ -28,6 +28,7 @@
 #include <cmath>
 #include <iostream>
 #include "../sfizz/SIMDHelpers.h"
+#include "SIMDLevels.h"
 
 class GainSingle : public benchmark::Fixture {
 public:
@@ -140,4 +141,4 @@ BENCHMARK_REGISTER_F(GainArray, Scalar)->RangeMultiplier(4)->Range(1 << 2, 1 <<
 BENCHMARK_REGISTER_F(GainArray, SIMD)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
 BENCHMARK_REGISTER_F(GainArray, Scalar_Unaligned)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
 BENCHMARK_REGISTER_F(GainArray, SIMD_Unaligned)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
-BENCHMARK_MAIN();
\ No newline at end of file
+SIMD_BENCHMARK_MAIN()
\ No newline at end of file
@@ -0,0 +1,93 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "../sfizz/SIMDHelpers.h"
+#include "SIMDLevels.h"
+#include "absl/types/span.h"
+
+// The second argument is the pitch ratio in percent
+constexpr int sourceSize { 1 << 16 };
+
+class Interpolation : public benchmark::Fixture {
+public:
+  void SetUp(const ::benchmark::State& state) {
+    std::random_device rd { };
+    std::mt19937 gen { rd() };
+    std::uniform_real_distribution<float> dist { -1, 1 };
+    source = std::vector<float>(sourceSize);
+    std::generate(source.begin(), source.end(), [&]() { return dist(gen); });
+
+    const auto size = static_cast<size_t>(state.range(0));
+    const auto jump = static_cast<float>(state.range(1)) / 100.0f;
+    jumps = std::vector<float>(size, jump);
+    indices = std::vector<int>(size);
+    leftCoeffs = std::vector<float>(size);
+    rightCoeffs = std::vector<float>(size);
+    output = std::vector<float>(size);
+    saturatingSFZIndex<float, false>(jumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), 10.0f, sourceSize - 1);
+  }
+
+  void TearDown(const ::benchmark::State& state [[maybe_unused]]) {
+
+  }
+
+  std::vector<float> source;
+  std::vector<float> jumps;
+  std::vector<int> indices;
+  std::vector<float> leftCoeffs;
+  std::vector<float> rightCoeffs;
+  std::vector<float> output;
+};
+
+BENCHMARK_DEFINE_F(Interpolation, Scalar)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        interpolateLinear<float, false>(indices, leftCoeffs, rightCoeffs, source, absl::MakeSpan(output));
+        benchmark::DoNotOptimize(output.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(Interpolation, SIMD)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        interpolateLinear<float, true>(indices, leftCoeffs, rightCoeffs, source, absl::MakeSpan(output));
+        benchmark::DoNotOptimize(output.data());
+    }
+}
+
+// What the voices do instead when there is no pitch change
+BENCHMARK_DEFINE_F(Interpolation, Copy)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        copy<float>(absl::MakeConstSpan(source).subspan(indices.front(), output.size()), absl::MakeSpan(output));
+        benchmark::DoNotOptimize(output.data());
+    }
+}
+
+BENCHMARK_REGISTER_F(Interpolation, Scalar)->ArgsProduct({ { 256, 1024 }, { 100, 101, 150, 300 } });
+BENCHMARK_REGISTER_F(Interpolation, SIMD)->ArgsProduct({ { 256, 1024 }, { 100, 101, 150, 300 } });
+BENCHMARK_REGISTER_F(Interpolation, Copy)->ArgsProduct({ { 256, 1024 }, { 100 } });
+SIMD_BENCHMARK_MAIN()
@@ -0,0 +1,326 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../sfizz/FilePool.h"
+#include "../sfizz/Parser.h"
+#include "../sfizz/Region.h"
+#include "../sfizz/Synth.h"
+
+// Times the loading of synthetic instruments in separate stages: the text parsing with
+// the includes and defines, the building of the regions from the parsed opcodes, the
+// probing of the samples by the file pool, and the whole Synth::loadSfzFile. The argument
+// is the number of regions, and the peakBytes counter is the largest heap usage of an
+// iteration on top of what was allocated before it. This counts what goes through
+// operator new, which leaves out the audio buffers; the preloadedBytes counter of the
+// sample probing gives their size.
+
+namespace {
+std::atomic<size_t> heapBytes { 0 };
+std::atomic<size_t> peakHeapBytes { 0 };
+constexpr size_t allocationHeader { alignof(std::max_align_t) };
+}
+
+void* operator new(std::size_t size)
+{
+    auto block = static_cast<char*>(std::malloc(size + allocationHeader));
+    if (block == nullptr)
+        throw std::bad_alloc();
+
+    *reinterpret_cast<std::size_t*>(block) = size;
+    const size_t usedBytes = heapBytes += size;
+    size_t peak = peakHeapBytes;
+    while (usedBytes > peak && !peakHeapBytes.compare_exchange_weak(peak, usedBytes)) { }
+    return block + allocationHeader;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer == nullptr)
+        return;
+
+    auto block = static_cast<char*>(pointer) - allocationHeader;
+    heapBytes -= *reinterpret_cast<std::size_t*>(block);
+    std::free(block);
+}
+
+namespace {
+constexpr int includeDepth { 16 };
+constexpr int regionsPerFile { 1000 };
+constexpr int regionsPerGroup { 16 };
+constexpr std::array<const char*, 10> sampleFiles {
+    "kick.wav", "snare.wav", "closedhat.wav", "mono_sample.wav", "stereo_sample.wav",
+    "36-CajonCenter-1.wav", "36-CajonCenter-2.wav", "36-CajonCenter-3.wav",
+    "36-CajonCenter-4.wav", "36-CajonCenter-5.wav"
+};
+
+/**
+ * Writes an instrument with the given number of regions in a directory, and returns the
+ * path of its root file. The regions are spread over files included at the bottom of a
+ * chain of includes, each level of which defines a controller number used by the
+ * regions' _onccN opcodes. The samples are copies of the test files.
+ */
+std::filesystem::path writeSyntheticInstrument(const std::filesystem::path& directory, int numRegions)
+{
+    namespace fs = std::filesystem;
+    fs::create_directories(directory / "samples");
+    fs::create_directories(directory / "nesting");
+    fs::create_directories(directory / "regions");
+    for (auto sample : sampleFiles)
+        fs::copy_file(fs::path(SFIZZ_TEST_FILES) / sample, directory / "samples" / sample, fs::copy_options::overwrite_existing);
+
+    const int numFiles = (numRegions + regionsPerFile - 1) / regionsPerFile;
+    for (int level = 0; level < includeDepth; ++level) {
+        std::ofstream nesting { directory / "nesting" / ("level_" + std::to_string(level) + ".sfz") };
+        nesting << "#define $CC" << level << ' ' << 20 + level << '\n';
+        if (level + 1 < includeDepth) {
+            nesting << "#include \"nesting/level_" << level + 1 << ".sfz\"\n";
+            continue;
+        }
+        for (int part = 0; part < numFiles; ++part)
+            nesting << "#include \"regions/part_" << part << ".sfz\"\n";
+    }
+
+    std::ofstream part;
+    for (int region = 0; region < numRegions; ++region) {
+        if (region % regionsPerFile == 0)
+            part = std::ofstream { directory / "regions" / ("part_" + std::to_string(region / regionsPerFile) + ".sfz") };
+
+        if (region % regionsPerGroup == 0) {
+            part << "// Group " << region / regionsPerGroup << '\n'
+                 << "<group> ampeg_release=0." << region % 9 + 1
+                 << " amplitude_oncc$CC0=100 pan_oncc10=-50\n";
+        }
+
+        const int key = region % 128;
+        const int layer = region / 128 % 8;
+        const int cc = region % includeDepth;
+        part << "<region> sample=samples/" << sampleFiles[region % sampleFiles.size()]
+             << " key=" << key << " lovel=" << layer * 16 + 1 << " hivel=" << layer * 16 + 16
+             << " ampeg_attack_oncc$CC" << cc << "=0.5 ampeg_decay_oncc$CC" << cc << "=1"
+             << " ampeg_sustain_oncc$CC" << (cc + 1) % includeDepth << "=-20"
+             << " ampeg_release_oncc$CC" << (cc + 2) % includeDepth << "=2"
+             << " position_oncc$CC" << (cc + 3) % includeDepth << "=50"
+             << " width_oncc$CC" << (cc + 4) % includeDepth << "=-100\n";
+    }
+
+    const auto root = directory / "instrument.sfz";
+    std::ofstream instrument { root };
+    instrument << "// Synthetic instrument with " << numRegions << " regions\n"
+               << "<control> set_cc20=64 label_cc20=Attack\n"
+               << "<global> volume=-6\n"
+               << "#include \"nesting/level_0.sfz\"\n";
+    return root;
+}
+
+/**
+ * Generates the synthetic instruments on demand in a temporary directory,
+ * which is removed when the benchmarks end.
+ */
+class SyntheticInstruments {
+public:
+  ~SyntheticInstruments() {
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+  }
+
+  std::filesystem::path get(int numRegions) {
+    auto& root = instruments[numRegions];
+    if (root.empty())
+      root = writeSyntheticInstrument(directory / std::to_string(numRegions), numRegions);
+    return root;
+  }
+
+private:
+  std::filesystem::path directory { std::filesystem::temp_directory_path() / "sfizz_bm_loading" };
+  std::map<int, std::filesystem::path> instruments;
+};
+
+SyntheticInstruments syntheticInstruments;
+
+class CountingParser : public sfz::Parser {
+public:
+  int numRegions { 0 };
+protected:
+  void callback(std::string_view header, const std::vector<sfz::Opcode>& /* members */) final {
+    if (header == "region")
+      numRegions++;
+  }
+};
+
+class RecordingParser : public sfz::Parser {
+public:
+  struct Header {
+    std::string_view name;
+    std::vector<sfz::Opcode> members;
+  };
+  std::vector<Header> headers;
+protected:
+  void callback(std::string_view header, const std::vector<sfz::Opcode>& members) final {
+    headers.push_back({ header, members });
+  }
+};
+
+class PeakMemory {
+public:
+  void start() {
+    baseline = heapBytes;
+    peakHeapBytes = baseline;
+  }
+
+  void stop() {
+    peak = std::max(peak, peakHeapBytes - baseline);
+  }
+
+  void report(benchmark::State& state) {
+    state.counters["peakBytes"] = static_cast<double>(peak);
+  }
+
+private:
+  size_t baseline { 0 };
+  size_t peak { 0 };
+};
+}
+
+static void Parse(benchmark::State& state)
+{
+    const auto file = syntheticInstruments.get(static_cast<int>(state.range(0)));
+    PeakMemory memory;
+    for (auto _ : state) {
+        memory.start();
+        CountingParser parser;
+        parser.loadSfzFile(file);
+        benchmark::DoNotOptimize(parser.numRegions);
+        memory.stop();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    memory.report(state);
+}
+
+// Builds the regions from the parsed headers as Synth::buildRegion does
+static void BuildRegions(benchmark::State& state)
+{
+    RecordingParser parser;
+    parser.loadSfzFile(syntheticInstruments.get(static_cast<int>(state.range(0))));
+
+    PeakMemory memory;
+    std::vector<std::unique_ptr<sfz::Region>> regions;
+    for (auto _ : state) {
+        state.PauseTiming();
+        regions.clear();
+        state.ResumeTiming();
+
+        memory.start();
+        const std::vector<sfz::Opcode>* globalOpcodes { nullptr };
+        const std::vector<sfz::Opcode>* masterOpcodes { nullptr };
+        const std::vector<sfz::Opcode>* groupOpcodes { nullptr };
+        for (const auto& header : parser.headers) {
+            if (header.name == "global")
+                globalOpcodes = &header.members;
+            else if (header.name == "master")
+                masterOpcodes = &header.members;
+            else if (header.name == "group")
+                groupOpcodes = &header.members;
+            else if (header.name == "region") {
+                auto region = std::make_unique<sfz::Region>();
+                for (auto opcodes : { globalOpcodes, masterOpcodes, groupOpcodes, &header.members }) {
+                    if (opcodes == nullptr)
+                        continue;
+                    for (auto& opcode : *opcodes)
+                        region->parseOpcode(opcode);
+                }
+                regions.push_back(std::move(region));
+            }
+        }
+        benchmark::DoNotOptimize(regions.data());
+        memory.stop();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    memory.report(state);
+}
+
+// Probes the sample of every region in a fresh file pool, which loads each file once
+static void ProbeSamples(benchmark::State& state)
+{
+    const auto file = syntheticInstruments.get(static_cast<int>(state.range(0)));
+    RecordingParser parser;
+    parser.loadSfzFile(file);
+    std::vector<std::string_view> samples;
+    for (auto& header : parser.headers) {
+        for (auto& opcode : header.members) {
+            if (opcode.opcode == "sample")
+                samples.push_back(opcode.value);
+        }
+    }
+
+    PeakMemory memory;
+    sfz::FilePool filePool;
+    filePool.setRootDirectory(file.parent_path());
+    for (auto _ : state) {
+        state.PauseTiming();
+        filePool.clear();
+        state.ResumeTiming();
+
+        memory.start();
+        for (auto sample : samples)
+            benchmark::DoNotOptimize(filePool.getFileInformation(sample));
+        memory.stop();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * samples.size()));
+    state.counters["preloadedBytes"] = static_cast<double>(filePool.getStatistics().preloadedBytes);
+    memory.report(state);
+}
+
+static void LoadSynth(benchmark::State& state)
+{
+    const auto file = syntheticInstruments.get(static_cast<int>(state.range(0)));
+    PeakMemory memory;
+    sfz::Synth synth;
+    for (auto _ : state) {
+        memory.start();
+        synth.loadSfzFile(file);
+        memory.stop();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    state.counters["regions"] = synth.getNumRegions();
+    memory.report(state);
+}
+
+BENCHMARK(Parse)->Arg(10000)->Arg(50000)->Arg(200000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BuildRegions)->Arg(10000)->Arg(50000)->Arg(200000)->Unit(benchmark::kMillisecond);
+BENCHMARK(ProbeSamples)->Arg(10000)->Arg(50000)->Arg(200000)->Unit(benchmark::kMillisecond);
+BENCHMARK(LoadSynth)->Arg(10000)->Arg(50000)->Arg(200000)->Unit(benchmark::kMillisecond);
+BENCHMARK_MAIN();
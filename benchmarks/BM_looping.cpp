@@ -27,6 +27,7 @@
 #include <numeric>
 #include <absl/algorithm/container.h>
 #include "../sfizz/SIMDHelpers.h"
+#include "SIMDLevels.h"
 
 // In this one we have an array of indices
 
@@ -92,4 +93,4 @@ BENCHMARK_REGISTER_F(LoopingFixture, Scalar)->RangeMultiplier(2)->Range((2<<6),
 BENCHMARK_REGISTER_F(LoopingFixture, SIMD)->RangeMultiplier(2)->Range((2<<6), (2<<12));
 BENCHMARK_REGISTER_F(LoopingFixture, Scalar_Unaligned)->RangeMultiplier(2)->Range((2<<6), (2<<12));
 BENCHMARK_REGISTER_F(LoopingFixture, SIMD_Unaligned)->RangeMultiplier(2)->Range((2<<6), (2<<12));
-BENCHMARK_MAIN();
\ No newline at end of file
+SIMD_BENCHMARK_MAIN()
\ No newline at end of file
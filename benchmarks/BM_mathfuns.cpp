@@ -22,6 +22,7 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../sfizz/SIMDHelpers.h"
+#include "SIMDLevels.h"
 #include "absl/types/span.h"
 #include <benchmark/benchmark.h>
 #include <cmath>
@@ -162,4 +163,4 @@ BENCHMARK_REGISTER_F(MyFixture, SIMDSin)->RangeMultiplier(4)->Range(1 << 6, 1 <<
 BENCHMARK_REGISTER_F(MyFixture, ScalarCos)->RangeMultiplier(4)->Range(1 << 6, 1 << 10);
 BENCHMARK_REGISTER_F(MyFixture, SIMDCos)->RangeMultiplier(4)->Range(1 << 6, 1 << 10);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+SIMD_BENCHMARK_MAIN()
\ No newline at end of file
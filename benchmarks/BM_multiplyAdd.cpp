@@ -28,6 +28,7 @@
 #include <cmath>
 #include <iostream>
 #include "../sfizz/SIMDHelpers.h"
+#include "SIMDLevels.h"
 
 class MultiplyAdd : public benchmark::Fixture {
 public:
@@ -93,4 +94,4 @@ BENCHMARK_REGISTER_F(MultiplyAdd, Scalar)->RangeMultiplier(4)->Range(1 << 2, 1 <
 BENCHMARK_REGISTER_F(MultiplyAdd, SIMD)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
 BENCHMARK_REGISTER_F(MultiplyAdd, Scalar_Unaligned)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
 BENCHMARK_REGISTER_F(MultiplyAdd, SIMD_Unaligned)->RangeMultiplier(4)->Range(1 << 2, 1 << 12);
-BENCHMARK_MAIN();
\ No newline at end of file
+SIMD_BENCHMARK_MAIN()
\ No newline at end of file
@@ -0,0 +1,170 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../sfizz/AudioBuffer.h"
+#include "../sfizz/Config.h"
+#include "../sfizz/Interpolators.h"
+#include "../sfizz/SIMDHelpers.h"
+#include "SIMDLevels.h"
+#include "absl/types/span.h"
+
+// Compares the sample qualities on oversampled preloads, a major third up.
+// The first argument is the sample quality and the second one the oversampling factor.
+// The items per second are the frames rendered per second for one stereo voice, the
+// preloadBytes counter is the memory taken by a preload of config::preloadSize frames,
+// and the errordB counter is the level of the difference with the 32-point sinc on
+// the original data, relative to the signal. The Upsampling benchmark is the cost of
+// oversampling a preload when loading it.
+constexpr int sourceSize { 1 << 16 };
+constexpr int blockSize { 1024 };
+constexpr float jump { 1.26f };
+
+namespace {
+AudioBuffer<float> makeSource()
+{
+    // Partials up to a quarter of the sample rate, which the 32-point sinc reconstructs well
+    std::mt19937 gen { 42 };
+    std::uniform_real_distribution<float> frequencies { 0.0f, 0.25f };
+    std::uniform_real_distribution<float> phases { 0.0f, 6.2831853f };
+    AudioBuffer<float> source { 2, sourceSize };
+    for (int channel = 0; channel < 2; ++channel) {
+        auto frames = source.getSpan(channel);
+        std::fill(frames.begin(), frames.end(), 0.0f);
+        for (int partial = 0; partial < 16; ++partial) {
+            const float omega = 6.2831853f * frequencies(gen);
+            const float phase = phases(gen);
+            for (int i = 0; i < sourceSize; ++i)
+                frames[i] += 0.05f * std::sin(omega * i + phase);
+        }
+    }
+    return source;
+}
+}
+
+class Oversampling : public benchmark::Fixture {
+public:
+  void SetUp(const ::benchmark::State& state) {
+    model = sfz::interpolatorModel(static_cast<int>(state.range(0)));
+    factor = static_cast<int>(state.range(1));
+    const auto original = makeSource();
+    source = std::make_unique<AudioBuffer<float>>(2, sourceSize * factor);
+    sfz::upsample(AudioSpan<const float>(original), AudioSpan<float>(*source), factor);
+
+    sincTable = sfz::getSincTable(model, jump);
+    jumps = std::vector<float>(blockSize, jump * factor);
+    indices = std::vector<int>(blockSize);
+    leftCoeffs = std::vector<float>(blockSize);
+    rightCoeffs = std::vector<float>(blockSize);
+    for (auto& channel : output)
+        channel = std::vector<float>(blockSize);
+
+    // Render the first block against the 32-point sinc on the original data
+    const auto referenceTable = sfz::getSincTable(sfz::InterpolatorModel::Sinc32, jump);
+    std::vector<float> referenceJumps(blockSize, jump);
+    std::vector<float> reference(blockSize);
+    saturatingSFZIndex<float>(referenceJumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), 20.0f, sourceSize - 1);
+    interpolateSinc<float>(indices, rightCoeffs, original.getConstSpan(0), absl::MakeSpan(reference), referenceTable->getCoefficients(), referenceTable->getNumTaps());
+    position = 20.0f * factor;
+    resample<true>();
+    position = 20.0f * factor;
+
+    double signal { 0.0 };
+    double error { 0.0 };
+    for (int i = 0; i < blockSize; ++i) {
+        signal += reference[i] * reference[i];
+        error += (output[0][i] - reference[i]) * (output[0][i] - reference[i]);
+    }
+    errordB = 10.0 * std::log10(error / signal);
+  }
+
+  void TearDown(const ::benchmark::State& state [[maybe_unused]]) {
+
+  }
+
+  template <bool SIMD>
+  void resample() {
+    const auto numFrames = static_cast<int>(source->getNumFrames());
+    position = saturatingSFZIndex<float, SIMD>(jumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), position, numFrames - 1);
+    if (position >= numFrames / 2)
+        position = 20.0f * factor;
+    for (int i = 0; i < 2; ++i) {
+        const auto input = source->getConstSpan(i);
+        switch (model) {
+        case sfz::InterpolatorModel::Linear:
+            interpolateLinear<float, SIMD>(indices, leftCoeffs, rightCoeffs, input, absl::MakeSpan(output[i]));
+            break;
+        case sfz::InterpolatorModel::Hermite:
+            interpolateHermite<float, SIMD>(indices, rightCoeffs, input, absl::MakeSpan(output[i]));
+            break;
+        default:
+            interpolateSinc<float, SIMD>(indices, rightCoeffs, input, absl::MakeSpan(output[i]), sincTable->getCoefficients(), sincTable->getNumTaps());
+            break;
+        }
+    }
+  }
+
+  std::unique_ptr<AudioBuffer<float>> source;
+  std::array<std::vector<float>, 2> output;
+  sfz::InterpolatorModel model;
+  const sfz::SincTable* sincTable;
+  int factor;
+  float position { 20.0f };
+  double errordB { 0.0 };
+  std::vector<float> jumps;
+  std::vector<int> indices;
+  std::vector<float> leftCoeffs;
+  std::vector<float> rightCoeffs;
+};
+
+BENCHMARK_DEFINE_F(Oversampling, Render)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        resample<true>();
+        benchmark::DoNotOptimize(output[1].data());
+    }
+    state.SetItemsProcessed(state.iterations() * blockSize);
+    state.counters["preloadBytes"] = static_cast<double>(sfz::config::preloadSize * 2 * sizeof(float) * factor);
+    state.counters["errordB"] = errordB;
+}
+
+static void Upsampling(benchmark::State& state) {
+    const auto factor = static_cast<int>(state.range(0));
+    const auto original = makeSource();
+    AudioBuffer<float> preload { 2, sfz::config::preloadSize * factor };
+    for (auto _ : state)
+    {
+        sfz::upsample(AudioSpan<const float>(original), AudioSpan<float>(preload), factor);
+        benchmark::DoNotOptimize(preload.channelReader(1));
+    }
+    state.SetItemsProcessed(state.iterations() * sfz::config::preloadSize);
+}
+
+BENCHMARK_REGISTER_F(Oversampling, Render)->ArgsProduct({ { 0, 1, 2, 3, 4 }, { 1, 2, 4 } });
+BENCHMARK(Upsampling)->Arg(2)->Arg(4);
+SIMD_BENCHMARK_MAIN()
@@ -24,6 +24,7 @@
 #include <benchmark/benchmark.h>
 #include <random>
 #include "../sfizz/SIMDHelpers.h"
+#include "SIMDLevels.h"
 #include "../sfizz/Buffer.h"
 
 
@@ -143,4 +144,4 @@ BENCHMARK(MulScalar)->RangeMultiplier(4)->Range((1 << 2), (1 << 12));
 BENCHMARK(MulSIMD)->RangeMultiplier(4)->Range((1 << 2), (1 << 12));
 BENCHMARK(MulScalarUnaligned)->RangeMultiplier(4)->Range((1 << 2), (1 << 12));
 BENCHMARK(MulSIMDUnaligned)->RangeMultiplier(4)->Range((1 << 2), (1 << 12));
-BENCHMARK_MAIN();
\ No newline at end of file
+SIMD_BENCHMARK_MAIN()
\ No newline at end of file
@@ -0,0 +1,115 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "../sfizz/Interpolators.h"
+#include "../sfizz/SIMDHelpers.h"
+#include "SIMDLevels.h"
+#include "absl/types/span.h"
+
+// Resamples a stereo voice block the way the voices do for each sample quality.
+// The first argument is the quality and the second one the pitch ratio in percent;
+// the items per second are the frames rendered per second for one voice.
+constexpr int sourceSize { 1 << 16 };
+constexpr int blockSize { 1024 };
+
+class Resampling : public benchmark::Fixture {
+public:
+  void SetUp(const ::benchmark::State& state) {
+    std::random_device rd { };
+    std::mt19937 gen { rd() };
+    std::uniform_real_distribution<float> dist { -1, 1 };
+    for (auto& channel : source) {
+        channel = std::vector<float>(sourceSize);
+        std::generate(channel.begin(), channel.end(), [&]() { return dist(gen); });
+    }
+
+    model = sfz::interpolatorModel(static_cast<int>(state.range(0)));
+    jump = static_cast<float>(state.range(1)) / 100.0f;
+    sincTable = sfz::getSincTable(model, jump);
+    jumps = std::vector<float>(blockSize, jump);
+    indices = std::vector<int>(blockSize);
+    leftCoeffs = std::vector<float>(blockSize);
+    rightCoeffs = std::vector<float>(blockSize);
+    for (auto& channel : output)
+        channel = std::vector<float>(blockSize);
+  }
+
+  void TearDown(const ::benchmark::State& state [[maybe_unused]]) {
+
+  }
+
+  template <bool SIMD>
+  void resample() {
+    position = saturatingSFZIndex<float, SIMD>(jumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), position, sourceSize - 1);
+    if (position >= sourceSize / 2)
+        position = 20.0f;
+    for (size_t i = 0; i < source.size(); ++i) {
+        switch (model) {
+        case sfz::InterpolatorModel::Linear:
+            interpolateLinear<float, SIMD>(indices, leftCoeffs, rightCoeffs, source[i], absl::MakeSpan(output[i]));
+            break;
+        case sfz::InterpolatorModel::Hermite:
+            interpolateHermite<float, SIMD>(indices, rightCoeffs, source[i], absl::MakeSpan(output[i]));
+            break;
+        default:
+            interpolateSinc<float, SIMD>(indices, rightCoeffs, source[i], absl::MakeSpan(output[i]), sincTable->getCoefficients(), sincTable->getNumTaps());
+            break;
+        }
+    }
+  }
+
+  std::array<std::vector<float>, 2> source;
+  std::array<std::vector<float>, 2> output;
+  sfz::InterpolatorModel model;
+  const sfz::SincTable* sincTable;
+  float jump;
+  float position { 20.0f };
+  std::vector<float> jumps;
+  std::vector<int> indices;
+  std::vector<float> leftCoeffs;
+  std::vector<float> rightCoeffs;
+};
+
+BENCHMARK_DEFINE_F(Resampling, Scalar)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        resample<false>();
+        benchmark::DoNotOptimize(output[1].data());
+    }
+    state.SetItemsProcessed(state.iterations() * blockSize);
+}
+
+BENCHMARK_DEFINE_F(Resampling, SIMD)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        resample<true>();
+        benchmark::DoNotOptimize(output[1].data());
+    }
+    state.SetItemsProcessed(state.iterations() * blockSize);
+}
+
+BENCHMARK_REGISTER_F(Resampling, Scalar)->ArgsProduct({ { 0, 1, 2, 3, 4 }, { 101, 150, 300 } });
+BENCHMARK_REGISTER_F(Resampling, SIMD)->ArgsProduct({ { 0, 1, 2, 3, 4 }, { 101, 150, 300 } });
+SIMD_BENCHMARK_MAIN()
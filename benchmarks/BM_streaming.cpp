@@ -0,0 +1,169 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sndfile.hh>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../sfizz/AudioBuffer.h"
+#include "../sfizz/Synth.h"
+
+// Fires random note storms at an instrument streaming from generated files, and reports
+// how long the voices wait for their first streamed chunk. The first argument is the
+// number of notes per second, and the second one is 1 to render in real time or 0 to
+// render as fast as possible, which saturates the loading threads. The timeToData
+// counters are in microseconds, from the note to its first chunk being in the voice's
+// buffer, and p99Frames is the 99th percentile in frames, to compare with the preload
+// size. MBps is the throughput of the file reads. The generated files are most likely
+// in the page cache; dropping the caches before running measures the disk itself.
+constexpr int numFiles { 32 };
+constexpr int fileDuration { 10 }; // seconds
+constexpr int numChannels { 2 };
+constexpr int bytesPerSample { 2 };
+constexpr int firstKey { 24 };
+constexpr int sampleRate { 48000 };
+constexpr int blockSize { 256 };
+constexpr int numVoices { 64 };
+constexpr double averageNoteDuration { 0.5 }; // seconds
+
+namespace {
+/**
+ * Writes stereo 16-bit files of noise and an instrument playing each of them on its own
+ * key in a temporary directory, which is removed when the benchmarks end.
+ */
+class StreamedInstrument {
+public:
+  ~StreamedInstrument() {
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+  }
+
+  std::filesystem::path get() {
+    if (!root.empty())
+      return root;
+
+    std::filesystem::create_directories(directory);
+    std::mt19937 gen { 42 };
+    std::uniform_real_distribution<float> noise { -0.5f, 0.5f };
+    std::vector<float> chunk(numChannels * sampleRate);
+    std::ofstream instrument { directory / "streamed.sfz" };
+    for (int file = 0; file < numFiles; ++file) {
+      const auto name = "stream_" + std::to_string(file) + ".wav";
+      SndfileHandle sndFile((directory / name).string(), SFM_WRITE, SF_FORMAT_WAV | SF_FORMAT_PCM_16, numChannels, sampleRate);
+      for (int second = 0; second < fileDuration; ++second) {
+        std::generate(chunk.begin(), chunk.end(), [&]() { return noise(gen); });
+        sndFile.writef(chunk.data(), sampleRate);
+      }
+      instrument << "<region> sample=" << name << " key=" << firstKey + file << '\n';
+    }
+    root = directory / "streamed.sfz";
+    return root;
+  }
+
+private:
+  std::filesystem::path directory { std::filesystem::temp_directory_path() / "sfizz_bm_streaming" };
+  std::filesystem::path root;
+};
+
+StreamedInstrument streamedInstrument;
+}
+
+static void NoteStorm(benchmark::State& state)
+{
+    const auto file = streamedInstrument.get();
+    sfz::Synth synth;
+    synth.setSampleRate(sampleRate);
+    synth.setSamplesPerBlock(blockSize);
+    synth.setNumVoices(numVoices);
+    if (!synth.loadSfzFile(file)) {
+        state.SkipWithError("Could not load the instrument");
+        return;
+    }
+
+    const bool realtime = state.range(1) != 0;
+    std::mt19937 gen { 42 };
+    std::poisson_distribution<int> notesPerBlock { static_cast<double>(state.range(0)) * blockSize / sampleRate };
+    std::uniform_int_distribution<int> delays { 0, blockSize - 1 };
+    std::uniform_int_distribution<int> keys { firstKey, firstKey + numFiles - 1 };
+    std::uniform_int_distribution<int> velocities { 1, 127 };
+    std::exponential_distribution<double> durations { 1.0 / averageNoteDuration };
+
+    struct PendingNoteOff {
+        int64_t frame;
+        int key;
+    };
+    std::vector<PendingNoteOff> noteOffs;
+    AudioBuffer<float> buffer { 2, blockSize };
+    const auto blockDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(static_cast<double>(blockSize) / sampleRate));
+    int64_t position { 0 };
+
+    const auto start = std::chrono::steady_clock::now();
+    auto deadline = start;
+    for (auto _ : state) {
+        for (int block = 0; block < sampleRate / blockSize; ++block) {
+            for (int note = notesPerBlock(gen); note > 0; --note) {
+                const int delay = delays(gen);
+                const int key = keys(gen);
+                synth.noteOn(delay, 1, key, static_cast<uint8_t>(velocities(gen)));
+                noteOffs.push_back({ position + delay + static_cast<int64_t>(durations(gen) * sampleRate), key });
+            }
+
+            auto due = std::partition(noteOffs.begin(), noteOffs.end(), [&](const PendingNoteOff& noteOff) {
+                return noteOff.frame >= position + blockSize;
+            });
+            for (auto noteOff = due; noteOff < noteOffs.end(); ++noteOff)
+                synth.noteOff(static_cast<int>(std::max<int64_t>(noteOff->frame - position, 0)), 1, noteOff->key, 0);
+            noteOffs.erase(due, noteOffs.end());
+
+            synth.renderBlock(buffer);
+            position += blockSize;
+            if (realtime) {
+                deadline += blockDuration;
+                std::this_thread::sleep_until(deadline);
+            }
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const auto statistics = synth.getFilePoolStatistics();
+    const auto& timeToData = statistics.timeToData;
+    state.counters["notes"] = static_cast<double>(timeToData.count);
+    state.counters["timeToData_p50"] = static_cast<double>(timeToData.p50.count());
+    state.counters["timeToData_p99"] = static_cast<double>(timeToData.p99.count());
+    state.counters["timeToData_max"] = static_cast<double>(timeToData.max.count());
+    state.counters["queue_p99"] = static_cast<double>(statistics.queueLatency.p99.count());
+    state.counters["read_p99"] = static_cast<double>(statistics.readLatency.p99.count());
+    state.counters["p99Frames"] = timeToData.p99.count() * 1e-6 * sampleRate;
+    state.counters["MBps"] = static_cast<double>(statistics.streamedSamples) * bytesPerSample / elapsed.count() * 1e-6;
+}
+
+// Each iteration is a second of audio
+BENCHMARK(NoteStorm)->Args({ 20, 1 })->Args({ 100, 1 })->Args({ 500, 1 })->Args({ 100, 0 })->Args({ 500, 0 })->Iterations(5)->Unit(benchmark::kMillisecond);
+BENCHMARK_MAIN();
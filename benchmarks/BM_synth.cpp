@@ -0,0 +1,188 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include "../sfizz/AudioBuffer.h"
+#include "../sfizz/Config.h"
+#include "../sfizz/Region.h"
+#include "../sfizz/Synth.h"
+#include "SIMDLevels.h"
+
+// Renders whole blocks through the synth with the instruments of tests/TestFiles.
+// The first argument is the block size and the second one the number of notes played.
+// The nsPerVoiceFrame counter is the time spent in the synth divided by the frames
+// rendered by each active voice, and the items per second are the frames rendered per
+// second. The notes are restarted before leaving the preloaded part of their samples,
+// so that the loading threads do not take part in the measurement.
+constexpr int chordPeriod { static_cast<int>(sfz::config::preloadSize) / 2 };
+constexpr int repeatPeriod { 1024 };
+constexpr int ccEventsPerBlock { 8 };
+
+class SynthFixture : public benchmark::Fixture {
+public:
+  void SetUp(const ::benchmark::State& state) {
+    blockSize = static_cast<int>(state.range(0));
+    numNotes = static_cast<int>(state.range(1));
+    buffer = std::make_unique<AudioBuffer<float>>(2, blockSize);
+    synth = std::make_unique<sfz::Synth>();
+    synth->setSamplesPerBlock(blockSize);
+    // Leave room for the voices releasing when their note is restarted
+    synth->setNumVoices(2 * numNotes);
+    elapsed = std::chrono::nanoseconds::zero();
+    voiceFrames = 0;
+  }
+
+  void TearDown(const ::benchmark::State& /* state */) {
+    synth.reset();
+    buffer.reset();
+  }
+
+  bool load(benchmark::State& state, const char* file) {
+    if (!synth->loadSfzFile(std::filesystem::path(SFIZZ_TEST_FILES) / file)
+        || synth->getNumRegions() == 0) {
+      state.SkipWithError("Could not load the instrument");
+      return false;
+    }
+
+    // Spread the notes over the regions, and over the keys of each region
+    notes.clear();
+    const int numRegions = synth->getNumRegions();
+    for (int i = 0; i < numNotes; ++i) {
+      const auto region = synth->getRegionView(i % numRegions);
+      const int numKeys = region->keyRange.getEnd() - region->keyRange.getStart() + 1;
+      const int key = region->keyRange.getStart() + (i / numRegions) % numKeys;
+      notes.push_back({ static_cast<uint8_t>(key), std::max<uint8_t>(region->velocityRange.getEnd(), 1) });
+    }
+    return true;
+  }
+
+  // Restarts every note once per period, from a phase spread over the period when
+  // staggered. The notes are all released before being triggered again, since
+  // releasing a key also releases the notes just triggered on the same key.
+  void restartNotes(int64_t position, int period, bool staggered) {
+    for (bool triggering : { false, true }) {
+      for (int i = 0; i < numNotes; ++i) {
+        const int64_t phase = staggered ? static_cast<int64_t>(i) * period / numNotes : 0;
+        for (int64_t frame = position + ((phase - position) % period + period) % period;
+             frame < position + blockSize; frame += period) {
+          const int delay = static_cast<int>(frame - position);
+          if (triggering)
+            synth->noteOn(delay, 1, notes[i].key, notes[i].velocity);
+          else
+            synth->noteOff(delay, 1, notes[i].key, 0);
+        }
+      }
+    }
+  }
+
+  void sweepControllers(int64_t position) {
+    for (int i = 0; i < ccEventsPerBlock; ++i) {
+      const int delay = i * blockSize / ccEventsPerBlock;
+      const auto value = static_cast<uint8_t>((position / blockSize * ccEventsPerBlock + i) % 128);
+      synth->cc(delay, 1, 1, value);
+      synth->cc(delay, 1, 10, 127 - value);
+    }
+  }
+
+  template<class Events>
+  void run(benchmark::State& state, Events&& events) {
+    int64_t position { 0 };
+    for (auto _ : state) {
+      const auto start = std::chrono::steady_clock::now();
+      events(position);
+      synth->renderBlock(*buffer);
+      elapsed += std::chrono::steady_clock::now() - start;
+      voiceFrames += synth->getNumActiveVoices() * blockSize;
+      position += blockSize;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * blockSize);
+    if (voiceFrames > 0)
+      state.counters["nsPerVoiceFrame"] = static_cast<double>(elapsed.count()) / voiceFrames;
+  }
+
+  void chord(benchmark::State& state, const char* file) {
+    if (!load(state, file))
+      return;
+    run(state, [&](int64_t position) { restartNotes(position, chordPeriod, false); });
+  }
+
+  void repeatedNotes(benchmark::State& state, const char* file) {
+    if (!load(state, file))
+      return;
+    run(state, [&](int64_t position) { restartNotes(position, repeatPeriod, true); });
+  }
+
+  void controllerSweep(benchmark::State& state, const char* file) {
+    if (!load(state, file))
+      return;
+    run(state, [&](int64_t position) {
+      restartNotes(position, chordPeriod, false);
+      sweepControllers(position);
+    });
+  }
+
+  struct Note {
+    uint8_t key;
+    uint8_t velocity;
+  };
+  int blockSize { 0 };
+  int numNotes { 0 };
+  std::unique_ptr<sfz::Synth> synth;
+  std::unique_ptr<AudioBuffer<float>> buffer;
+  std::vector<Note> notes;
+  std::chrono::nanoseconds elapsed { 0 };
+  int64_t voiceFrames { 0 };
+};
+
+BENCHMARK_DEFINE_F(SynthFixture, Chord_Sine)(benchmark::State& state) {
+  chord(state, "sine_release.sfz");
+}
+
+BENCHMARK_DEFINE_F(SynthFixture, Chord_Samples)(benchmark::State& state) {
+  chord(state, "sample_quality.sfz");
+}
+
+BENCHMARK_DEFINE_F(SynthFixture, ControllerSweep_Sine)(benchmark::State& state) {
+  controllerSweep(state, "sine_cc.sfz");
+}
+
+BENCHMARK_DEFINE_F(SynthFixture, RepeatedNotes_Sine)(benchmark::State& state) {
+  repeatedNotes(state, "sine_release.sfz");
+}
+
+BENCHMARK_DEFINE_F(SynthFixture, RepeatedNotes_Samples)(benchmark::State& state) {
+  repeatedNotes(state, "groups_avl.sfz");
+}
+
+BENCHMARK_REGISTER_F(SynthFixture, Chord_Sine)->ArgsProduct({ { 64, 256, 1024 }, { 1, 8, 64 } });
+BENCHMARK_REGISTER_F(SynthFixture, Chord_Samples)->ArgsProduct({ { 64, 256, 1024 }, { 1, 8, 64 } });
+BENCHMARK_REGISTER_F(SynthFixture, ControllerSweep_Sine)->ArgsProduct({ { 64, 256, 1024 }, { 1, 8, 64 } });
+BENCHMARK_REGISTER_F(SynthFixture, RepeatedNotes_Sine)->ArgsProduct({ { 64, 256, 1024 }, { 1, 8, 64 } });
+BENCHMARK_REGISTER_F(SynthFixture, RepeatedNotes_Samples)->ArgsProduct({ { 64, 256, 1024 }, { 1, 8, 64 } });
+SIMD_BENCHMARK_MAIN()
@@ -0,0 +1,179 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "../sfizz/SIMDHelpers.h"
+#include "absl/types/span.h"
+
+// Compares the voice output stage as a chain of block operations with the fused kernels
+class VoiceKernel : public benchmark::Fixture {
+public:
+  void SetUp(const ::benchmark::State& state) {
+    std::random_device rd { };
+    std::mt19937 gen { rd() };
+    std::uniform_real_distribution<float> gainDist { 0, 1 };
+    std::uniform_real_distribution<float> signedDist { -1, 1 };
+    const auto size = static_cast<size_t>(state.range(0));
+    for (auto* envelope : { &amplitude, &eg, &volume })
+        *envelope = std::vector<float>(size);
+    for (auto* envelope : { &pan, &width, &position, &left, &right })
+        *envelope = std::vector<float>(size);
+    std::generate(amplitude.begin(), amplitude.end(), [&]() { return gainDist(gen); });
+    std::generate(eg.begin(), eg.end(), [&]() { return gainDist(gen); });
+    std::generate(volume.begin(), volume.end(), [&]() { return gainDist(gen); });
+    std::generate(pan.begin(), pan.end(), [&]() { return signedDist(gen); });
+    std::generate(width.begin(), width.end(), [&]() { return signedDist(gen); });
+    std::generate(position.begin(), position.end(), [&]() { return signedDist(gen); });
+    std::generate(left.begin(), left.end(), [&]() { return signedDist(gen); });
+    std::generate(right.begin(), right.end(), [&]() { return signedDist(gen); });
+    temp1 = std::vector<float>(size);
+    temp2 = std::vector<float>(size);
+    temp3 = std::vector<float>(size);
+  }
+
+  void TearDown(const ::benchmark::State& state [[maybe_unused]]) {
+
+  }
+
+  void combinedGain(absl::Span<float> gain) {
+    copy<float>(amplitude, gain);
+    applyGain<float>(eg, gain);
+    applyGain<float>(volume, gain);
+  }
+
+  std::vector<float> amplitude;
+  std::vector<float> eg;
+  std::vector<float> volume;
+  std::vector<float> pan;
+  std::vector<float> width;
+  std::vector<float> position;
+  std::vector<float> left;
+  std::vector<float> right;
+  std::vector<float> temp1;
+  std::vector<float> temp2;
+  std::vector<float> temp3;
+};
+
+BENCHMARK_DEFINE_F(VoiceKernel, Mono_BlockOps)(benchmark::State& state) {
+    auto leftBuffer = absl::MakeSpan(left);
+    auto rightBuffer = absl::MakeSpan(right);
+    auto span1 = absl::MakeSpan(temp1);
+    auto span2 = absl::MakeSpan(temp2);
+    for (auto _ : state)
+    {
+        applyGain<float>(amplitude, leftBuffer);
+        applyGain<float>(eg, leftBuffer);
+        applyGain<float>(volume, leftBuffer);
+        copy<float>(leftBuffer, rightBuffer);
+        copy<float>(pan, span1);
+        fill<float>(span2, 1.0f);
+        add<float>(span1, span2);
+        applyGain<float>(piFour<float>, span2);
+        cos<float>(span2, span1);
+        sin<float>(span2, span2);
+        applyGain<float>(span1, leftBuffer);
+        applyGain<float>(span2, rightBuffer);
+    }
+}
+
+BENCHMARK_DEFINE_F(VoiceKernel, Mono_Fused_Scalar)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        combinedGain(absl::MakeSpan(temp1));
+        panMono<float, false>(temp1, pan, absl::MakeSpan(left), absl::MakeSpan(right));
+    }
+}
+
+BENCHMARK_DEFINE_F(VoiceKernel, Mono_Fused_SIMD)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        combinedGain(absl::MakeSpan(temp1));
+        panMono<float, true>(temp1, pan, absl::MakeSpan(left), absl::MakeSpan(right));
+    }
+}
+
+BENCHMARK_DEFINE_F(VoiceKernel, Stereo_BlockOps)(benchmark::State& state) {
+    auto leftBuffer = absl::MakeSpan(left);
+    auto rightBuffer = absl::MakeSpan(right);
+    auto span1 = absl::MakeSpan(temp1);
+    auto span2 = absl::MakeSpan(temp2);
+    auto span3 = absl::MakeSpan(temp3);
+    for (auto _ : state)
+    {
+        for (auto* envelope : { &amplitude, &eg, &volume }) {
+            applyGain<float>(*envelope, leftBuffer);
+            applyGain<float>(*envelope, rightBuffer);
+        }
+        copy<float>(rightBuffer, span1);
+        add<float>(leftBuffer, rightBuffer);
+        subtract<float>(span1, leftBuffer);
+        applyGain<float>(sqrtTwoInv<float>, leftBuffer);
+        applyGain<float>(sqrtTwoInv<float>, rightBuffer);
+        copy<float>(width, span1);
+        fill<float>(span2, 1.0f);
+        add<float>(span1, span2);
+        applyGain<float>(piFour<float>, span2);
+        cos<float>(span2, span1);
+        sin<float>(span2, span2);
+        applyGain<float>(span1, leftBuffer);
+        applyGain<float>(span2, rightBuffer);
+        copy<float>(position, span1);
+        fill<float>(span2, 1.0f);
+        add<float>(span1, span2);
+        applyGain<float>(piFour<float>, span2);
+        cos<float>(span2, span1);
+        sin<float>(span2, span2);
+        copy<float>(leftBuffer, span3);
+        copy<float>(rightBuffer, leftBuffer);
+        multiplyAdd<float>(span1, span3, leftBuffer);
+        multiplyAdd<float>(span2, span3, rightBuffer);
+        applyGain<float>(sqrtTwoInv<float>, leftBuffer);
+        applyGain<float>(sqrtTwoInv<float>, rightBuffer);
+    }
+}
+
+BENCHMARK_DEFINE_F(VoiceKernel, Stereo_Fused_Scalar)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        combinedGain(absl::MakeSpan(temp1));
+        widthPosition<float, false>(temp1, width, position, absl::MakeSpan(left), absl::MakeSpan(right));
+    }
+}
+
+BENCHMARK_DEFINE_F(VoiceKernel, Stereo_Fused_SIMD)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        combinedGain(absl::MakeSpan(temp1));
+        widthPosition<float, true>(temp1, width, position, absl::MakeSpan(left), absl::MakeSpan(right));
+    }
+}
+
+BENCHMARK_REGISTER_F(VoiceKernel, Mono_BlockOps)->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+BENCHMARK_REGISTER_F(VoiceKernel, Mono_Fused_Scalar)->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+BENCHMARK_REGISTER_F(VoiceKernel, Mono_Fused_SIMD)->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+BENCHMARK_REGISTER_F(VoiceKernel, Stereo_BlockOps)->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+BENCHMARK_REGISTER_F(VoiceKernel, Stereo_Fused_Scalar)->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+BENCHMARK_REGISTER_F(VoiceKernel, Stereo_Fused_SIMD)->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+BENCHMARK_MAIN();
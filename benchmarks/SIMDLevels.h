@@ -0,0 +1,71 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "../sfizz/SIMDHelpers.h"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <iostream>
+
+/**
+ * Replaces BENCHMARK_MAIN() in the benchmarks of the SIMD helpers that are dispatched at
+ * runtime, and adds a --simd=baseline|avx2|avx512 option to compare the instruction sets.
+ * The default is the best one that the CPU supports.
+ */
+inline void consumeSIMDLevelArgument(int& argc, char** argv)
+{
+    constexpr const char* option = "--simd=";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], option, std::strlen(option)) != 0)
+            continue;
+
+        const char* value = argv[i] + std::strlen(option);
+        if (std::strcmp(value, "baseline") == 0)
+            setSIMDLevel(SIMDLevel::Baseline);
+        else if (std::strcmp(value, "avx2") == 0)
+            setSIMDLevel(SIMDLevel::AVX2);
+        else if (std::strcmp(value, "avx512") == 0)
+            setSIMDLevel(SIMDLevel::AVX512);
+        else
+            std::cerr << "Unknown SIMD level " << value << '\n';
+
+        for (int j = i; j < argc - 1; ++j)
+            argv[j] = argv[j + 1];
+        --argc;
+        --i;
+    }
+
+    constexpr const char* names[] = { "baseline", "avx2", "avx512" };
+    std::cout << "SIMD level: " << names[static_cast<int>(getSIMDLevel())] << '\n';
+}
+
+#define SIMD_BENCHMARK_MAIN()                                       \
+    int main(int argc, char** argv)                                 \
+    {                                                               \
+        consumeSIMDLevelArgument(argc, argv);                       \
+        ::benchmark::Initialize(&argc, argv);                       \
+        if (::benchmark::ReportUnrecognizedArguments(argc, argv))   \
+            return 1;                                               \
+        ::benchmark::RunSpecifiedBenchmarks();                      \
+        return 0;                                                   \
+    }
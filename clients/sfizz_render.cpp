@@ -0,0 +1,344 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "AudioBuffer.h"
+#include "Buffer.h"
+#include "SIMDHelpers.h"
+#include "Synth.h"
+#include <absl/flags/flag.h>
+#include <absl/flags/parse.h>
+#include <absl/flags/usage.h>
+#include <absl/types/span.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <sndfile.hh>
+#include <string_view>
+#include <vector>
+
+ABSL_FLAG(int, blocksize, 1024, "Frames rendered per block");
+ABSL_FLAG(int, samplerate, 48000, "Output sample rate");
+ABSL_FLAG(int, quality, sfz::config::defaultSampleQuality, "Sample quality, from 0 (linear) to 4 (32-point sinc)");
+ABSL_FLAG(int, oversampling, sfz::config::defaultOversamplingFactor, "Oversampling factor of the preloaded data");
+ABSL_FLAG(int, polyphony, sfz::config::numVoices, "Maximum number of voices playing at once");
+ABSL_FLAG(int, render_threads, 0, "Threads rendering the voices besides the main one");
+ABSL_FLAG(double, tail, 10.0, "Maximum seconds rendered after the last event while voices still play");
+ABSL_FLAG(bool, wait_for_data, true, "Wait for the samples to stream instead of rendering gaps when the loading threads fall behind");
+
+namespace midi {
+constexpr uint8_t statusMask { 0b11110000 };
+constexpr uint8_t channelMask { 0b00001111 };
+constexpr uint8_t noteOff { 0x80 };
+constexpr uint8_t noteOn { 0x90 };
+constexpr uint8_t polyphonicPressure { 0xA0 };
+constexpr uint8_t controlChange { 0xB0 };
+constexpr uint8_t programChange { 0xC0 };
+constexpr uint8_t channelPressure { 0xD0 };
+constexpr uint8_t pitchBend { 0xE0 };
+constexpr uint8_t systemMessage { 0xF0 };
+constexpr uint8_t sysEx { 0xF0 };
+constexpr uint8_t sysExEscape { 0xF7 };
+constexpr uint8_t meta { 0xFF };
+constexpr uint8_t metaEndOfTrack { 0x2F };
+constexpr uint8_t metaTempo { 0x51 };
+constexpr int defaultMicrosecondsPerQuarter { 500000 };
+
+constexpr uint8_t status(uint8_t midiStatusByte)
+{
+    return midiStatusByte & statusMask;
+}
+constexpr uint8_t channel(uint8_t midiStatusByte)
+{
+    return midiStatusByte & channelMask;
+}
+constexpr int dataBytes(uint8_t midiStatusByte)
+{
+    const auto type = status(midiStatusByte);
+    return (type == programChange || type == channelPressure) ? 1 : 2;
+}
+
+struct Event {
+    uint64_t tick;
+    uint8_t status; // meta for the tempo changes
+    uint8_t data1;
+    uint8_t data2;
+    int microsecondsPerQuarter;
+    double time { 0.0 }; // seconds
+};
+
+/**
+ * Reads the channel and tempo events of a Standard MIDI File, merged across the tracks
+ * and sorted by time. Returns nothing if the file is not a valid MIDI file.
+ */
+std::optional<std::vector<Event>> readFile(const std::filesystem::path& file)
+{
+    std::ifstream stream { file, std::ios::binary };
+    if (!stream)
+        return {};
+    const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+
+    size_t position { 0 };
+    auto readBigEndian = [&](int numBytes, uint32_t& value) {
+        if (position + numBytes > bytes.size())
+            return false;
+        value = 0;
+        for (int i = 0; i < numBytes; ++i)
+            value = (value << 8) | bytes[position++];
+        return true;
+    };
+    auto readVariableLength = [&](size_t end, uint32_t& value) {
+        value = 0;
+        for (int i = 0; i < 4 && position < end; ++i) {
+            const auto byte = bytes[position++];
+            value = (value << 7) | (byte & 0x7F);
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    };
+    auto isChunk = [&](std::string_view name) {
+        return position + 4 <= bytes.size() && std::equal(name.begin(), name.end(), bytes.begin() + position);
+    };
+
+    uint32_t headerLength, format, numTracks, division;
+    if (!isChunk("MThd"))
+        return {};
+    position += 4;
+    if (!readBigEndian(4, headerLength) || headerLength < 6
+        || !readBigEndian(2, format) || !readBigEndian(2, numTracks) || !readBigEndian(2, division))
+        return {};
+    position += headerLength - 6;
+    if (format > 2 || division == 0)
+        return {};
+
+    std::vector<Event> events;
+    for (uint32_t track = 0; track < numTracks && position + 8 <= bytes.size(); ++track) {
+        const bool isTrack = isChunk("MTrk");
+        uint32_t chunkLength;
+        position += 4;
+        readBigEndian(4, chunkLength);
+        const auto end = std::min(bytes.size(), position + chunkLength);
+        if (!isTrack) {
+            track--;
+            position = end;
+            continue;
+        }
+
+        uint64_t tick { 0 };
+        uint8_t runningStatus { 0 };
+        while (position < end) {
+            uint32_t deltaTicks;
+            if (!readVariableLength(end, deltaTicks) || position >= end)
+                return {};
+            tick += deltaTicks;
+
+            auto statusByte = bytes[position];
+            if (statusByte & 0x80)
+                position++;
+            else if (runningStatus != 0)
+                statusByte = runningStatus;
+            else
+                return {};
+
+            uint32_t length;
+            if (statusByte == meta) {
+                if (position >= end)
+                    return {};
+                const auto type = bytes[position++];
+                if (!readVariableLength(end, length) || position + length > end)
+                    return {};
+                if (type == metaTempo && length == 3) {
+                    const auto microseconds = (bytes[position] << 16) | (bytes[position + 1] << 8) | bytes[position + 2];
+                    events.push_back({ tick, meta, 0, 0, microseconds });
+                }
+                position += length;
+                if (type == metaEndOfTrack)
+                    break;
+            } else if (statusByte == sysEx || statusByte == sysExEscape) {
+                if (!readVariableLength(end, length) || position + length > end)
+                    return {};
+                position += length;
+            } else if (status(statusByte) != systemMessage) {
+                runningStatus = statusByte;
+                const int numDataBytes = dataBytes(statusByte);
+                if (position + numDataBytes > end)
+                    return {};
+                const uint8_t data1 = bytes[position];
+                const uint8_t data2 = numDataBytes > 1 ? bytes[position + 1] : 0;
+                position += numDataBytes;
+                events.push_back({ tick, statusByte, data1, data2, 0 });
+            } else {
+                // Other system messages have no place in a file
+                return {};
+            }
+        }
+        position = end;
+    }
+
+    // Merges the tracks, since the tempo changes of the first one apply to all of them
+    std::stable_sort(events.begin(), events.end(), [](const Event& lhs, const Event& rhs) { return lhs.tick < rhs.tick; });
+
+    const bool smpte = (division & 0x8000) != 0;
+    const double ticksPerQuarter = division;
+    const double ticksPerSecond = smpte ? (256 - (division >> 8)) * static_cast<double>(division & 0xFF) : 0.0;
+    int microsecondsPerQuarter { defaultMicrosecondsPerQuarter };
+    uint64_t lastTick { 0 };
+    double lastTime { 0.0 };
+    for (auto& event : events) {
+        const auto elapsedTicks = static_cast<double>(event.tick - lastTick);
+        event.time = lastTime + (smpte ? elapsedTicks / ticksPerSecond : elapsedTicks * microsecondsPerQuarter * 1e-6 / ticksPerQuarter);
+        lastTick = event.tick;
+        lastTime = event.time;
+        if (event.status == meta)
+            microsecondsPerQuarter = event.microsecondsPerQuarter;
+    }
+
+    return events;
+}
+}
+
+void dispatch(sfz::Synth& synth, const midi::Event& event, int delay)
+{
+    const int channel = midi::channel(event.status) + 1;
+    switch (midi::status(event.status)) {
+    case midi::noteOff:
+        synth.noteOff(delay, channel, event.data1, event.data2);
+        break;
+    case midi::noteOn:
+        if (event.data2 == 0)
+            synth.noteOff(delay, channel, event.data1, 0);
+        else
+            synth.noteOn(delay, channel, event.data1, event.data2);
+        break;
+    case midi::controlChange:
+        synth.cc(delay, channel, event.data1, event.data2);
+        break;
+    case midi::channelPressure:
+        synth.aftertouch(delay, channel, event.data1);
+        break;
+    case midi::pitchBend:
+        synth.pitchWheel(delay, channel, ((event.data2 << 7) | event.data1) - 8192);
+        break;
+    case midi::systemMessage:
+        // The tempo changes are the only meta events kept
+        synth.tempo(delay, static_cast<float>(event.microsecondsPerQuarter * 1e-6));
+        break;
+    case midi::polyphonicPressure:
+    case midi::programChange:
+        break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    absl::SetProgramUsageMessage("Renders a MIDI file through an sfz instrument into an audio file.\n"
+                                 "Usage: sfizz_render [options] instrument.sfz song.mid output.wav|output.flac");
+    auto arguments = absl::ParseCommandLine(argc, argv);
+    if (arguments.size() != 4) {
+        std::cerr << absl::ProgramUsageMessage() << '\n';
+        return 1;
+    }
+
+    const std::filesystem::path sfzFile { arguments[1] };
+    const std::filesystem::path midiFile { arguments[2] };
+    const std::filesystem::path outputFile { arguments[3] };
+    const int blockSize = std::max(1, absl::GetFlag(FLAGS_blocksize));
+    const int sampleRate = std::max(1, absl::GetFlag(FLAGS_samplerate));
+
+    // WAV files keep the floating-point output, FLAC files hold integers
+    int format;
+    if (outputFile.extension() == ".wav") {
+        format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+    } else if (outputFile.extension() == ".flac") {
+        format = SF_FORMAT_FLAC | SF_FORMAT_PCM_24;
+    } else {
+        std::cerr << "Unsupported output format " << outputFile.extension() << ", use .wav or .flac" << '\n';
+        return 1;
+    }
+
+    auto events = midi::readFile(midiFile);
+    if (!events) {
+        std::cerr << "Could not read the MIDI file " << midiFile << '\n';
+        return 1;
+    }
+
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.setSampleRate(static_cast<float>(sampleRate));
+    synth.setSampleQuality(absl::GetFlag(FLAGS_quality));
+    synth.setOversamplingFactor(absl::GetFlag(FLAGS_oversampling));
+    synth.setNumVoices(absl::GetFlag(FLAGS_polyphony));
+    // Nothing waits for the blocks here, so the threads need not be realtime
+    synth.setNumRenderThreads(std::max(0, absl::GetFlag(FLAGS_render_threads)), false);
+    synth.setFreewheeling(absl::GetFlag(FLAGS_wait_for_data));
+    if (!synth.loadSfzFile(sfzFile)) {
+        std::cerr << "Could not load the instrument " << sfzFile << '\n';
+        return 1;
+    }
+
+    SndfileHandle output { outputFile.string(), SFM_WRITE, format, sfz::config::numChannels, sampleRate };
+    if (output.error() != 0) {
+        std::cerr << "Could not open " << outputFile << " for writing: " << output.strError() << '\n';
+        return 1;
+    }
+
+    AudioBuffer<float> buffer { sfz::config::numChannels, blockSize };
+    Buffer<float> interleavedBuffer { static_cast<size_t>(sfz::config::numChannels * blockSize) };
+    const auto toFrames = [sampleRate](double seconds) { return static_cast<uint64_t>(std::llround(seconds * sampleRate)); };
+    const uint64_t lastEventFrame = events->empty() ? 0 : toFrames(events->back().time);
+    const uint64_t endFrame = lastEventFrame + toFrames(std::max(0.0, absl::GetFlag(FLAGS_tail)));
+
+    const auto start = std::chrono::steady_clock::now();
+    auto event = events->begin();
+    uint64_t blockStart { 0 };
+    while (event != events->end() || (blockStart < endFrame && synth.getNumActiveVoices() > 0)) {
+        const uint64_t blockEnd = blockStart + blockSize;
+        for (; event != events->end() && toFrames(event->time) < blockEnd; ++event)
+            dispatch(synth, *event, static_cast<int>(toFrames(event->time) - blockStart));
+
+        synth.renderBlock(buffer);
+        ::writeInterleaved<float>(buffer.getConstSpan(0), buffer.getConstSpan(1), absl::MakeSpan(interleavedBuffer));
+        output.writef(interleavedBuffer.data(), blockSize);
+        blockStart = blockEnd;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double renderedSeconds = static_cast<double>(blockStart) / sampleRate;
+    std::cout << "Rendered " << renderedSeconds << " s of audio in " << elapsed.count() << " s"
+              << " (realtime factor " << renderedSeconds / std::max(elapsed.count(), 1e-9) << ")" << '\n';
+    const auto statistics = synth.getFilePoolStatistics();
+    if (statistics.fallbacks > 0)
+        std::cout << statistics.fallbacks << " voices started without their preloaded data" << '\n';
+    if (statistics.missingStreamingBuffers > 0)
+        std::cout << statistics.missingStreamingBuffers << " voices cut short for want of a streaming buffer" << '\n';
+    if (statistics.droppedLoads > 0)
+        std::cout << statistics.droppedLoads << " streams or preload reloads dropped on full loading queues" << '\n';
+    if (synth.getNumDroppedNotes() > 0)
+        std::cout << synth.getNumDroppedNotes() << " notes dropped with every voice fading out" << '\n';
+    return 0;
+}
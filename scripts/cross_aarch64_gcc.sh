@@ -0,0 +1,3 @@
+#!/bin/sh
+script_dir="$(dirname "$0")"
+cmake -D CMAKE_SYSTEM_NAME=Linux -D CMAKE_SYSTEM_PROCESSOR=aarch64 -D CMAKE_C_COMPILER=aarch64-linux-gnu-gcc -D CMAKE_CXX_COMPILER=aarch64-linux-gnu-g++ -D CMAKE_CROSSCOMPILING_EMULATOR="qemu-aarch64;-L;/usr/aarch64-linux-gnu" -D CMAKE_BUILD_TYPE=Release -D SFIZZ_TESTS=ON -S "$script_dir/.." -B .
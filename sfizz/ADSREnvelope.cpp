@@ -224,4 +224,12 @@ void ADSREnvelope<Type>::startRelease(int releaseDelay) noexcept
     this->releaseDelay = releaseDelay;
 }
 
+template <class Type>
+void ADSREnvelope<Type>::startFastRelease(int releaseDelay, int releaseDuration) noexcept
+{
+    // Before the release this is its programmed length, and during it the remaining length
+    release = std::min(release, releaseDuration);
+    startRelease(releaseDelay);
+}
+
 }
@@ -34,6 +34,11 @@ public:
     Type getNextValue() noexcept;
     void getBlock(absl::Span<Type> output) noexcept;
     void startRelease(int releaseDelay) noexcept;
+    /**
+     * Starts a release shorter than the programmed one, e.g. to cut a voice without clicking.
+     */
+    void startFastRelease(int releaseDelay, int releaseDuration) noexcept;
+    Type getCurrentValue() const noexcept { return currentValue; }
     bool isSmoothing() noexcept;
 
 private:
@@ -73,6 +73,7 @@ public:
             *thisSpan = newSpan->data();
             size = std::min(size, newSpan->size());
         }
+        numFrames = size;
     }
 
     template <class U, unsigned int N, unsigned int Alignment, typename = std::enable_if<N <= MaxChannels>>
@@ -88,6 +89,16 @@ public:
         }
     }
 
+    template <class U, unsigned int N, unsigned int Alignment, typename = std::enable_if<N <= MaxChannels>>
+    AudioSpan(const AudioBuffer<U, N, Alignment>& audioBuffer)
+        : numFrames(audioBuffer.getNumFrames())
+        , numChannels(audioBuffer.getNumChannels())
+    {
+        static_assert(std::is_const<Type>::value, "A span on a const buffer must be const");
+        for (int i = 0; i < numChannels; i++)
+            this->spans[i] = audioBuffer.channelReader(i);
+    }
+
     template <class U, unsigned int N, typename = std::enable_if<N <= MaxChannels>>
     AudioSpan(const AudioSpan<U, N>& other)
         : numFrames(other.getNumFrames())
@@ -163,12 +174,12 @@ public:
         }
     }
 
-    size_type getNumFrames()
+    size_type getNumFrames() const
     {
         return numFrames;
     }
 
-    int getNumChannels()
+    int getNumChannels() const
     {
         return numChannels;
     }
@@ -191,6 +202,12 @@ public:
         return { spans, numChannels, offset, length };
     }
 
+    AudioSpan<Type> subspan(size_type offset)
+    {
+        ASSERT(offset <= numFrames);
+        return { spans, numChannels, offset, numFrames - offset };
+    }
+
 private:
     std::array<Type*, MaxChannels> spans;
     size_type numFrames { 0 };
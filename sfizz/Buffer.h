@@ -23,7 +23,9 @@
 
 #pragma once
 #include "Config.h"
+#include "Debug.h"
 #include "LeakDetector.h"
+#include "RealtimeChecks.h"
 #include <cstdlib>
 #include <cstring>
 #include <memory>
@@ -58,6 +60,7 @@ public:
             return true;
         }
 
+        ASSERT(!sfz::ScopedRealtimeSection::isActive());
         auto tempSize = newSize + 2 * AlignmentMask; // To ensure that we have leeway at the beginning and at the end
         auto* newData = paddedData != nullptr ? std::realloc(paddedData, tempSize * sizeof(value_type)) : std::malloc(tempSize * sizeof(value_type));
         if (newData == nullptr) {
@@ -79,15 +82,18 @@ public:
 
     void clear()
     {
+        ASSERT(paddedData == nullptr || !sfz::ScopedRealtimeSection::isActive());
         largerSize = 0;
         alignedSize = 0;
         std::free(paddedData);
+        paddedData = nullptr;
         normalData = nullptr;
         normalEnd = nullptr;
         _alignedEnd = nullptr;
     }
     ~Buffer()
     {
+        ASSERT(paddedData == nullptr || !sfz::ScopedRealtimeSection::isActive());
         std::free(paddedData);
     }
 
@@ -0,0 +1,114 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Config.h"
+#include "LeakDetector.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace sfz {
+/**
+ * Event or realtime-safe parameter change sent to a Synth from another thread.
+ * The delay counts frames from the start of the block that picks the command up.
+ */
+struct SynthCommand {
+    enum class Type {
+        NoteOn,
+        NoteOff,
+        CC,
+        PitchWheel,
+        Aftertouch,
+        Tempo,
+        SampleQuality,
+        StealingPolicy
+    };
+    Type type { Type::NoteOn };
+    int delay { 0 };
+    int channel { 0 };
+    int number { 0 }; // note, CC number, pitch, quality or policy
+    uint8_t value { 0 }; // velocity, CC value or aftertouch
+    float seconds { 0.0f }; // seconds per quarter for the tempo
+};
+
+/**
+ * Bounded queue from any number of control threads to the audio thread, with the
+ * storage allocated up front. Nobody takes a lock: a sender reserves a slot by advancing
+ * the write position, and each slot carries a sequence number telling the reader when
+ * its command is complete and the senders when it is free again. A sender preempted
+ * while copying its command holds back the commands behind it until a later block,
+ * but the reader never waits for it.
+ */
+class CommandQueue {
+public:
+    explicit CommandQueue(size_t capacity = config::commandQueueSize)
+        : slots(capacity)
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    // Any thread; fails when the queue is full
+    bool push(const SynthCommand& command) noexcept
+    {
+        auto position = writePosition.load(std::memory_order_relaxed);
+        while (true) {
+            auto& slot = slots[position % slots.size()];
+            const auto lag = static_cast<int64_t>(slot.sequence.load(std::memory_order_acquire) - position);
+            if (lag == 0) {
+                if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.command = command;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                // The reader has not emptied the slot since the previous lap
+                return false;
+            } else {
+                position = writePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    // The audio thread only
+    bool pop(SynthCommand& command) noexcept
+    {
+        auto& slot = slots[readPosition % slots.size()];
+        if (slot.sequence.load(std::memory_order_acquire) != readPosition + 1)
+            return false;
+        command = slot.command;
+        slot.sequence.store(readPosition + slots.size(), std::memory_order_release);
+        readPosition++;
+        return true;
+    }
+private:
+    struct Slot {
+        // The position of the next write to the slot, plus one once it holds a command
+        std::atomic<uint64_t> sequence { 0 };
+        SynthCommand command;
+    };
+    std::vector<Slot> slots;
+    std::atomic<uint64_t> writePosition { 0 };
+    uint64_t readPosition { 0 };
+    LEAK_DETECTOR(CommandQueue);
+};
+}
@@ -29,15 +29,31 @@ namespace config {
     constexpr float defaultSampleRate { 48000 };
     constexpr int defaultSamplesPerBlock { 1024 };
     constexpr int preloadSize { 8192 };
+    constexpr int streamingBufferSize { 65536 }; // frames per streaming voice, must be a power of 2
+    constexpr int numSpareStreamingBuffers { 64 }; // allocated ahead of the voices that start streaming, see StreamingBufferPool
+    constexpr int streamingChunkSize { 4096 };
     constexpr int numChannels { 2 };
-    constexpr int numVoices { 64 };
+    constexpr int numVoices { 64 }; // default polyphony
+    constexpr int maxVoices { 4096 };
+    constexpr int stolenVoicesDivider { 8 }; // one extra voice per 8 to fade out the stolen ones
     constexpr int numLoadingThreads { 4 };
+    constexpr int renderThreadPriority { 70 }; // SCHED_FIFO priority of the render workers, see RenderPool::setNumThreads
+    constexpr int commandQueueSize { 4096 }; // events and parameter changes sent between two blocks
+    constexpr int maxDrainingInstruments { 4 }; // replaced instruments whose voices still play, see Synth::loadSfzFileAsync
+    constexpr int freewheelingTimeout { 1000 }; // milliseconds a block waits for its streams, see Synth::setFreewheeling
+    constexpr bool memoryMapSamples { true }; // read uncompressed WAV files through mmap instead of libsndfile
     constexpr int centPerSemitone { 100 };
     constexpr float virtuallyZero { 0.00005f };
     constexpr float fastReleaseDuration { 0.01 };
     constexpr char defineCharacter { '$' };
-    constexpr int oversamplingFactor { 2 };
+    constexpr int defaultOversamplingFactor { 1 }; // preloads at the file rate, see Synth::setOversamplingFactor
+    constexpr int maxOversamplingFactor { 4 };
     constexpr float A440 { 440.0 };
+    constexpr int defaultSampleQuality { 0 }; // linear interpolation, see Synth::setSampleQuality
+    constexpr int maxSampleQuality { 4 };
+    constexpr int sincPhases { 128 }; // fractional positions tabulated for the windowed-sinc interpolation
+    constexpr int maxInterpolationHistory { 15 }; // frames read before the interpolated position
+    constexpr int maxInterpolationLookahead { 16 }; // frames read after the interpolated position
 } // namespace config
 
 } // namespace sfz
@@ -47,15 +63,20 @@ namespace SIMDConfig {
     constexpr bool writeInterleaved { true };
     constexpr bool readInterleaved { true };
     constexpr bool fill { true };
-    constexpr bool gain { false };
-    constexpr bool mathfuns { false };
+    constexpr bool gain { true };
+    constexpr bool mathfuns { true };
     constexpr bool loopingSFZIndex { true };
     constexpr bool saturatingSFZIndex { true };
-    constexpr bool linearRamp { false };
+    constexpr bool interpolateLinear { true };
+    constexpr bool interpolateHermite { true };
+    constexpr bool interpolateSinc { true };
+    constexpr bool linearRamp { true };
     constexpr bool multiplicativeRamp { true };
     constexpr bool add { false };
     constexpr bool subtract { false };
-    constexpr bool multiplyAdd { false };
+    constexpr bool multiplyAdd { true };
     constexpr bool copy { false };
     constexpr bool pan { true };
+    constexpr bool panMono { true };
+    constexpr bool widthPosition { true };
 }
\ No newline at end of file
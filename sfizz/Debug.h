@@ -24,6 +24,7 @@
 #pragma once
 
 #ifndef NDEBUG
+#include "RealtimeChecks.h"
 #include <iostream>
 // These trap into the signal library rather than your own sourcecode
 // #include <signal.h>
@@ -59,8 +60,12 @@
     if (!(expression))     \
     ASSERTFALSE
 
-// Debug message
-#define DBG(ostream) std::cerr << ostream << '\n'
+// Debug message, which may allocate even on the audio thread since it only exists in debug builds
+#define DBG(ostream)                                 \
+    do {                                             \
+        sfz::ScopedRealtimeExemption dbgExemption;   \
+        std::cerr << ostream << '\n';                \
+    } while (0)
 
 #else // NDEBUG
 
@@ -23,12 +23,20 @@
 
 #include "FilePool.h"
 #include "AudioBuffer.h"
+#include "AudioSpan.h"
+#include "Buffer.h"
 #include "Config.h"
 #include "Debug.h"
+#include "Interpolators.h"
+#include "MathHelpers.h"
+#include "SIMDHelpers.h"
 #include "absl/types/span.h"
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <memory>
 #include <sndfile.hh>
+#include <vector>
 using namespace std::chrono_literals;
 
 template <class T>
@@ -45,74 +53,619 @@ std::unique_ptr<AudioBuffer<T>> readFromFile(SndfileHandle& sndFile, int numFram
     return returnedBuffer;
 }
 
-std::optional<sfz::FilePool::FileInformation> sfz::FilePool::getFileInformation(std::string_view filename) noexcept
+template <class T>
+std::unique_ptr<AudioBuffer<T>> readFromMappedFile(const sfz::MappedAudioFile& mappedFile, int numFrames)
 {
-    std::filesystem::path file { rootDirectory / filename };
-    if (!std::filesystem::exists(file))
-        return {};
+    auto returnedBuffer = std::make_unique<AudioBuffer<T>>(mappedFile.channels(), numFrames);
+    mappedFile.read(0, AudioSpan<T>(*returnedBuffer));
+    return returnedBuffer;
+}
+
+std::unique_ptr<AudioBuffer<float>> readPreload(const sfz::CachedSample& sample, SndfileHandle& sndFile)
+{
+    // The upsampling filter needs a few frames past the preload when the file has them
+    auto numFrames = sample.numPreloadedFrames;
+    if (sample.oversamplingFactor > 1)
+        numFrames = std::min(sample.end, numFrames + static_cast<uint32_t>(sfz::upsamplingLookahead));
+
+    auto preloadedData = sample.mappedFile
+        ? readFromMappedFile<float>(*sample.mappedFile, numFrames)
+        : readFromFile<float>(sndFile, numFrames);
+
+    if (sample.oversamplingFactor == 1)
+        return preloadedData;
+
+    auto oversampledData = std::make_unique<AudioBuffer<float>>(sample.numChannels, sample.numPreloadedFrames * sample.oversamplingFactor);
+    sfz::upsample(AudioSpan<const float>(*preloadedData), AudioSpan<float>(*oversampledData), sample.oversamplingFactor);
+    return oversampledData;
+}
 
+std::shared_ptr<sfz::CachedSample> sfz::FilePool::loadSample(const std::filesystem::path& file) noexcept
+{
     SndfileHandle sndFile(reinterpret_cast<const char*>(file.c_str()));
     if (sndFile.channels() != 1 && sndFile.channels() != 2) {
-        DBG("Missing logic for " << sndFile.channels() << " channels, discarding sample " << filename);
+        DBG("Missing logic for " << sndFile.channels() << " channels, discarding sample " << file);
         return {};
     }
 
-    FileInformation returnedValue;
-    returnedValue.end = static_cast<uint32_t>(sndFile.frames());
-    returnedValue.sampleRate = static_cast<double>(sndFile.samplerate());
+    auto sample = std::make_shared<CachedSample>();
+    sample->file = file;
+    sample->end = static_cast<uint32_t>(sndFile.frames());
+    sample->sampleRate = static_cast<double>(sndFile.samplerate());
+    sample->numChannels = sndFile.channels();
+    sample->oversamplingFactor = oversamplingFactor;
 
     SF_INSTRUMENT instrumentInfo;
     sndFile.command(SFC_GET_INSTRUMENT, &instrumentInfo, sizeof(instrumentInfo));
     if (instrumentInfo.loop_count == 1) {
-        returnedValue.loopBegin = instrumentInfo.loops[0].start;
-        returnedValue.loopEnd = instrumentInfo.loops[0].end;
+        sample->loopBegin = instrumentInfo.loops[0].start;
+        sample->loopEnd = instrumentInfo.loops[0].end;
     }
 
-    const auto preloadedSize = [&]() {
-        if (config::preloadSize == 0)
-            return returnedValue.end;
-        else
-            return std::min(returnedValue.end, static_cast<uint32_t>(config::preloadSize));
-    }();
+    if (config::preloadSize == 0)
+        sample->numPreloadedFrames = sample->end;
+    else
+        sample->numPreloadedFrames = std::min(sample->end, static_cast<uint32_t>(config::preloadSize));
 
-    if (preloadedData.contains(filename)) {
-        returnedValue.preloadedData = preloadedData[filename];
-    } else {
-        returnedValue.preloadedData = std::shared_ptr<AudioBuffer<float>>(readFromFile<float>(sndFile, preloadedSize));
-        preloadedData[filename] = returnedValue.preloadedData;
+    if (config::memoryMapSamples) {
+        sample->mappedFile = std::make_unique<MappedAudioFile>();
+        if (!sample->mappedFile->open(file) || sample->mappedFile->channels() != sndFile.channels())
+            sample->mappedFile.reset();
     }
 
+    sample->preloadedData = readPreload(*sample, sndFile);
+    return sample;
+}
+
+std::optional<sfz::FilePool::FileInformation> sfz::FilePool::getFileInformation(std::string_view filename) noexcept
+{
+    const std::string key { filename };
+    auto sample = [&]() -> std::shared_ptr<CachedSample> {
+        {
+            // The loader threads may be enforcing the budget, but the loading itself happens unlocked
+            std::lock_guard<std::mutex> samplesLock { samplesMutex };
+            if (auto knownSample = samples.find(key); knownSample != samples.end())
+                return knownSample->second;
+        }
+
+        const std::filesystem::path file { rootDirectory / filename };
+        const auto identity = SampleCache::identify(file);
+        if (!identity)
+            return {};
+
+        auto& cache = SampleCache::getInstance();
+        if (auto cachedSample = cache.find(*identity, oversamplingFactor))
+            return cachedSample;
+
+        auto loadedSample = loadSample(file);
+        if (!loadedSample)
+            return {};
+
+        return cache.insert(*identity, std::move(loadedSample));
+    }();
+
+    if (!sample)
+        return {};
+
+    addSample(filename, sample);
+    FileInformation returnedValue;
+    returnedValue.end = sample->end;
+    returnedValue.loopBegin = sample->loopBegin;
+    returnedValue.loopEnd = sample->loopEnd;
+    returnedValue.sampleRate = sample->sampleRate;
+    returnedValue.sample = std::move(sample);
     return returnedValue;
 }
 
-void sfz::FilePool::enqueueLoading(Voice* voice, std::string_view sample, int numFrames, unsigned ticket) noexcept
+void sfz::FilePool::addSample(std::string_view filename, std::shared_ptr<CachedSample> sample) noexcept
+{
+    std::unique_lock<std::mutex> samplesLock { samplesMutex };
+    const bool newSample = samples.try_emplace(std::string(filename), std::move(sample)).second;
+    samplesLock.unlock();
+    if (newSample)
+        enforceMemoryBudget();
+}
+
+bool sfz::FilePool::restoreSample(const InstrumentCache::Sample& cachedSample) noexcept
 {
-    if (!loadingQueue.try_enqueue({ voice, sample, numFrames, ticket })) {
-        DBG("Problem enqueuing a file read for file " << sample);
+    const std::filesystem::path file { rootDirectory / cachedSample.name };
+    const auto identity = SampleCache::identify(file);
+    if (!identity)
+        return false;
+
+    auto& cache = SampleCache::getInstance();
+    auto sample = cache.find(*identity, oversamplingFactor);
+    if (!sample) {
+        sample = std::make_shared<CachedSample>();
+        sample->file = file;
+        sample->end = cachedSample.end;
+        sample->loopBegin = cachedSample.loopBegin;
+        sample->loopEnd = cachedSample.loopEnd;
+        sample->sampleRate = cachedSample.sampleRate;
+        sample->numChannels = cachedSample.numChannels;
+        sample->numPreloadedFrames = cachedSample.numPreloadedFrames;
+        sample->oversamplingFactor = oversamplingFactor;
+
+        if (config::memoryMapSamples) {
+            sample->mappedFile = std::make_unique<MappedAudioFile>();
+            if (!sample->mappedFile->open(file) || sample->mappedFile->channels() != sample->numChannels)
+                sample->mappedFile.reset();
+        }
+
+        // The cache stores the preloads at the file rate, and upsampling them needs the frames past their end
+        if (!cachedSample.preloadedData.empty() && oversamplingFactor == 1) {
+            auto preloadedData = std::make_unique<AudioBuffer<float>>(sample->numChannels, sample->numPreloadedFrames);
+            for (int channel = 0; channel < sample->numChannels; ++channel)
+                std::copy_n(cachedSample.preloadedData[channel], sample->numPreloadedFrames, preloadedData->channelWriter(channel));
+            sample->preloadedData = std::move(preloadedData);
+        } else {
+            SndfileHandle sndFile;
+            if (!sample->mappedFile)
+                sndFile = SndfileHandle(reinterpret_cast<const char*>(file.c_str()));
+
+            if (!sample->mappedFile && sndFile.channels() != sample->numChannels)
+                return false;
+
+            sample->preloadedData = readPreload(*sample, sndFile);
+        }
+
+        sample = cache.insert(*identity, std::move(sample));
     }
+
+    addSample(cachedSample.name, std::move(sample));
+    return true;
 }
 
-void sfz::FilePool::loadingThread() noexcept
+size_t sfz::FilePool::getNumPreloadedSamples() const noexcept
 {
+    std::lock_guard<std::mutex> samplesLock { samplesMutex };
+    return samples.size();
+}
+
+void sfz::FilePool::clear() noexcept
+{
+    std::lock_guard<std::mutex> samplesLock { samplesMutex };
+    samples.clear();
+}
+
+void sfz::FilePool::setMemoryBudget(size_t bytes) noexcept
+{
+    memoryBudget = bytes;
+    enforceMemoryBudget();
+}
+
+void sfz::FilePool::setOversamplingFactor(int factor) noexcept
+{
+    // Powers of two up to the maximum divide the phases of the upsampling filter
+    static_assert(config::sincPhases % config::maxOversamplingFactor == 0);
+    const auto maxFactor = std::min(factor, config::maxOversamplingFactor);
+    oversamplingFactor = 1;
+    while (2 * oversamplingFactor <= maxFactor)
+        oversamplingFactor *= 2;
+}
+
+void sfz::FilePool::enforceMemoryBudget() noexcept
+{
+    const size_t budget = memoryBudget;
+    if (budget == 0)
+        return;
+
+    std::lock_guard<std::mutex> samplesLock { samplesMutex };
+    std::vector<CachedSample*> residentSamples;
+    residentSamples.reserve(samples.size());
+    for (auto& sample : samples) {
+        if (sample.second->isPreloadResident())
+            residentSamples.push_back(sample.second.get());
+    }
+
+    // Different file names can point to the same sample
+    std::sort(residentSamples.begin(), residentSamples.end());
+    residentSamples.erase(std::unique(residentSamples.begin(), residentSamples.end()), residentSamples.end());
+
+    size_t residentSize { 0 };
+    for (auto sample : residentSamples)
+        residentSize += sample->getPreloadSize();
+
+    if (residentSize <= budget)
+        return;
+
+    std::sort(residentSamples.begin(), residentSamples.end(), [](const CachedSample* lhs, const CachedSample* rhs) {
+        return lhs->getLastUse() < rhs->getLastUse();
+    });
+
+    for (auto sample : residentSamples) {
+        if (residentSize <= budget)
+            break;
+
+        if (sample->tryEvictPreload()) {
+            DBG("Evicting the preloaded data of " << sample->file);
+            residentSize -= sample->getPreloadSize();
+            numEvictions++;
+        }
+    }
+}
+
+void sfz::FilePool::processReloads() noexcept
+{
+    std::unique_lock<std::mutex> reloadLock { reloadMutex, std::try_to_lock };
+    if (!reloadLock.owns_lock())
+        return;
+
+    std::shared_ptr<CachedSample> sample;
+    while (reloadQueue.try_dequeue(sample)) {
+        if (!sample->isPreloadResident()) {
+            DBG("Reloading the preloaded data of " << sample->file);
+            SndfileHandle sndFile;
+            if (!sample->mappedFile)
+                sndFile = SndfileHandle(reinterpret_cast<const char*>(sample->file.c_str()));
+
+            if (sample->mappedFile || sndFile.channels() == sample->numChannels) {
+                sample->restorePreload(readPreload(*sample, sndFile));
+                numReloads++;
+            } else {
+                DBG("Cannot reload " << sample->file << ", its voices will keep streaming");
+            }
+        }
+        sample->reloadRequested = false;
+        sample.reset();
+        enforceMemoryBudget();
+    }
+}
+
+sfz::FilePool::Statistics sfz::FilePool::getStatistics() const noexcept
+{
+    Statistics statistics;
+    {
+        std::lock_guard<std::mutex> samplesLock { samplesMutex };
+        std::vector<const CachedSample*> residentSamples;
+        for (auto& sample : samples) {
+            if (sample.second->isPreloadResident())
+                residentSamples.push_back(sample.second.get());
+        }
+        std::sort(residentSamples.begin(), residentSamples.end());
+        residentSamples.erase(std::unique(residentSamples.begin(), residentSamples.end()), residentSamples.end());
+        for (auto sample : residentSamples)
+            statistics.preloadedBytes += sample->getPreloadSize();
+    }
+
+    statistics.evictions = numEvictions;
+    statistics.reloads = numReloads;
+    statistics.fallbacks = numFallbacks;
+    const uint64_t numDelivered = numDeliveredFallbacks;
+    if (numDelivered > 0)
+        statistics.averageFallbackLatency = std::chrono::microseconds(totalFallbackLatency / numDelivered);
+    statistics.maxFallbackLatency = std::chrono::microseconds(maxFallbackLatency);
+    statistics.streamedSamples = numStreamedSamples;
+    statistics.streamingBuffers = streamingBuffers.getNumAllocated();
+    statistics.missingStreamingBuffers = numMissingStreamingBuffers;
+    statistics.droppedLoads = numDroppedLoads;
+
+    auto summarize = [](const LatencyHistogram& histogram) {
+        Statistics::Latencies latencies;
+        latencies.count = histogram.getCount();
+        latencies.p50 = histogram.getPercentile(50.0);
+        latencies.p99 = histogram.getPercentile(99.0);
+        latencies.max = histogram.getMax();
+        return latencies;
+    };
+    statistics.queueLatency = summarize(queueLatencies);
+    statistics.readLatency = summarize(readLatencies);
+    statistics.timeToData = summarize(timeToDataLatencies);
+    return statistics;
+}
+
+sfz::StreamingBuffer* sfz::FilePool::acquireStreamingBuffer(std::chrono::milliseconds timeout) noexcept
+{
+    auto buffer = streamingBuffers.acquire();
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (buffer == nullptr && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        buffer = streamingBuffers.acquire();
+    }
+
+    if (buffer == nullptr)
+        numMissingStreamingBuffers++;
+    return buffer;
+}
+
+void sfz::FilePool::releaseStreamingBuffer(StreamingBuffer* buffer) noexcept
+{
+    streamingBuffers.release(buffer);
+}
+
+void sfz::FilePool::enqueueLoading(Voice* voice, const Region* region, unsigned ticket) noexcept
+{
+    FileLoadingInformation fileToLoad;
+    fileToLoad.buffer = voice->getStreamingBuffer();
+    fileToLoad.sample = region->cachedSample;
+    fileToLoad.mappedFile = std::shared_ptr<const MappedAudioFile>(region->cachedSample, region->cachedSample->mappedFile.get());
+    fileToLoad.streamStart = voice->getStreamStart();
+    fileToLoad.sampleEnd = region->trueSampleEnd();
+    fileToLoad.loopStart = region->loopRange.getStart();
+    fileToLoad.loop = region->shouldLoop();
+    fileToLoad.ticket = ticket;
+    fileToLoad.fallback = !voice->hasPreloadedData();
+    fileToLoad.enqueueTime = std::chrono::steady_clock::now();
+
+    if (fileToLoad.fallback) {
+        numFallbacks++;
+        if (!region->cachedSample->reloadRequested.exchange(true) && !reloadQueue.try_enqueue(region->cachedSample)) {
+            numDroppedLoads++;
+            region->cachedSample->reloadRequested = false;
+        }
+    }
+
+    // This runs on the audio thread, so the failures are only counted
+    if (!loadingQueue.try_enqueue(fileToLoad))
+        numDroppedLoads++;
+}
+
+struct sfz::StreamingTask {
+    FilePool::FileLoadingInformation information;
+    SndfileHandle sndFile;
+    uint32_t written { 0 };
+    bool claimed { false };
+    bool delivered { false };
+    std::chrono::steady_clock::time_point dequeueTime;
+    std::chrono::steady_clock::time_point readTime; // of the first chunk
+};
+
+namespace {
+enum class StreamingStatus {
+    Progress,
+    Waiting,
+    Done
+};
+
+StreamingStatus refill(sfz::StreamingTask& task, Buffer<float>& interleavedBuffer, AudioBuffer<float>& chunkBuffer) noexcept
+{
+    auto& information = task.information;
+    if (!information.buffer->isCurrent(information.ticket))
+        return StreamingStatus::Done;
+
+    auto numFrames = min(static_cast<uint32_t>(sfz::config::streamingChunkSize), information.buffer->freeFrames(task.written));
+    if (numFrames == 0)
+        return StreamingStatus::Waiting;
+
+    // Map the stream position to the file, wrapping around the loop if needed.
+    // This mirrors the looping index in the voice which jumps back on the last frame.
+    const uint32_t loopEnd = information.sampleEnd > 0 ? information.sampleEnd - 1 : 0;
+    const bool loop = information.loop && loopEnd > information.loopStart;
+    uint64_t filePosition = static_cast<uint64_t>(information.streamStart) + task.written;
+    if (loop && filePosition >= loopEnd)
+        filePosition = information.loopStart + (filePosition - information.loopStart) % (loopEnd - information.loopStart);
+
+    const uint32_t segmentEnd = loop ? loopEnd : information.sampleEnd;
+    if (filePosition >= segmentEnd)
+        return StreamingStatus::Done;
+
+    numFrames = min(numFrames, static_cast<uint32_t>(segmentEnd - filePosition));
+
+    const auto numChannels = information.mappedFile ? information.mappedFile->channels() : task.sndFile.channels();
+    sf_count_t numRead { 0 };
+    if (information.mappedFile) {
+        numRead = information.mappedFile->read(static_cast<uint32_t>(filePosition), AudioSpan<float>(chunkBuffer).first(numFrames));
+        // Warm up the pages for the next refill while the voice plays this one
+        information.mappedFile->prefetch(static_cast<uint32_t>(filePosition) + numFrames, sfz::config::streamingChunkSize);
+    } else if (numChannels == 1) {
+        task.sndFile.seek(static_cast<sf_count_t>(filePosition), SEEK_SET);
+        numRead = task.sndFile.readf(chunkBuffer.channelWriter(0), numFrames);
+    } else {
+        task.sndFile.seek(static_cast<sf_count_t>(filePosition), SEEK_SET);
+        numRead = task.sndFile.readf(interleavedBuffer.data(), numFrames);
+        ::readInterleaved<float>(absl::MakeConstSpan(interleavedBuffer.data(), 2 * numFrames), chunkBuffer.getSpan(0), chunkBuffer.getSpan(1));
+    }
+
+    // Pad short reads so that the voice never waits on a broken file
+    if (task.written == 0)
+        task.readTime = std::chrono::steady_clock::now();
+
+    const auto numValidFrames = static_cast<uint32_t>(std::max<sf_count_t>(numRead, 0));
+    for (int channelIndex = 0; channelIndex < numChannels; ++channelIndex)
+        ::fill<float>(chunkBuffer.getSpan(channelIndex).subspan(numValidFrames, numFrames - numValidFrames), 0.0f);
+
+    const auto chunk = [&]() {
+        if (numChannels == 1)
+            return AudioSpan<const float>({ chunkBuffer.channelReader(0) }, numFrames);
+        else
+            return AudioSpan<const float>(chunkBuffer).first(numFrames);
+    }();
+
+    if (!information.buffer->write(information.ticket, task.written, chunk))
+        return StreamingStatus::Done;
+
+    task.written += numFrames;
+    return StreamingStatus::Progress;
+}
+}
+
+sfz::FilePool::FilePool()
+{
+    tasks.reserve(config::maxVoices);
+    for (int i = 0; i < config::numLoadingThreads; ++i)
+        loadingThreads.emplace_back(&FilePool::loadingThread, this);
+}
+
+sfz::FilePool::~FilePool()
+{
+    quitThread = true;
+    tasksChanged.notify_all();
+    for (auto& thread : loadingThreads)
+        thread.join();
+}
+
+void sfz::FilePool::pollLoadingQueue(std::chrono::milliseconds timeout) noexcept
+{
+    // The queue only supports a single consumer, so the threads take turns
+    std::unique_lock<std::mutex> queueLock { queueMutex, std::try_to_lock };
+    if (!queueLock.owns_lock()) {
+        if (timeout > 0ms) {
+            std::unique_lock<std::mutex> taskLock { taskMutex };
+            tasksChanged.wait_for(taskLock, timeout);
+        }
+        return;
+    }
+
     FileLoadingInformation fileToLoad {};
-    while (!quitThread) {
-        if (!loadingQueue.wait_dequeue_timed(fileToLoad, 10ms))
+    if (!loadingQueue.wait_dequeue_timed(fileToLoad, timeout))
+        return;
+
+    const auto dequeueTime = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> taskLock { taskMutex };
+    do {
+        if (fileToLoad.buffer == nullptr) {
+            DBG("Background thread error: streaming buffer is null.");
             continue;
+        }
+        auto task = std::make_unique<StreamingTask>();
+        task->information = fileToLoad;
+        task->dequeueTime = dequeueTime;
+        tasks.push_back(std::move(task));
+    } while (loadingQueue.try_dequeue(fileToLoad));
+    taskLock.unlock();
+    tasksChanged.notify_all();
+}
 
-        if (fileToLoad.voice == nullptr) {
-            DBG("Background thread error: voice is null.");
+sfz::StreamingTask* sfz::FilePool::claimMostUrgentTask() noexcept
+{
+    std::lock_guard<std::mutex> taskLock { taskMutex };
+
+    // Two tasks may target the same voice if it restarted; only one may write at a time
+    std::array<const StreamingBuffer*, config::numLoadingThreads> busyBuffers {};
+    auto busyBuffer = busyBuffers.begin();
+    for (auto& task : tasks) {
+        if (task->claimed && busyBuffer < busyBuffers.end())
+            *busyBuffer++ = task->information.buffer;
+    }
+
+    // The most urgent stream is the one with the fewest frames ahead of its voice,
+    // and among equals the oldest trigger.
+    StreamingTask* mostUrgent { nullptr };
+    uint32_t mostUrgentFreeFrames { 0 };
+    auto task = tasks.begin();
+    while (task < tasks.end()) {
+        auto& information = (*task)->information;
+        if (!(*task)->claimed && !information.buffer->isCurrent(information.ticket)) {
+            std::iter_swap(task, tasks.end() - 1);
+            tasks.pop_back();
             continue;
         }
 
-        DBG("Background loading of: " << fileToLoad.sample);
-        std::filesystem::path file { rootDirectory / fileToLoad.sample };
-        if (!std::filesystem::exists(file)) {
-            DBG("Background thread: no file " << fileToLoad.sample << " exists.");
+        // The thread refilling a claimed task owns its progress
+        if ((*task)->claimed) {
+            task++;
+            continue;
+        }
+
+        const auto freeFrames = information.buffer->freeFrames((*task)->written);
+        const bool eligible = freeFrames >= static_cast<uint32_t>(config::streamingChunkSize)
+            && std::find(busyBuffers.begin(), busyBuffer, information.buffer) == busyBuffer;
+
+        if (eligible) {
+            if (mostUrgent == nullptr
+                || freeFrames > mostUrgentFreeFrames
+                || (freeFrames == mostUrgentFreeFrames && information.ticket < mostUrgent->information.ticket)) {
+                mostUrgent = task->get();
+                mostUrgentFreeFrames = freeFrames;
+            }
+        }
+        task++;
+    }
+
+    if (mostUrgent != nullptr)
+        mostUrgent->claimed = true;
+
+    return mostUrgent;
+}
+
+void sfz::FilePool::releaseTask(StreamingTask* task, bool done) noexcept
+{
+    std::unique_lock<std::mutex> taskLock { taskMutex };
+    if (!done) {
+        task->claimed = false;
+    } else {
+        auto position = std::find_if(tasks.begin(), tasks.end(), [task](const auto& t) { return t.get() == task; });
+        if (position != tasks.end()) {
+            std::iter_swap(position, tasks.end() - 1);
+            tasks.pop_back();
+        }
+    }
+    taskLock.unlock();
+    taskReleased.notify_all();
+}
+
+void sfz::FilePool::cancelLoading() noexcept
+{
+    {
+        // Everything dequeued under this lock is already in the task list
+        std::lock_guard<std::mutex> queueLock { queueMutex };
+        FileLoadingInformation pendingLoad;
+        while (loadingQueue.try_dequeue(pendingLoad)) { }
+    }
+
+    std::unique_lock<std::mutex> taskLock { taskMutex };
+    taskReleased.wait(taskLock, [this]() {
+        tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [](const auto& task) { return !task->claimed; }), tasks.end());
+        return tasks.empty();
+    });
+}
+
+void sfz::FilePool::loadingThread() noexcept
+{
+    Buffer<float> interleavedBuffer { config::numChannels * config::streamingChunkSize };
+    AudioBuffer<float> chunkBuffer { config::numChannels, config::streamingChunkSize };
+
+    bool idle { false };
+    while (!quitThread) {
+        pollLoadingQueue(idle ? 1ms : 0ms);
+        processReloads();
+        streamingBuffers.replenish();
+
+        auto task = claimMostUrgentTask();
+        idle = (task == nullptr);
+        if (idle)
             continue;
+
+        if (!task->information.mappedFile && !task->sndFile) {
+            const auto& file = task->information.sample->file;
+            DBG("Background streaming of: " << file);
+            if (std::filesystem::exists(file))
+                task->sndFile = SndfileHandle(reinterpret_cast<const char*>(file.c_str()));
+
+            const auto numChannels = task->sndFile.channels();
+            if (numChannels != 1 && numChannels != 2) {
+                DBG("Background thread: cannot stream " << file);
+                releaseTask(task, true);
+                continue;
+            }
+        }
+
+        const auto writtenBefore = task->written;
+        const auto status = refill(*task, interleavedBuffer, chunkBuffer);
+        numStreamedSamples += static_cast<uint64_t>(task->written - writtenBefore) * task->information.sample->numChannels;
+        if (!task->delivered && task->written > 0) {
+            task->delivered = true;
+            recordDelivery(*task);
         }
+        releaseTask(task, status == StreamingStatus::Done);
+    }
+}
 
-        SndfileHandle sndFile(reinterpret_cast<const char*>(file.c_str()));
-        auto fileLoaded = std::make_unique<AudioBuffer<float>>(sndFile.channels(), fileToLoad.numFrames);
-        fileToLoad.voice->setFileData(readFromFile<float>(sndFile, fileToLoad.numFrames), fileToLoad.ticket);
+void sfz::FilePool::recordDelivery(const StreamingTask& task) noexcept
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    const auto& information = task.information;
+    const auto latency = duration_cast<microseconds>(std::chrono::steady_clock::now() - information.enqueueTime);
+    queueLatencies.record(duration_cast<microseconds>(task.dequeueTime - information.enqueueTime));
+    readLatencies.record(duration_cast<microseconds>(task.readTime - task.dequeueTime));
+    timeToDataLatencies.record(latency);
+
+    if (information.fallback) {
+        const auto latencyCount = static_cast<uint64_t>(latency.count());
+        totalFallbackLatency += latencyCount;
+        numDeliveredFallbacks++;
+        auto currentMax = maxFallbackLatency.load();
+        while (latencyCount > currentMax && !maxFallbackLatency.compare_exchange_weak(currentMax, latencyCount)) { }
     }
-}
\ No newline at end of file
+}
@@ -24,55 +24,164 @@
 #pragma once
 #include "Config.h"
 #include "Defaults.h"
+#include "InstrumentCache.h"
 #include "LeakDetector.h"
+#include "MappedAudioFile.h"
+#include "SampleCache.h"
 #include "AudioBuffer.h"
+#include "LatencyHistogram.h"
 #include "Voice.h"
 #include "filesystem.h"
 #include "readerwriterqueue.h"
+#include "StreamingBufferPool.h"
 #include <absl/container/flat_hash_map.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <thread>
+#include <vector>
 
 namespace sfz {
+struct StreamingTask;
+
 class FilePool {
 public:
-    FilePool()
-        : fileLoadingThread(std::thread(&FilePool::loadingThread, this))
-    {
-    }
-
-    ~FilePool()
-    {
-        quitThread = true;
-        fileLoadingThread.join();
-    }
+    FilePool();
+    ~FilePool();
     void setRootDirectory(const std::filesystem::path& directory) noexcept { rootDirectory = directory; }
-    size_t getNumPreloadedSamples() const noexcept { return preloadedData.size(); }
+    size_t getNumPreloadedSamples() const noexcept;
+    /**
+     * Releases the samples held by this pool; they stay in memory while other pools use them.
+     */
+    void clear() noexcept;
+    /**
+     * Sets the maximum size of the preloaded data in bytes, 0 meaning no limit.
+     * Over budget, the least recently used preloads that no voice is playing are evicted;
+     * they are restored in the background the next time one of their regions plays.
+     */
+    void setMemoryBudget(size_t bytes) noexcept;
+    size_t getMemoryBudget() const noexcept { return memoryBudget; }
+    /**
+     * Stores the preloads of the samples loaded afterwards upsampled by 1, 2 or 4, so that
+     * the voices interpolate the beginning of the samples from the denser data. This costs
+     * as many times the preload memory; the streamed part of the samples is not oversampled.
+     */
+    void setOversamplingFactor(int factor) noexcept;
+    int getOversamplingFactor() const noexcept { return oversamplingFactor; }
+
+    struct Statistics {
+        size_t preloadedBytes { 0 };
+        uint64_t evictions { 0 };
+        uint64_t reloads { 0 };
+        uint64_t fallbacks { 0 }; // voices started on an evicted preload
+        std::chrono::microseconds averageFallbackLatency { 0 };
+        std::chrono::microseconds maxFallbackLatency { 0 };
+        uint64_t streamedSamples { 0 }; // frames times channels written to the voices
+        int streamingBuffers { 0 }; // allocated so far, see acquireStreamingBuffer
+        uint64_t missingStreamingBuffers { 0 }; // voices cut short for want of a streaming buffer
+        uint64_t droppedLoads { 0 }; // streams and preload reloads that found their queue full
+        struct Latencies {
+            uint64_t count { 0 };
+            std::chrono::microseconds p50 { 0 };
+            std::chrono::microseconds p99 { 0 };
+            std::chrono::microseconds max { 0 };
+        };
+        // The streams are timed from enqueueLoading until a loading thread dequeues them,
+        // from then until their first chunk is read, and from enqueueLoading until that
+        // chunk is in the voice's buffer.
+        Latencies queueLatency;
+        Latencies readLatency;
+        Latencies timeToData;
+    };
+    Statistics getStatistics() const noexcept;
 
     struct FileInformation {
         uint32_t end { Default::sampleEndRange.getEnd() };
         uint32_t loopBegin { Default::loopRange.getStart() };
         uint32_t loopEnd { Default::loopRange.getEnd() };
         double sampleRate { config::defaultSampleRate };
-        std::shared_ptr<AudioBuffer<float>> preloadedData;
+        std::shared_ptr<CachedSample> sample;
     };
     std::optional<FileInformation> getFileInformation(std::string_view filename) noexcept;
-    void enqueueLoading(Voice* voice, std::string_view sample, int numFrames, unsigned ticket) noexcept;
-private:
-    std::filesystem::path rootDirectory;
+    /**
+     * Adds a sample from an instrument cache without opening it through libsndfile.
+     * The preload comes from the cache when it was stored there.
+     */
+    bool restoreSample(const InstrumentCache::Sample& cachedSample) noexcept;
+    /**
+     * Takes a streaming buffer for a voice that starts streaming, or returns nullptr when
+     * the loading threads have not allocated enough of them within the timeout.
+     * Audio thread only.
+     */
+    StreamingBuffer* acquireStreamingBuffer(std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) noexcept;
+    // Audio thread only; the loads still writing into the buffer see their ticket expired
+    void releaseStreamingBuffer(StreamingBuffer* buffer) noexcept;
+    void enqueueLoading(Voice* voice, const Region* region, unsigned ticket) noexcept;
+    /**
+     * Drops the pending loads and waits for the ones in progress, after which the
+     * streaming buffers are no longer accessed.
+     * The caller must not enqueue loads meanwhile.
+     */
+    void cancelLoading() noexcept;
+
     struct FileLoadingInformation {
-        Voice* voice;
-        std::string_view sample;
-        int numFrames;
+        StreamingBuffer* buffer;
+        // Holding the sample keeps its file name alive if the region is destroyed meanwhile
+        std::shared_ptr<const CachedSample> sample;
+        std::shared_ptr<const MappedAudioFile> mappedFile;
+        uint32_t streamStart;
+        uint32_t sampleEnd;
+        uint32_t loopStart;
+        bool loop;
         unsigned ticket;
+        bool fallback;
+        std::chrono::steady_clock::time_point enqueueTime;
     };
+private:
+    std::filesystem::path rootDirectory;
+    int oversamplingFactor { config::defaultOversamplingFactor };
 
-    moodycamel::BlockingReaderWriterQueue<FileLoadingInformation> loadingQueue { config::numVoices };
+    moodycamel::BlockingReaderWriterQueue<FileLoadingInformation> loadingQueue { config::maxVoices };
+    StreamingBufferPool streamingBuffers;
     void loadingThread() noexcept;
-    std::thread fileLoadingThread;
-    bool quitThread { false };
-    absl::flat_hash_map<std::string_view, std::shared_ptr<AudioBuffer<float>>> preloadedData;
+    void pollLoadingQueue(std::chrono::milliseconds timeout) noexcept;
+    StreamingTask* claimMostUrgentTask() noexcept;
+    void releaseTask(StreamingTask* task, bool done) noexcept;
+    std::mutex queueMutex;
+    std::mutex taskMutex;
+    std::condition_variable tasksChanged;
+    std::condition_variable taskReleased;
+    std::vector<std::unique_ptr<StreamingTask>> tasks;
+    std::vector<std::thread> loadingThreads;
+    std::atomic<bool> quitThread { false };
+    std::shared_ptr<CachedSample> loadSample(const std::filesystem::path& file) noexcept;
+    void addSample(std::string_view filename, std::shared_ptr<CachedSample> sample) noexcept;
+    mutable std::mutex samplesMutex;
+    absl::flat_hash_map<std::string, std::shared_ptr<CachedSample>> samples;
+
+    void enforceMemoryBudget() noexcept;
+    void processReloads() noexcept;
+    moodycamel::ReaderWriterQueue<std::shared_ptr<CachedSample>> reloadQueue { config::maxVoices };
+    std::mutex reloadMutex;
+    std::atomic<size_t> memoryBudget { 0 };
+    std::atomic<uint64_t> numEvictions { 0 };
+    std::atomic<uint64_t> numReloads { 0 };
+    std::atomic<uint64_t> numFallbacks { 0 };
+    std::atomic<uint64_t> numDeliveredFallbacks { 0 };
+    std::atomic<uint64_t> totalFallbackLatency { 0 };
+    std::atomic<uint64_t> maxFallbackLatency { 0 };
+    std::atomic<uint64_t> numStreamedSamples { 0 };
+    std::atomic<uint64_t> numMissingStreamingBuffers { 0 };
+    std::atomic<uint64_t> numDroppedLoads { 0 };
+    LatencyHistogram queueLatencies;
+    LatencyHistogram readLatencies;
+    LatencyHistogram timeToDataLatencies;
+    void recordDelivery(const StreamingTask& task) noexcept;
     LEAK_DETECTOR(FilePool);
 };
 }
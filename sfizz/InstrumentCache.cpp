@@ -0,0 +1,438 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "InstrumentCache.h"
+#include "Config.h"
+#include "StringViewHelpers.h"
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <type_traits>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SFIZZ_HAVE_MMAP
+#endif
+
+namespace {
+// Reads as "SFZC" in a file written on a little-endian machine; any other byte order fails the check
+constexpr uint32_t cacheMagic { 0x435A4653 };
+constexpr uint32_t cacheVersion { 1 };
+constexpr size_t floatAlignment { alignof(float) };
+
+class CacheWriter {
+public:
+    explicit CacheWriter(const std::filesystem::path& file)
+        : stream(file, std::ios::binary | std::ios::trunc)
+    {
+    }
+    bool good() const noexcept { return static_cast<bool>(stream); }
+    template <class T>
+    void write(T value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written as is");
+        writeBytes(&value, sizeof(T));
+    }
+    void writeString(std::string_view string)
+    {
+        write(static_cast<uint32_t>(string.size()));
+        writeBytes(string.data(), string.size());
+    }
+    void writeIdentity(const sfz::SampleCache::FileIdentity& identity)
+    {
+        writeString(identity.path);
+        write(identity.device);
+        write(identity.inode);
+        write(identity.modificationTime);
+    }
+    void writeBytes(const void* bytes, size_t numBytes)
+    {
+        stream.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(numBytes));
+        position += numBytes;
+    }
+    void align(size_t alignment)
+    {
+        while (position % alignment != 0)
+            write<uint8_t>(0);
+    }
+    void close() { stream.close(); }
+private:
+    std::ofstream stream;
+    size_t position { 0 };
+};
+
+class CacheReader {
+public:
+    CacheReader(const uint8_t* data, size_t size)
+        : data(data)
+        , size(size)
+    {
+    }
+    template <class T>
+    bool read(T& value) noexcept
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read as is");
+        if (size - position < sizeof(T))
+            return false;
+        std::memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+    bool readString(std::string_view& string) noexcept
+    {
+        uint32_t length;
+        if (!read(length) || size - position < length)
+            return false;
+        string = std::string_view(reinterpret_cast<const char*>(data + position), length);
+        position += length;
+        return true;
+    }
+    bool readIdentity(sfz::SampleCache::FileIdentity& identity) noexcept
+    {
+        std::string_view path;
+        if (!readString(path))
+            return false;
+        identity.path = std::string(path);
+        return read(identity.device) && read(identity.inode) && read(identity.modificationTime);
+    }
+    const float* readFloats(size_t numFloats) noexcept
+    {
+        const size_t padding = (floatAlignment - position % floatAlignment) % floatAlignment;
+        if (size - position < padding || (size - position - padding) / sizeof(float) < numFloats)
+            return nullptr;
+        position += padding;
+        auto floats = reinterpret_cast<const float*>(data + position);
+        position += numFloats * sizeof(float);
+        return floats;
+    }
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position { 0 };
+};
+}
+
+sfz::InstrumentCache::~InstrumentCache()
+{
+    close();
+}
+
+std::filesystem::path sfz::InstrumentCache::getCacheFileName(const std::filesystem::path& sfzFile) noexcept
+{
+    std::error_code error;
+    auto canonicalPath = std::filesystem::canonical(sfzFile, error);
+    if (error)
+        canonicalPath = sfzFile;
+
+    std::ostringstream fileName;
+    fileName << sfzFile.stem().string() << '-' << std::hex << std::setw(16) << std::setfill('0')
+             << hash(canonicalPath.string()) << ".sfzcache";
+    return fileName.str();
+}
+
+bool sfz::InstrumentCache::open(const std::filesystem::path& cacheFile, const std::filesystem::path& sfzFile) noexcept
+{
+    close();
+    if (!mapFile(cacheFile))
+        return false;
+
+    if (!readContents(sfzFile)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void sfz::InstrumentCache::close() noexcept
+{
+    headers.clear();
+    samples.clear();
+    defines.clear();
+    includedFiles.clear();
+#ifdef SFIZZ_HAVE_MMAP
+    if (mapping != nullptr)
+        ::munmap(mapping, size);
+#endif
+    mapping = nullptr;
+    fileContent.clear();
+    fileContent.shrink_to_fit();
+    data = nullptr;
+    size = 0;
+}
+
+bool sfz::InstrumentCache::mapFile(const std::filesystem::path& cacheFile) noexcept
+{
+#ifdef SFIZZ_HAVE_MMAP
+    const int fileDescriptor = ::open(cacheFile.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+        return false;
+
+    struct stat fileStatus;
+    if (::fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0) {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    size = static_cast<size_t>(fileStatus.st_size);
+    mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    ::close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        size = 0;
+        return false;
+    }
+
+    data = static_cast<const uint8_t*>(mapping);
+    return true;
+#else
+    std::ifstream fileStream(cacheFile, std::ios::binary | std::ios::ate);
+    if (!fileStream)
+        return false;
+
+    const auto fileSize = fileStream.tellg();
+    if (fileSize <= 0)
+        return false;
+
+    fileContent.resize(static_cast<size_t>(fileSize));
+    fileStream.seekg(0);
+    fileStream.read(reinterpret_cast<char*>(fileContent.data()), fileSize);
+    if (fileStream.gcount() != fileSize)
+        return false;
+
+    data = fileContent.data();
+    size = fileContent.size();
+    return true;
+#endif
+}
+
+bool sfz::InstrumentCache::readContents(const std::filesystem::path& sfzFile) noexcept
+{
+    CacheReader reader { data, size };
+    uint32_t magic;
+    uint32_t version;
+    uint32_t preloadSize;
+    if (!reader.read(magic) || magic != cacheMagic)
+        return false;
+    if (!reader.read(version) || version != cacheVersion)
+        return false;
+    if (!reader.read(preloadSize) || preloadSize != static_cast<uint32_t>(config::preloadSize))
+        return false;
+
+    // The first dependency is the sfz file itself, then come its includes and its samples
+    const auto sfzIdentity = SampleCache::identify(sfzFile);
+    uint32_t numDependencies;
+    if (!sfzIdentity || !reader.read(numDependencies) || numDependencies == 0)
+        return false;
+
+    for (uint32_t i = 0; i < numDependencies; ++i) {
+        SampleCache::FileIdentity storedIdentity;
+        if (!reader.readIdentity(storedIdentity))
+            return false;
+
+        const auto identity = (i == 0) ? sfzIdentity : SampleCache::identify(storedIdentity.path);
+        if (!identity || !(*identity == storedIdentity))
+            return false;
+    }
+
+    uint32_t numDefines;
+    if (!reader.read(numDefines))
+        return false;
+
+    for (uint32_t i = 0; i < numDefines; ++i) {
+        std::string_view variable;
+        std::string_view value;
+        if (!reader.readString(variable) || !reader.readString(value))
+            return false;
+        defines.emplace(std::string(variable), std::string(value));
+    }
+
+    uint32_t numIncludedFiles;
+    if (!reader.read(numIncludedFiles))
+        return false;
+
+    for (uint32_t i = 0; i < numIncludedFiles; ++i) {
+        std::string_view includedFile;
+        if (!reader.readString(includedFile))
+            return false;
+        includedFiles.emplace_back(std::string(includedFile));
+    }
+
+    uint32_t numHeaders;
+    if (!reader.read(numHeaders))
+        return false;
+
+    headers.reserve(numHeaders);
+    for (uint32_t i = 0; i < numHeaders; ++i) {
+        auto& header = headers.emplace_back();
+        uint32_t numMembers;
+        if (!reader.readString(header.name) || !reader.read(numMembers))
+            return false;
+
+        header.members.reserve(numMembers);
+        for (uint32_t j = 0; j < numMembers; ++j) {
+            std::string_view opcode;
+            std::string_view value;
+            uint8_t hasParameter;
+            uint8_t parameter;
+            if (!reader.readString(opcode) || !reader.readString(value) || !reader.read(hasParameter) || !reader.read(parameter))
+                return false;
+
+            // The stored opcode is already split from its parameter
+            auto& member = header.members.emplace_back(opcode, value);
+            member.opcode = opcode;
+            member.parameter = hasParameter ? std::optional<uint8_t>(parameter) : std::nullopt;
+        }
+    }
+
+    uint32_t numSamples;
+    if (!reader.read(numSamples))
+        return false;
+
+    samples.reserve(numSamples);
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        auto& sample = samples.emplace_back();
+        uint32_t numChannels;
+        uint8_t hasPreload;
+        if (!reader.readString(sample.name) || !reader.read(sample.end) || !reader.read(sample.loopBegin)
+            || !reader.read(sample.loopEnd) || !reader.read(sample.sampleRate) || !reader.read(numChannels)
+            || !reader.read(sample.numPreloadedFrames) || !reader.read(hasPreload))
+            return false;
+
+        if (numChannels != 1 && numChannels != 2)
+            return false;
+
+        sample.numChannels = static_cast<int>(numChannels);
+        if (!hasPreload)
+            continue;
+
+        for (uint32_t channel = 0; channel < numChannels; ++channel) {
+            auto preloadedData = reader.readFloats(sample.numPreloadedFrames);
+            if (preloadedData == nullptr)
+                return false;
+            sample.preloadedData.push_back(preloadedData);
+        }
+    }
+
+    return true;
+}
+
+bool sfz::InstrumentCache::write(const std::filesystem::path& cacheFile, const Contents& contents) noexcept
+{
+    std::vector<SampleCache::FileIdentity> dependencies;
+    auto addDependency = [&](const std::filesystem::path& file) {
+        auto identity = SampleCache::identify(file);
+        if (identity)
+            dependencies.push_back(std::move(*identity));
+        return identity.has_value();
+    };
+
+    if (!addDependency(contents.sfzFile))
+        return false;
+    for (auto& includedFile : contents.includedFiles) {
+        if (!addDependency(includedFile))
+            return false;
+    }
+    for (auto& sample : contents.samples) {
+        if (!addDependency(sample.second->file))
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheFile.parent_path(), error);
+    auto temporaryFile = cacheFile;
+    temporaryFile += ".tmp";
+    CacheWriter writer { temporaryFile };
+    if (!writer.good())
+        return false;
+
+    writer.write(cacheMagic);
+    writer.write(cacheVersion);
+    writer.write(static_cast<uint32_t>(config::preloadSize));
+
+    writer.write(static_cast<uint32_t>(dependencies.size()));
+    for (auto& dependency : dependencies)
+        writer.writeIdentity(dependency);
+
+    writer.write(static_cast<uint32_t>(contents.defines.size()));
+    for (auto& define : contents.defines) {
+        writer.writeString(define.first);
+        writer.writeString(define.second);
+    }
+
+    writer.write(static_cast<uint32_t>(contents.includedFiles.size()));
+    for (auto& includedFile : contents.includedFiles)
+        writer.writeString(includedFile.string());
+
+    writer.write(static_cast<uint32_t>(contents.headers.size()));
+    for (auto& header : contents.headers) {
+        writer.writeString(header.name);
+        writer.write(static_cast<uint32_t>(header.members.size()));
+        for (auto& member : header.members) {
+            writer.writeString(member.opcode);
+            writer.writeString(member.value);
+            writer.write(static_cast<uint8_t>(member.parameter.has_value()));
+            writer.write(member.parameter.value_or(0));
+        }
+    }
+
+    writer.write(static_cast<uint32_t>(contents.samples.size()));
+    for (auto& [name, sample] : contents.samples) {
+        writer.writeString(name);
+        writer.write(sample->end);
+        writer.write(sample->loopBegin);
+        writer.write(sample->loopEnd);
+        writer.write(sample->sampleRate);
+        writer.write(static_cast<uint32_t>(sample->numChannels));
+        writer.write(sample->numPreloadedFrames);
+
+        // An acquired preload cannot be evicted while it is being written.
+        // Oversampled preloads are not stored, the cache holds the file rate.
+        const bool storePreload = contents.storePreloads && sample->oversamplingFactor == 1 && sample->acquirePreload();
+        writer.write(static_cast<uint8_t>(storePreload));
+        if (!storePreload)
+            continue;
+
+        writer.align(floatAlignment);
+        for (int channel = 0; channel < sample->numChannels; ++channel)
+            writer.writeBytes(sample->preloadedData->channelReader(channel), sample->numPreloadedFrames * sizeof(float));
+        sample->releasePreload();
+    }
+
+    writer.close();
+    if (!writer.good()) {
+        std::filesystem::remove(temporaryFile, error);
+        return false;
+    }
+
+    std::filesystem::rename(temporaryFile, cacheFile, error);
+    if (error) {
+        std::filesystem::remove(temporaryFile, error);
+        return false;
+    }
+
+    return true;
+}
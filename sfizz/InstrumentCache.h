@@ -0,0 +1,114 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "LeakDetector.h"
+#include "Opcode.h"
+#include "SampleCache.h"
+#include "filesystem.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sfz {
+/**
+ * Compiled on-disk copy of an instrument: the headers and opcodes produced by the parser
+ * once the includes and defines are resolved, the metadata of the samples and optionally
+ * their preloads. Loading from it skips the preprocessing, the parsing and opening the
+ * samples with libsndfile.
+ * The file stores the identities of the sfz file, its includes and its samples, and is
+ * rejected as soon as one of them changed. It is mapped in memory and the opcodes point
+ * into the mapping, so it has to stay open as long as they are used.
+ */
+class InstrumentCache {
+public:
+    InstrumentCache() = default;
+    ~InstrumentCache();
+    InstrumentCache(const InstrumentCache&) = delete;
+    InstrumentCache& operator=(const InstrumentCache&) = delete;
+
+    struct Header {
+        std::string_view name;
+        std::vector<Opcode> members;
+    };
+    struct Sample {
+        std::string_view name;
+        uint32_t end { 0 };
+        uint32_t loopBegin { 0 };
+        uint32_t loopEnd { 0 };
+        double sampleRate { 0.0 };
+        int numChannels { 1 };
+        uint32_t numPreloadedFrames { 0 };
+        // One pointer per channel, or none if the preload was not stored
+        std::vector<const float*> preloadedData;
+    };
+    /**
+     * Opens a cache file and checks it against the files it was built from.
+     *
+     * @return false if the cache is missing, malformed, built for another file or out of date
+     */
+    bool open(const std::filesystem::path& cacheFile, const std::filesystem::path& sfzFile) noexcept;
+    void close() noexcept;
+    bool isOpen() const noexcept { return data != nullptr; }
+
+    const std::vector<Header>& getHeaders() const noexcept { return headers; }
+    const std::vector<Sample>& getSamples() const noexcept { return samples; }
+    const std::map<std::string, std::string>& getDefines() const noexcept { return defines; }
+    const std::vector<std::filesystem::path>& getIncludedFiles() const noexcept { return includedFiles; }
+
+    struct Contents {
+        std::filesystem::path sfzFile;
+        std::vector<std::filesystem::path> includedFiles;
+        std::map<std::string, std::string> defines;
+        std::vector<Header> headers;
+        // The sample names as written in the regions, and the file they resolve to
+        std::vector<std::pair<std::string, std::shared_ptr<CachedSample>>> samples;
+        bool storePreloads { true };
+    };
+    /**
+     * Writes a cache file, replacing any previous one only once it is complete.
+     * Preloads that are evicted at the time are not stored.
+     */
+    static bool write(const std::filesystem::path& cacheFile, const Contents& contents) noexcept;
+    /**
+     * @return the name of the cache file of an sfz file, derived from its canonical path
+     */
+    static std::filesystem::path getCacheFileName(const std::filesystem::path& sfzFile) noexcept;
+private:
+    bool mapFile(const std::filesystem::path& cacheFile) noexcept;
+    bool readContents(const std::filesystem::path& sfzFile) noexcept;
+    const uint8_t* data { nullptr };
+    size_t size { 0 };
+    void* mapping { nullptr };
+    std::vector<uint8_t> fileContent;
+    std::vector<Header> headers;
+    std::vector<Sample> samples;
+    std::map<std::string, std::string> defines;
+    std::vector<std::filesystem::path> includedFiles;
+    LEAK_DETECTOR(InstrumentCache);
+};
+}
@@ -0,0 +1,171 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Interpolators.h"
+#include "Debug.h"
+#include "MathHelpers.h"
+#include "SIMDHelpers.h"
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace {
+// Zeroth-order modified Bessel function of the first kind
+double besselI0(double x)
+{
+    double sum { 1.0 };
+    double term { 1.0 };
+    for (int k = 1; term > 1e-12 * sum; ++k) {
+        const double halfXOverK = 0.5 * x / k;
+        term *= halfXOverK * halfXOverK;
+        sum += term;
+    }
+    return sum;
+}
+
+double kaiserBeta(int numTaps)
+{
+    // Longer kernels afford a narrower main lobe for a stronger attenuation
+    return numTaps <= 8 ? 5.0 : (numTaps <= 16 ? 7.0 : 9.0);
+}
+
+// The bands go up by quarter octaves; a ratio within a band is played with the cutoff
+// of the band's lower edge, which lets a little aliasing through near the Nyquist frequency
+// rather than dulling slightly transposed samples. The steps through the oversampled
+// preloads are larger than the pitch ratios, so the bands go up to 2 octaves above the
+// largest oversampling factor.
+constexpr int numSincBands { 17 };
+constexpr float bandsPerOctave { 4.0f };
+static_assert(sfz::config::maxOversamplingFactor <= 4, "The sinc bands do not cover the steps of the larger oversampling factors");
+
+int sincBand(float pitchRatio)
+{
+    if (!(pitchRatio > 1.0f))
+        return 0;
+    const auto band = static_cast<int>(bandsPerOctave * std::log2(pitchRatio));
+    return std::min(band, numSincBands - 1);
+}
+
+struct SincTableSet {
+    explicit SincTableSet(int numTaps)
+    {
+        tables.reserve(numSincBands);
+        for (int band = 0; band < numSincBands; ++band)
+            tables.emplace_back(numTaps, std::exp2(band / bandsPerOctave));
+    }
+    std::vector<sfz::SincTable> tables;
+};
+}
+
+sfz::SincTable::SincTable(int numTaps, float maxRatio)
+    : numTaps(numTaps)
+    , coefficients(2 * numTaps * config::sincPhases)
+{
+    ASSERT(numTaps > 0 && numTaps % 2 == 0);
+    const double cutoff = maxRatio > 1.0f ? 1.0 / maxRatio : 1.0;
+    const double halfLength = numTaps / 2;
+    const double beta = kaiserBeta(numTaps);
+    const double windowNorm = 1.0 / besselI0(beta);
+
+    // One more phase than stored, to compute the differences of the last one
+    std::vector<double> phases((config::sincPhases + 1) * numTaps);
+    for (int phase = 0; phase <= config::sincPhases; ++phase) {
+        const double fraction = static_cast<double>(phase) / config::sincPhases;
+        double* taps = &phases[phase * numTaps];
+        double sum { 0.0 };
+        for (int k = 0; k < numTaps; ++k) {
+            // Tap k reads the frame at index - numTaps / 2 + 1 + k
+            const double distance = k - halfLength + 1 - fraction;
+            const double x = pi<double> * cutoff * distance;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+            const double ratio = std::min(std::abs(distance) / halfLength, 1.0);
+            const double window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) * windowNorm;
+            taps[k] = cutoff * sinc * window;
+            sum += taps[k];
+        }
+        // Keep a unit gain at DC for every fractional position
+        for (int k = 0; k < numTaps; ++k)
+            taps[k] /= sum;
+    }
+
+    for (int phase = 0; phase < config::sincPhases; ++phase) {
+        const double* taps = &phases[phase * numTaps];
+        const double* nextTaps = taps + numTaps;
+        float* row = coefficients.data() + 2 * phase * numTaps;
+        for (int k = 0; k < numTaps; ++k) {
+            row[k] = static_cast<float>(taps[k]);
+            row[numTaps + k] = static_cast<float>(nextTaps[k] - taps[k]);
+        }
+    }
+}
+
+const sfz::SincTable* sfz::getSincTable(InterpolatorModel model, float pitchRatio) noexcept
+{
+    const auto band = sincBand(pitchRatio);
+    switch (model) {
+    case InterpolatorModel::Sinc8: {
+        static const SincTableSet tableSet { 8 };
+        return &tableSet.tables[band];
+    }
+    case InterpolatorModel::Sinc16: {
+        static const SincTableSet tableSet { 16 };
+        return &tableSet.tables[band];
+    }
+    case InterpolatorModel::Sinc32: {
+        static const SincTableSet tableSet { 32 };
+        return &tableSet.tables[band];
+    }
+    default:
+        return nullptr;
+    }
+}
+
+void sfz::upsample(AudioSpan<const float> input, AudioSpan<float> output, int factor) noexcept
+{
+    ASSERT(factor > 0 && config::sincPhases % factor == 0);
+    ASSERT(input.getNumChannels() == output.getNumChannels());
+    const auto table = getSincTable(InterpolatorModel::Sinc32, 1.0f);
+
+    constexpr size_t blockSize { 256 };
+    std::array<int, blockSize> indices;
+    std::array<float, blockSize> coeffs;
+    const auto numFrames = output.getNumFrames();
+    for (size_t blockStart = 0; blockStart < numFrames; blockStart += blockSize) {
+        const auto numBlockFrames = std::min(blockSize, numFrames - blockStart);
+        for (size_t i = 0; i < numBlockFrames; ++i) {
+            const auto frame = static_cast<int>(blockStart + i);
+            indices[i] = frame / factor;
+            coeffs[i] = static_cast<float>(frame % factor) / factor;
+        }
+
+        for (int channel = 0; channel < input.getNumChannels(); ++channel) {
+            ::interpolateSinc<float>(
+                absl::MakeConstSpan(indices.data(), numBlockFrames),
+                absl::MakeConstSpan(coeffs.data(), numBlockFrames),
+                input.getConstSpan(channel),
+                output.getSpan(channel).subspan(blockStart, numBlockFrames),
+                table->getCoefficients(),
+                table->getNumTaps());
+        }
+    }
+}
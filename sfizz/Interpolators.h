@@ -0,0 +1,122 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "AudioSpan.h"
+#include "Buffer.h"
+#include "Config.h"
+#include <absl/types/span.h>
+
+namespace sfz {
+/**
+ * Resampling methods used by the voices, from the cheapest to the most accurate.
+ * The windowed-sinc models are named after their number of taps.
+ */
+enum class InterpolatorModel {
+    Linear,
+    Hermite,
+    Sinc8,
+    Sinc16,
+    Sinc32
+};
+
+constexpr InterpolatorModel interpolatorModel(int sampleQuality) noexcept
+{
+    switch (sampleQuality) {
+    case 1: return InterpolatorModel::Hermite;
+    case 2: return InterpolatorModel::Sinc8;
+    case 3: return InterpolatorModel::Sinc16;
+    case 4: return InterpolatorModel::Sinc32;
+    default: return InterpolatorModel::Linear;
+    }
+}
+
+constexpr int numSincTaps(InterpolatorModel model) noexcept
+{
+    switch (model) {
+    case InterpolatorModel::Sinc8: return 8;
+    case InterpolatorModel::Sinc16: return 16;
+    case InterpolatorModel::Sinc32: return 32;
+    default: return 0;
+    }
+}
+
+// Number of frames read before the integer part of an interpolated position
+constexpr int interpolationHistory(InterpolatorModel model) noexcept
+{
+    switch (model) {
+    case InterpolatorModel::Linear: return 0;
+    case InterpolatorModel::Hermite: return 1;
+    default: return numSincTaps(model) / 2 - 1;
+    }
+}
+
+// Number of frames read after the integer part of an interpolated position
+constexpr int interpolationLookahead(InterpolatorModel model) noexcept
+{
+    switch (model) {
+    case InterpolatorModel::Linear: return 1;
+    case InterpolatorModel::Hermite: return 2;
+    default: return numSincTaps(model) / 2;
+    }
+}
+
+static_assert(interpolationHistory(InterpolatorModel::Sinc32) <= config::maxInterpolationHistory);
+static_assert(interpolationLookahead(InterpolatorModel::Sinc32) <= config::maxInterpolationLookahead);
+
+/**
+ * Kaiser-windowed sinc coefficients tabulated over config::sincPhases fractional positions,
+ * with a cutoff low enough to play the sample faster than maxRatio without much aliasing.
+ * Each phase holds its taps followed by their difference with the next phase, which is
+ * what interpolateSinc expects.
+ */
+class SincTable {
+public:
+    SincTable(int numTaps, float maxRatio);
+    int getNumTaps() const noexcept { return numTaps; }
+    absl::Span<const float> getCoefficients() const noexcept { return coefficients; }
+private:
+    int numTaps;
+    Buffer<float> coefficients;
+};
+
+/**
+ * Returns the table matching a sinc model and the step through the source, which is the
+ * pitch ratio times the oversampling of the data, or nullptr for the other models. The tables are shared and built on the first call for each model, which has to
+ * happen outside of the audio thread (see Synth::setSampleQuality).
+ */
+const SincTable* getSincTable(InterpolatorModel model, float pitchRatio) noexcept;
+
+// Number of input frames past the last upsampled position that the upsampling filter reads
+constexpr int upsamplingLookahead { interpolationLookahead(InterpolatorModel::Sinc32) };
+
+/**
+ * Fills the output with the input interpolated every 1 / factor frame, where the factor
+ * divides config::sincPhases. The phases of the 32-tap sinc table serve as a polyphase
+ * filter, so output frame i * factor + p is the input filtered at phase p / factor of frame i.
+ * Frames outside of the input are taken as silent: for the end of the output to be exact,
+ * the input should extend upsamplingLookahead frames past it.
+ */
+void upsample(AudioSpan<const float> input, AudioSpan<float> output, int factor) noexcept;
+
+} // namespace sfz
@@ -0,0 +1,115 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace sfz {
+/**
+ * Counts durations in logarithmic buckets, each an eighth of an octave wide above 16 µs,
+ * so that the percentiles come out within 12.5% up to more than an hour. Several threads
+ * can record concurrently without locking.
+ */
+class LatencyHistogram {
+public:
+    void record(std::chrono::microseconds latency) noexcept
+    {
+        const auto value = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+        buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        auto currentMax = max.load(std::memory_order_relaxed);
+        while (value > currentMax && !max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) { }
+    }
+
+    uint64_t getCount() const noexcept { return count.load(std::memory_order_relaxed); }
+    std::chrono::microseconds getMax() const noexcept { return std::chrono::microseconds(max.load(std::memory_order_relaxed)); }
+
+    /**
+     * Returns the upper bound of the bucket holding the given percentile of the
+     * recorded latencies, capped to the largest one, or 0 if nothing was recorded.
+     */
+    std::chrono::microseconds getPercentile(double percentile) const noexcept
+    {
+        const auto numRecorded = getCount();
+        if (numRecorded == 0)
+            return std::chrono::microseconds(0);
+
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * numRecorded)));
+        uint64_t cumulated { 0 };
+        for (int bucket = 0; bucket < numBuckets; ++bucket) {
+            cumulated += buckets[bucket].load(std::memory_order_relaxed);
+            if (cumulated >= rank)
+                return std::chrono::microseconds(std::min(upperBoundOf(bucket), max.load(std::memory_order_relaxed)));
+        }
+        return getMax();
+    }
+
+    void clear() noexcept
+    {
+        for (auto& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int numLinearBuckets { 16 };
+    static constexpr int subBucketBits { 3 };
+    static constexpr int firstExponent { 4 }; // log2(numLinearBuckets)
+    static constexpr int lastExponent { 31 };
+    static constexpr int numBuckets { numLinearBuckets + (lastExponent - firstExponent + 1) * (1 << subBucketBits) };
+
+    static int bucketOf(uint64_t value) noexcept
+    {
+        if (value < numLinearBuckets)
+            return static_cast<int>(value);
+
+        value = std::min<uint64_t>(value, (uint64_t { 1 } << (lastExponent + 1)) - 1);
+        int exponent { firstExponent };
+        while ((value >> (exponent + 1)) != 0)
+            exponent++;
+
+        const auto subBucket = static_cast<int>((value >> (exponent - subBucketBits)) & ((1 << subBucketBits) - 1));
+        return numLinearBuckets + ((exponent - firstExponent) << subBucketBits) + subBucket;
+    }
+
+    static uint64_t upperBoundOf(int bucket) noexcept
+    {
+        if (bucket < numLinearBuckets)
+            return static_cast<uint64_t>(bucket);
+
+        const int exponent = firstExponent + ((bucket - numLinearBuckets) >> subBucketBits);
+        const uint64_t subBucket = (bucket - numLinearBuckets) & ((1 << subBucketBits) - 1);
+        return (((uint64_t { 1 } << subBucketBits) + subBucket + 1) << (exponent - subBucketBits)) - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, numBuckets> buckets {};
+    std::atomic<uint64_t> count { 0 };
+    std::atomic<uint64_t> max { 0 };
+};
+}
@@ -24,7 +24,7 @@
 #include "LinearEnvelope.h"
 #include "SIMDHelpers.h"
 #include "MathHelpers.h"
-#include <absl/algorithm/container.h>
+#include <algorithm>
 
 namespace sfz {
 
@@ -35,7 +35,7 @@ LinearEnvelope<Type>::LinearEnvelope()
 }
 
 template <class Type>
-LinearEnvelope<Type>::LinearEnvelope(int maxCapacity, std::function<Type(Type)> function)
+LinearEnvelope<Type>::LinearEnvelope(int maxCapacity, Function function)
 {
     setMaxCapacity(maxCapacity);
     setFunction(function);
@@ -49,7 +49,7 @@ void LinearEnvelope<Type>::setMaxCapacity(int maxCapacity)
 }
 
 template <class Type>
-void LinearEnvelope<Type>::setFunction(std::function<Type(Type)> function)
+void LinearEnvelope<Type>::setFunction(Function function) noexcept
 {
     this->function = function;
 }
@@ -57,8 +57,14 @@ void LinearEnvelope<Type>::setFunction(std::function<Type(Type)> function)
 template <class Type>
 void LinearEnvelope<Type>::registerEvent(int timestamp, Type inputValue)
 {
-    if (static_cast<int>(events.size()) < maxCapacity)
-        events.emplace_back(timestamp, function(inputValue));
+    if (static_cast<int>(events.size()) >= maxCapacity)
+        return;
+
+    // Keep the events in time order; they usually come in order, so this appends
+    const auto position = std::upper_bound(events.begin(), events.end(), timestamp, [](int timestamp, const auto& event) {
+        return timestamp < event.first;
+    });
+    events.emplace(position, timestamp, function(inputValue));
 }
 
 template <class Type>
@@ -77,9 +83,6 @@ void LinearEnvelope<Type>::reset(Type value)
 template <class Type>
 void LinearEnvelope<Type>::getBlock(absl::Span<Type> output)
 {
-    absl::c_sort(events, [](const auto& lhs, const auto& rhs) {
-        return lhs.first < rhs.first;
-    });
     int index { 0 };
 
     for (auto& event : events) {
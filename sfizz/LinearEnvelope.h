@@ -25,7 +25,6 @@
 #include "Config.h"
 #include "LeakDetector.h"
 #include <absl/types/span.h>
-#include <functional>
 #include <type_traits>
 
 namespace sfz {
@@ -33,16 +32,21 @@ namespace sfz {
 template <class Type>
 class LinearEnvelope {
 public:
+    /**
+     * A plain function pointer rather than a std::function, which could allocate
+     * when set from the audio thread
+     */
+    using Function = Type (*)(Type);
     LinearEnvelope();
-    LinearEnvelope(int maxCapacity, std::function<Type(Type)> function);
+    LinearEnvelope(int maxCapacity, Function function);
     void setMaxCapacity(int maxCapacity);
-    void setFunction(std::function<Type(Type)> function);
+    void setFunction(Function function) noexcept;
     void registerEvent(int timestamp, Type inputValue);
     void clear();
     void reset(Type value = 0.0);
     void getBlock(absl::Span<Type> output);
 private:
-    std::function<Type(Type)> function { [](Type input) { return input; } };
+    Function function { [](Type input) { return input; } };
     static_assert(std::is_arithmetic<Type>::value);
     std::vector<std::pair<int, Type>> events;
     int maxCapacity { config::defaultSamplesPerBlock };
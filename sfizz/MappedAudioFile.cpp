@@ -0,0 +1,245 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "MappedAudioFile.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SFIZZ_HAVE_MMAP
+#endif
+
+namespace {
+constexpr uint16_t wavFormatPCM { 0x0001 };
+constexpr uint16_t wavFormatFloat { 0x0003 };
+constexpr uint16_t wavFormatExtensible { 0xFFFE };
+
+inline uint16_t readLE16(const uint8_t* bytes) noexcept
+{
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+inline uint32_t readLE32(const uint8_t* bytes) noexcept
+{
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8)
+        | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+// The conversions follow the libsndfile normalization so that both backends agree
+template <class Convert>
+void convertFrames(const uint8_t* source, uint32_t bytesPerFrame, int sampleSize, uint32_t numFrames, AudioSpan<float> output, int numChannels, Convert&& convert) noexcept
+{
+    for (int channelIndex = 0; channelIndex < numChannels; ++channelIndex) {
+        const uint8_t* sample = source + channelIndex * sampleSize;
+        float* out = output.getChannel(channelIndex);
+        const float* sentinel = out + numFrames;
+        while (out < sentinel) {
+            *out++ = convert(sample);
+            sample += bytesPerFrame;
+        }
+    }
+}
+}
+
+sfz::MappedAudioFile::~MappedAudioFile()
+{
+    close();
+}
+
+bool sfz::MappedAudioFile::open(const std::filesystem::path& path [[maybe_unused]]) noexcept
+{
+    close();
+#ifdef SFIZZ_HAVE_MMAP
+    const int fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+        return false;
+
+    struct stat fileStatus;
+    if (::fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < 44) {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    mappingSize = static_cast<size_t>(fileStatus.st_size);
+    mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fileDescriptor);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        mappingSize = 0;
+        return false;
+    }
+
+    if (!parseHeader()) {
+        close();
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void sfz::MappedAudioFile::close() noexcept
+{
+#ifdef SFIZZ_HAVE_MMAP
+    if (mapping != nullptr)
+        ::munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    sampleData = nullptr;
+    numChannels = 0;
+    numFrames = 0;
+    bytesPerFrame = 0;
+    rate = 0.0;
+}
+
+bool sfz::MappedAudioFile::parseHeader() noexcept
+{
+    const auto* bytes = static_cast<const uint8_t*>(mapping);
+    if (std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool hasFormat { false };
+    int sampleSize { 0 };
+    size_t position { 12 };
+    while (position + 8 <= mappingSize) {
+        const uint8_t* chunk = bytes + position;
+        const size_t chunkSize = readLE32(chunk + 4);
+        const size_t chunkStart = position + 8;
+        const size_t available = std::min(chunkSize, mappingSize - chunkStart);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (available < 16)
+                return false;
+
+            auto formatTag = readLE16(chunk + 8);
+            numChannels = readLE16(chunk + 10);
+            rate = static_cast<double>(readLE32(chunk + 12));
+            bytesPerFrame = readLE16(chunk + 20);
+            const auto bitsPerSample = readLE16(chunk + 22);
+            if (formatTag == wavFormatExtensible) {
+                if (available < 40)
+                    return false;
+                // The subformat GUID starts with the actual format tag
+                formatTag = readLE16(chunk + 32);
+            }
+
+            sampleSize = (bitsPerSample + 7) / 8;
+            if (formatTag == wavFormatFloat && bitsPerSample == 32)
+                format = SampleFormat::Float32;
+            else if (formatTag == wavFormatPCM && bitsPerSample == 8)
+                format = SampleFormat::Int8;
+            else if (formatTag == wavFormatPCM && bitsPerSample == 16)
+                format = SampleFormat::Int16;
+            else if (formatTag == wavFormatPCM && bitsPerSample == 24)
+                format = SampleFormat::Int24;
+            else if (formatTag == wavFormatPCM && bitsPerSample == 32)
+                format = SampleFormat::Int32;
+            else
+                return false;
+
+            if (numChannels == 0 || bytesPerFrame < static_cast<uint32_t>(numChannels * sampleSize))
+                return false;
+
+            hasFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            // The format always comes before the data in a valid file
+            if (!hasFormat)
+                return false;
+
+            sampleData = bytes + chunkStart;
+            numFrames = static_cast<uint32_t>(available / bytesPerFrame);
+            return true;
+        }
+
+        position = chunkStart + chunkSize + (chunkSize & 1);
+    }
+
+    return false;
+}
+
+void sfz::MappedAudioFile::prefetch(uint32_t startFrame [[maybe_unused]], uint32_t numFramesToPrefetch [[maybe_unused]]) const noexcept
+{
+#ifdef SFIZZ_HAVE_MMAP
+    if (sampleData == nullptr || startFrame >= numFrames)
+        return;
+
+    numFramesToPrefetch = std::min(numFramesToPrefetch, numFrames - startFrame);
+    static const auto pageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const auto start = reinterpret_cast<uintptr_t>(sampleData + static_cast<size_t>(startFrame) * bytesPerFrame);
+    const auto end = start + static_cast<size_t>(numFramesToPrefetch) * bytesPerFrame;
+    const auto alignedStart = start & ~(pageSize - 1);
+    ::madvise(reinterpret_cast<void*>(alignedStart), end - alignedStart, MADV_WILLNEED);
+#endif
+}
+
+uint32_t sfz::MappedAudioFile::read(uint32_t startFrame, AudioSpan<float> output) const noexcept
+{
+    if (sampleData == nullptr || startFrame >= numFrames)
+        return 0;
+
+    const auto numFramesToRead = static_cast<uint32_t>(std::min<size_t>(output.getNumFrames(), numFrames - startFrame));
+    const auto numOutputChannels = std::min(numChannels, static_cast<int>(output.getNumChannels()));
+    const uint8_t* source = sampleData + static_cast<size_t>(startFrame) * bytesPerFrame;
+
+    switch (format) {
+    case SampleFormat::Int8:
+        // 8 bit WAV data is unsigned
+        convertFrames(source, bytesPerFrame, 1, numFramesToRead, output, numOutputChannels, [](const uint8_t* sample) {
+            return static_cast<float>(static_cast<int>(sample[0]) - 128) / 128.0f;
+        });
+        break;
+    case SampleFormat::Int16:
+        convertFrames(source, bytesPerFrame, 2, numFramesToRead, output, numOutputChannels, [](const uint8_t* sample) {
+            return static_cast<float>(static_cast<int16_t>(readLE16(sample))) / 32768.0f;
+        });
+        break;
+    case SampleFormat::Int24:
+        convertFrames(source, bytesPerFrame, 3, numFramesToRead, output, numOutputChannels, [](const uint8_t* sample) {
+            const auto value = static_cast<int32_t>((static_cast<uint32_t>(sample[0]) << 8) | (static_cast<uint32_t>(sample[1]) << 16) | (static_cast<uint32_t>(sample[2]) << 24));
+            return static_cast<float>(value) / 2147483648.0f;
+        });
+        break;
+    case SampleFormat::Int32:
+        convertFrames(source, bytesPerFrame, 4, numFramesToRead, output, numOutputChannels, [](const uint8_t* sample) {
+            return static_cast<float>(static_cast<int32_t>(readLE32(sample))) / 2147483648.0f;
+        });
+        break;
+    case SampleFormat::Float32:
+        convertFrames(source, bytesPerFrame, 4, numFramesToRead, output, numOutputChannels, [](const uint8_t* sample) {
+            const auto bits = readLE32(sample);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        });
+        break;
+    }
+
+    return numFramesToRead;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "AudioSpan.h"
+#include "LeakDetector.h"
+#include "filesystem.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace sfz {
+/**
+ * Read-only memory mapping of an uncompressed WAV file (integer PCM or 32 bit float).
+ * Reading from the mapping skips the libsndfile calls entirely and lets the OS share
+ * the pages between all the processes using the same samples. Opening fails for
+ * anything else, in which case the caller should fall back to libsndfile.
+ */
+class MappedAudioFile {
+public:
+    MappedAudioFile() = default;
+    ~MappedAudioFile();
+    MappedAudioFile(const MappedAudioFile&) = delete;
+    MappedAudioFile& operator=(const MappedAudioFile&) = delete;
+
+    bool open(const std::filesystem::path& path) noexcept;
+    void close() noexcept;
+    bool isOpen() const noexcept { return mapping != nullptr; }
+
+    int channels() const noexcept { return numChannels; }
+    uint32_t frames() const noexcept { return numFrames; }
+    double sampleRate() const noexcept { return rate; }
+    /**
+     * Asks the OS to start paging in a range of frames ahead of a read.
+     */
+    void prefetch(uint32_t startFrame, uint32_t numFramesToPrefetch) const noexcept;
+    /**
+     * Converts frames to floats into the output channels, deinterleaving if needed.
+     * A mono file only fills the first output channel.
+     *
+     * @return the number of frames read, which may be less than requested at the end of the file
+     */
+    uint32_t read(uint32_t startFrame, AudioSpan<float> output) const noexcept;
+private:
+    enum class SampleFormat {
+        Int8,
+        Int16,
+        Int24,
+        Int32,
+        Float32
+    };
+    bool parseHeader() noexcept;
+    void* mapping { nullptr };
+    size_t mappingSize { 0 };
+    const uint8_t* sampleData { nullptr };
+    SampleFormat format { SampleFormat::Int16 };
+    int numChannels { 0 };
+    uint32_t numFrames { 0 };
+    uint32_t bytesPerFrame { 0 };
+    double rate { 0.0 };
+    LEAK_DETECTOR(MappedAudioFile);
+};
+}
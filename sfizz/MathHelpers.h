@@ -32,6 +32,8 @@ template <class T>
 inline constexpr T min(T op1, T op2, T op3) { return std::min(op1, std::min(op2, op3)); }
 template <class T>
 inline constexpr T min(T op1, T op2, T op3, T op4) { return std::min(op1, std::min(op2, std::min(op3, op4))); }
+template <class T>
+inline constexpr T min(T op1, T op2, T op3, T op4, T op5) { return std::min(op1, min(op2, op3, op4, op5)); }
 
 
 template <class Type>
@@ -37,6 +37,124 @@ void removeCommentOnLine(std::string_view& line)
         line.remove_suffix(line.size() - position);
 }
 
+namespace {
+constexpr std::string_view whitespaceCharacters { " \r\t\n\f\v" };
+
+inline bool isWhitespace(char c) noexcept
+{
+    return whitespaceCharacters.find(c) != whitespaceCharacters.npos;
+}
+
+inline bool isAlphanumeric(char c) noexcept
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+inline bool isIdentifier(char c) noexcept
+{
+    return isAlphanumeric(c) || c == '_';
+}
+
+inline bool isValue(char c) noexcept
+{
+    constexpr std::string_view valuePunctuation { "-#./\\(),*" };
+    return isIdentifier(c) || isWhitespace(c) || valuePunctuation.find(c) != valuePunctuation.npos;
+}
+
+template <class Predicate>
+size_t skip(std::string_view text, size_t position, Predicate&& predicate) noexcept
+{
+    while (position < text.size() && predicate(text[position]))
+        position++;
+    return position;
+}
+}
+
+std::optional<std::string_view> sfz::Lexer::readInclude(std::string_view line) noexcept
+{
+    constexpr std::string_view directive { "#include" };
+    for (auto position = line.find(directive); position != line.npos; position = line.find(directive, position + 1)) {
+        const auto quote = skip(line, position + directive.size(), isWhitespace);
+        if (quote == line.size() || line[quote] != '"')
+            continue;
+
+        const auto closingQuote = line.find('"', quote + 1);
+        if (closingQuote != line.npos)
+            return line.substr(quote + 1, closingQuote - quote - 1);
+    }
+    return {};
+}
+
+std::optional<std::pair<std::string_view, std::string_view>> sfz::Lexer::readDefine(std::string_view line) noexcept
+{
+    constexpr std::string_view directive { "#define" };
+    for (auto position = line.find(directive); position != line.npos; position = line.find(directive, position + 1)) {
+        const auto variableStart = skip(line, position + directive.size(), isWhitespace);
+        if (variableStart == line.size() || line[variableStart] != sfz::config::defineCharacter)
+            continue;
+
+        const auto variableEnd = skip(line, variableStart + 1, isAlphanumeric);
+        const auto valueStart = skip(line, variableEnd, isWhitespace);
+        if (variableEnd == variableStart + 1 || valueStart == variableEnd)
+            continue;
+
+        const auto valueEnd = skip(line, valueStart, isAlphanumeric);
+        if (valueEnd == valueStart || (valueEnd < line.size() && !isWhitespace(line[valueEnd])))
+            continue;
+
+        return std::make_pair(line.substr(variableStart, variableEnd - variableStart), line.substr(valueStart, valueEnd - valueStart));
+    }
+    return {};
+}
+
+bool sfz::Lexer::readHeader(std::string_view& content, std::string_view& header, std::string_view& members) noexcept
+{
+    const auto headerStart = content.find('<');
+    if (headerStart == content.npos)
+        return false;
+
+    const auto headerEnd = content.find('>', headerStart + 1);
+    if (headerEnd == content.npos)
+        return false;
+
+    const auto membersEnd = std::min(content.find('<', headerEnd + 1), content.size());
+    header = content.substr(headerStart + 1, headerEnd - headerStart - 1);
+    members = content.substr(headerEnd + 1, membersEnd - headerEnd - 1);
+    content.remove_prefix(membersEnd);
+    return true;
+}
+
+bool sfz::Lexer::readMember(std::string_view& members, std::string_view& opcode, std::string_view& value) noexcept
+{
+    for (auto equal = members.find('='); equal != members.npos; equal = members.find('=', equal + 1)) {
+        auto opcodeStart = equal;
+        while (opcodeStart > 0 && isIdentifier(members[opcodeStart - 1]))
+            opcodeStart--;
+
+        if (opcodeStart == equal)
+            continue;
+
+        const auto valueStart = equal + 1;
+        auto valueEnd = skip(members, valueStart, isValue);
+        if (valueEnd < members.size() && members[valueEnd] == '=') {
+            // The value stops before the separator preceding the next opcode
+            while (valueEnd > valueStart && isIdentifier(members[valueEnd - 1]))
+                valueEnd--;
+            if (valueEnd > valueStart)
+                valueEnd--;
+        }
+
+        if (valueEnd == valueStart)
+            continue;
+
+        opcode = members.substr(opcodeStart, equal - opcodeStart);
+        value = members.substr(valueStart, valueEnd - valueStart);
+        members.remove_prefix(valueEnd);
+        return true;
+    }
+    return false;
+}
+
 bool sfz::Parser::loadSfzFile(const std::filesystem::path& file)
 {
     const auto sfzFile = file.is_absolute() ? file : rootDirectory / file;
@@ -44,6 +162,132 @@ bool sfz::Parser::loadSfzFile(const std::filesystem::path& file)
         return false;
 
     rootDirectory = file.parent_path();
+    if (regexParsing) {
+        parseWithRegexes(file);
+        return true;
+    }
+
+    aggregatedContent.clear();
+    preprocessFile(file);
+    parseContent();
+    return true;
+}
+
+void sfz::Parser::restoreParsedState(const std::filesystem::path& file, std::map<std::string, std::string> newDefines, std::vector<std::filesystem::path> newIncludedFiles)
+{
+    rootDirectory = file.parent_path();
+    aggregatedContent.clear();
+    defines = std::move(newDefines);
+    includedFiles = std::move(newIncludedFiles);
+}
+
+void sfz::Parser::preprocessFile(const std::filesystem::path& fileName) noexcept
+{
+    std::ifstream fileStream(fileName.c_str(), std::ios::binary | std::ios::ate);
+    if (!fileStream)
+        return;
+
+    const auto fileSize = fileStream.tellg();
+    if (fileSize < 0)
+        return;
+
+    // Read the whole file at once and work on views of it
+    std::string fileContent(static_cast<size_t>(fileSize), '\0');
+    fileStream.seekg(0);
+    fileStream.read(fileContent.data(), fileContent.size());
+    fileContent.resize(static_cast<size_t>(fileStream.gcount()));
+    aggregatedContent.reserve(aggregatedContent.size() + fileContent.size());
+
+    std::string_view remainingContent { fileContent };
+    while (!remainingContent.empty()) {
+        const auto lineEnd = std::min(remainingContent.find('\n'), remainingContent.size());
+        std::string_view line = remainingContent.substr(0, lineEnd);
+        remainingContent.remove_prefix(std::min(lineEnd + 1, remainingContent.size()));
+
+        removeCommentOnLine(line);
+        trimInPlace(line);
+
+        if (line.empty())
+            continue;
+
+        if (const auto include = Lexer::readInclude(line)) {
+            std::string includePath { *include };
+            std::replace(includePath.begin(), includePath.end(), '\\', '/');
+            const auto newFile = rootDirectory / includePath;
+            auto alreadyIncluded = std::find(includedFiles.begin(), includedFiles.end(), newFile);
+            if (std::filesystem::exists(newFile)) {
+                if (alreadyIncluded == includedFiles.end()) {
+                    includedFiles.push_back(newFile);
+                    preprocessFile(newFile);
+                } else if (!recursiveIncludeGuard) {
+                    preprocessFile(newFile);
+                }
+            }
+            continue;
+        }
+
+        if (const auto define = Lexer::readDefine(line)) {
+            defines[std::string(define->first)] = std::string(define->second);
+            continue;
+        }
+
+        appendLine(line);
+    }
+}
+
+void sfz::Parser::appendLine(std::string_view line)
+{
+    if (!aggregatedContent.empty())
+        aggregatedContent += ' ';
+
+    // Replace defined variables starting with $
+    std::string_view::size_type lastPos = 0;
+    std::string_view::size_type findPos = line.find(sfz::config::defineCharacter, lastPos);
+
+    while (findPos < line.npos) {
+        aggregatedContent.append(line, lastPos, findPos - lastPos);
+
+        const auto defineEnd = line.find_first_of("= \r\t\n\f\v", findPos);
+        const auto candidate = line.substr(findPos, defineEnd - findPos);
+        for (auto& definePair : defines) {
+            if (candidate == definePair.first) {
+                aggregatedContent += definePair.second;
+                lastPos = findPos + definePair.first.length();
+                break;
+            }
+        }
+
+        if (lastPos <= findPos) {
+            aggregatedContent += sfz::config::defineCharacter;
+            lastPos = findPos + 1;
+        }
+
+        findPos = line.find(sfz::config::defineCharacter, lastPos);
+    }
+
+    aggregatedContent += line.substr(lastPos);
+}
+
+void sfz::Parser::parseContent()
+{
+    std::string_view content { aggregatedContent };
+    std::string_view header;
+    std::string_view members;
+    std::string_view opcode;
+    std::string_view value;
+    std::vector<Opcode> currentMembers;
+
+    while (Lexer::readHeader(content, header, members)) {
+        while (Lexer::readMember(members, opcode, value))
+            currentMembers.emplace_back(opcode, value);
+
+        callback(header, currentMembers);
+        currentMembers.clear();
+    }
+}
+
+void sfz::Parser::parseWithRegexes(const std::filesystem::path& file)
+{
     std::vector<std::string> lines;
     readSfzFile(file, lines);
 
@@ -73,8 +317,6 @@ bool sfz::Parser::loadSfzFile(const std::filesystem::path& file)
         callback(header, currentMembers);
         currentMembers.clear();
     }
-
-    return true;
 }
 
 void sfz::Parser::readSfzFile(const std::filesystem::path& fileName, std::vector<std::string>& lines) noexcept
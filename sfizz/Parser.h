@@ -25,6 +25,7 @@
 #include "Opcode.h"
 #include "filesystem.h"
 #include <map>
+#include <optional>
 #include <regex>
 #include <string>
 #include <string_view>
@@ -39,6 +40,22 @@ namespace Regexes {
     inline static std::regex opcodeParameters { R"(([a-zA-Z0-9_]+?)([0-9]+)$)", std::regex::optimize };
 }
 
+/**
+ * Single-pass equivalents of the regexes above, returning views into their input.
+ */
+namespace Lexer {
+    std::optional<std::string_view> readInclude(std::string_view line) noexcept;
+    std::optional<std::pair<std::string_view, std::string_view>> readDefine(std::string_view line) noexcept;
+    /**
+     * Reads the next header and its members, and consumes them from the content.
+     */
+    bool readHeader(std::string_view& content, std::string_view& header, std::string_view& members) noexcept;
+    /**
+     * Reads the next opcode and its value, and consumes them from the members.
+     */
+    bool readMember(std::string_view& members, std::string_view& opcode, std::string_view& value) noexcept;
+}
+
 class Parser {
 public:
     virtual bool loadSfzFile(const std::filesystem::path& file);
@@ -46,17 +63,30 @@ public:
     const std::vector<std::filesystem::path>& getIncludedFiles() const noexcept { return includedFiles; }
     void disableRecursiveIncludeGuard() { recursiveIncludeGuard = false; }
     void enableRecursiveIncludeGuard() { recursiveIncludeGuard = true; }
+    // The regex-based parser is kept as a reference for testing
+    void enableRegexParsing() { regexParsing = true; }
+    void disableRegexParsing() { regexParsing = false; }
 
 protected:
     virtual void callback(std::string_view header, const std::vector<Opcode>& members) = 0;
     std::filesystem::path rootDirectory { std::filesystem::current_path() };
+    /**
+     * Restores the state left by parsing a file without parsing it again,
+     * for a derived class replaying a previous parse.
+     */
+    void restoreParsedState(const std::filesystem::path& file, std::map<std::string, std::string> newDefines, std::vector<std::filesystem::path> newIncludedFiles);
 
 private:
     bool recursiveIncludeGuard { false };
+    bool regexParsing { false };
     std::map<std::string, std::string> defines;
     std::vector<std::filesystem::path> includedFiles;
     std::string aggregatedContent {};
     void readSfzFile(const std::filesystem::path& fileName, std::vector<std::string>& lines) noexcept;
+    void parseWithRegexes(const std::filesystem::path& file);
+    void preprocessFile(const std::filesystem::path& fileName) noexcept;
+    void appendLine(std::string_view line);
+    void parseContent();
 };
 
 } // namespace sfz
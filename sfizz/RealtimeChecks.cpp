@@ -0,0 +1,101 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "RealtimeChecks.h"
+
+#ifdef SFIZZ_REALTIME_CHECKS
+#include "Debug.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local int realtimeDepth { 0 };
+
+void* allocate(std::size_t size) noexcept
+{
+    ASSERT(realtimeDepth == 0);
+    while (true) {
+        if (auto pointer = std::malloc(size > 0 ? size : 1))
+            return pointer;
+
+        // The library is built without exceptions, so failing for good aborts
+        auto handler = std::get_new_handler();
+        if (handler == nullptr)
+            std::abort();
+        handler();
+    }
+}
+
+void deallocate(void* pointer) noexcept
+{
+    ASSERT(pointer == nullptr || realtimeDepth == 0);
+    std::free(pointer);
+}
+}
+
+sfz::ScopedRealtimeSection::ScopedRealtimeSection() noexcept
+{
+    realtimeDepth++;
+}
+
+sfz::ScopedRealtimeSection::~ScopedRealtimeSection() noexcept
+{
+    realtimeDepth--;
+}
+
+bool sfz::ScopedRealtimeSection::isActive() noexcept
+{
+    return realtimeDepth > 0;
+}
+
+sfz::ScopedRealtimeExemption::ScopedRealtimeExemption() noexcept
+    : depth(realtimeDepth)
+{
+    realtimeDepth = 0;
+}
+
+sfz::ScopedRealtimeExemption::~ScopedRealtimeExemption() noexcept
+{
+    realtimeDepth = depth;
+}
+
+// The replacements are weak so that a program replacing these operators itself keeps its own,
+// without the checks. The other forms go through the plain ones, and the aligned ones are left
+// to the standard library.
+#if defined(__GNUC__) || defined(__clang__)
+#define SFIZZ_WEAK __attribute__((weak))
+#else
+#define SFIZZ_WEAK
+#endif
+
+SFIZZ_WEAK void* operator new(std::size_t size) { return allocate(size); }
+SFIZZ_WEAK void operator delete(void* pointer) noexcept { deallocate(pointer); }
+SFIZZ_WEAK void* operator new[](std::size_t size) { return ::operator new(size); }
+SFIZZ_WEAK void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return ::operator new(size); }
+SFIZZ_WEAK void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return ::operator new(size); }
+SFIZZ_WEAK void operator delete[](void* pointer) noexcept { ::operator delete(pointer); }
+SFIZZ_WEAK void operator delete(void* pointer, std::size_t) noexcept { ::operator delete(pointer); }
+SFIZZ_WEAK void operator delete[](void* pointer, std::size_t) noexcept { ::operator delete(pointer); }
+SFIZZ_WEAK void operator delete(void* pointer, const std::nothrow_t&) noexcept { ::operator delete(pointer); }
+SFIZZ_WEAK void operator delete[](void* pointer, const std::nothrow_t&) noexcept { ::operator delete(pointer); }
+#endif
@@ -0,0 +1,65 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+namespace sfz {
+/**
+ * Marks the audio path of the calling thread while alive. Built with SFIZZ_REALTIME_CHECKS,
+ * which the debug builds define by default, the library replaces the global operator new
+ * and delete so that they trip an assertion inside such a section, and the buffers check
+ * their own allocations the same way. Otherwise the sections compile to nothing.
+ */
+class ScopedRealtimeSection {
+public:
+#ifdef SFIZZ_REALTIME_CHECKS
+    ScopedRealtimeSection() noexcept;
+    ~ScopedRealtimeSection() noexcept;
+    static bool isActive() noexcept;
+#else
+    ScopedRealtimeSection() noexcept { }
+    static constexpr bool isActive() noexcept { return false; }
+#endif
+    ScopedRealtimeSection(const ScopedRealtimeSection&) = delete;
+    ScopedRealtimeSection& operator=(const ScopedRealtimeSection&) = delete;
+};
+
+/**
+ * Lifts the checks of the enclosing realtime sections while alive. The debug output
+ * uses it, since it only exists in debug builds.
+ */
+class ScopedRealtimeExemption {
+public:
+#ifdef SFIZZ_REALTIME_CHECKS
+    ScopedRealtimeExemption() noexcept;
+    ~ScopedRealtimeExemption() noexcept;
+private:
+    int depth;
+public:
+#else
+    ScopedRealtimeExemption() noexcept { }
+#endif
+    ScopedRealtimeExemption(const ScopedRealtimeExemption&) = delete;
+    ScopedRealtimeExemption& operator=(const ScopedRealtimeExemption&) = delete;
+};
+}
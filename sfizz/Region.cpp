@@ -610,6 +610,41 @@ void sfz::Region::registerTempo(float secondsPerQuarter) noexcept
         bpmSwitched = false;
 }
 
+bool sfz::Region::isAffectedByNote(int noteNumber) const noexcept
+{
+    if (keyRange.containsWithEnd(noteNumber))
+        return true;
+
+    if (!keyswitchRange.containsWithEnd(noteNumber))
+        return false;
+
+    // Any note in the keyswitch range can change the last keyswitch
+    if (keyswitch)
+        return true;
+
+    return (keyswitchDown && *keyswitchDown == noteNumber) || (keyswitchUp && *keyswitchUp == noteNumber);
+}
+
+bool sfz::Region::isAffectedByCC(int ccNumber) const noexcept
+{
+    return ccConditions.contains(ccNumber) || ccTriggers.contains(ccNumber);
+}
+
+bool sfz::Region::isAffectedByPitchWheel() const noexcept
+{
+    return !(bendRange == Default::bendRange);
+}
+
+bool sfz::Region::isAffectedByAftertouch() const noexcept
+{
+    return !(aftertouchRange == Default::aftertouchRange);
+}
+
+bool sfz::Region::isAffectedByTempo() const noexcept
+{
+    return !(bpmRange == Default::bpmRange);
+}
+
 float sfz::Region::getBasePitchVariation(int noteNumber, uint8_t velocity) noexcept
 {
     auto pitchVariationInCents = pitchKeytrack * (noteNumber - (int)pitchKeycenter); // note difference with pitch center
@@ -635,7 +670,7 @@ uint32_t sfz::Region::getOffset() noexcept
     return offset + offsetDistribution(Random::randomGenerator);
 }
 
-uint32_t sfz::Region::getDelay() noexcept
+float sfz::Region::getDelay() noexcept
 {
     return delay + delayDistribution(Random::randomGenerator);
 }
@@ -647,10 +682,10 @@ uint32_t sfz::Region::trueSampleEnd() const noexcept
 
 bool sfz::Region::canUsePreloadedData() const noexcept
 {
-    if (preloadedData == nullptr)
+    if (cachedSample == nullptr)
         return false;
 
-    return trueSampleEnd() < static_cast<uint32_t>(preloadedData->getNumFrames());
+    return trueSampleEnd() < cachedSample->numPreloadedFrames;
 }
 
 bool sfz::Region::isStereo() const noexcept
@@ -658,7 +693,7 @@ bool sfz::Region::isStereo() const noexcept
     if (isGenerator())
         return 1;
 
-    return (this->preloadedData->getNumChannels() == 2);
+    return (this->cachedSample->numChannels == 2);
 }
 
 template<class T, class U>
@@ -28,6 +28,7 @@
 #include "EGDescription.h"
 #include "Opcode.h"
 #include "AudioBuffer.h"
+#include "SampleCache.h"
 #include <bitset>
 #include <optional>
 #include <random>
@@ -53,6 +54,22 @@ struct Region {
     void registerPitchWheel(int channel, int pitch) noexcept;
     void registerAftertouch(int channel, uint8_t aftertouch) noexcept;
     void registerTempo(float secondsPerQuarter) noexcept;
+    /**
+     * @return true if the note can trigger the region or change its state (keyswitches,
+     * sequences, legato), in which case it must be registered on note events
+     */
+    bool isAffectedByNote(int noteNumber) const noexcept;
+    /**
+     * @return true if the CC can trigger the region or change its state
+     */
+    bool isAffectedByCC(int ccNumber) const noexcept;
+    /**
+     * @return true if the pitch wheel, aftertouch or tempo can switch the region off,
+     * in which case it must be registered on these events
+     */
+    bool isAffectedByPitchWheel() const noexcept;
+    bool isAffectedByAftertouch() const noexcept;
+    bool isAffectedByTempo() const noexcept;
     bool isStereo() const noexcept;
     float getBasePitchVariation(int noteNumber, uint8_t velocity) noexcept;
     float getNoteGain(int noteNumber, uint8_t velocity) noexcept;
@@ -61,7 +78,7 @@ struct Region {
     float getBaseGain() noexcept;
     float velocityCurve(uint8_t velocity) const noexcept;
     uint32_t getOffset() noexcept;
-    uint32_t getDelay() noexcept;
+    float getDelay() noexcept; // in seconds
     uint32_t trueSampleEnd() const noexcept;
     bool canUsePreloadedData() const noexcept;
     bool parseOpcode(const Opcode& opcode);
@@ -149,7 +166,7 @@ struct Region {
     EGDescription filterEG;
 
     double sampleRate { config::defaultSampleRate };
-    std::shared_ptr<AudioBuffer<float>> preloadedData { nullptr };
+    std::shared_ptr<CachedSample> cachedSample { nullptr };
 private:
     bool keySwitched { true };
     bool previousKeySwitched { true };
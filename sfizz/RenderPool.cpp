@@ -0,0 +1,207 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "RenderPool.h"
+#include "Debug.h"
+#include "RealtimeChecks.h"
+#include "ScopedFTZ.h"
+#include "SIMDHelpers.h"
+#include <algorithm>
+#include <chrono>
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#define SFIZZ_HAVE_PTHREAD_SCHEDULING
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+using namespace std::chrono_literals;
+
+namespace {
+// Workers keep spinning for a while after a job, since the next block is usually close,
+// and then poll at this interval; a job they miss is rendered by the audio thread
+constexpr auto workerSpinDuration { 2ms };
+constexpr auto workerPollInterval { 100us };
+
+bool setRealtimePriority(std::thread& thread) noexcept
+{
+#if defined(SFIZZ_HAVE_PTHREAD_SCHEDULING)
+    int policy { SCHED_OTHER };
+    sched_param parameters {};
+    if (pthread_getschedparam(pthread_self(), &policy, &parameters) != 0 || (policy != SCHED_FIFO && policy != SCHED_RR)) {
+        policy = SCHED_FIFO;
+        parameters.sched_priority = std::clamp(sfz::config::renderThreadPriority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+    }
+    return pthread_setschedparam(thread.native_handle(), policy, &parameters) == 0;
+#elif defined(_WIN32)
+    return SetThreadPriority(thread.native_handle(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#else
+    return false;
+#endif
+}
+}
+
+sfz::RenderPool::RenderPool()
+{
+    participants.push_back(std::make_unique<Participant>(samplesPerBlock));
+}
+
+sfz::RenderPool::~RenderPool()
+{
+    stopWorkers();
+}
+
+void sfz::RenderPool::stopWorkers() noexcept
+{
+    quitWorkers = true;
+    for (auto& worker : workers)
+        worker.join();
+    workers.clear();
+    participants.resize(1);
+    quitWorkers = false;
+}
+
+void sfz::RenderPool::setNumThreads(int numThreads, bool realtimeOnly) noexcept
+{
+    stopWorkers();
+    numThreads = std::clamp(numThreads, 0, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    for (int i = 0; i < numThreads; ++i)
+        participants.push_back(std::make_unique<Participant>(samplesPerBlock));
+    for (int i = 0; i < numThreads; ++i) {
+        workers.emplace_back(&RenderPool::workerThread, this, std::ref(*participants[i + 1]));
+        participants[i + 1]->realtime = setRealtimePriority(workers.back());
+    }
+
+    if (realtimeOnly && !hasRealtimeWorkers()) {
+        // Nothing is rendering yet, so the workers have not claimed anything
+        DBG("The render workers could not get a realtime priority and are stopped");
+        stopWorkers();
+    }
+    contributors.reserve(participants.size());
+}
+
+bool sfz::RenderPool::hasRealtimeWorkers() const noexcept
+{
+    return std::all_of(participants.begin() + 1, participants.end(), [](const auto& participant) {
+        return participant->realtime.load();
+    });
+}
+
+void sfz::RenderPool::setSamplesPerBlock(int samplesPerBlock) noexcept
+{
+    this->samplesPerBlock = samplesPerBlock;
+    // The workers only touch their buffers after claiming a voice, which they cannot do between blocks
+    for (auto& participant : participants) {
+        participant->accumulator.resize(samplesPerBlock);
+        participant->voiceBuffer.resize(samplesPerBlock);
+    }
+}
+
+void sfz::RenderPool::render(absl::Span<Voice* const> voices, AudioSpan<float> output) noexcept
+{
+    ASSERT(static_cast<int>(output.getNumFrames()) <= samplesPerBlock);
+    if (voices.empty())
+        return;
+
+    // Job 0 is the state of the participants that never rendered anything
+    if (++currentJob == 0)
+        ++currentJob;
+
+    jobVoices = voices.data();
+    jobNumFrames = output.getNumFrames();
+    numRenderedVoices.store(0, std::memory_order_relaxed);
+    claim.store(packClaim(currentJob, static_cast<uint32_t>(voices.size()), 0), std::memory_order_release);
+
+    // Only the voices the workers are rendering remain, which the audio thread cannot take over
+    renderClaimedVoices(*participants.front(), currentJob);
+    while (numRenderedVoices.load(std::memory_order_acquire) < voices.size())
+        std::this_thread::yield();
+
+    contributors.clear();
+    for (auto& participant : participants) {
+        if (participant->job.load(std::memory_order_relaxed) == currentJob)
+            contributors.push_back(participant.get());
+    }
+
+    // Pairwise sums keep the dependency chain short; AudioSpan::add follows SIMDConfig::add,
+    // which is off, so the vector add is called directly
+    for (size_t stride = 1; stride < contributors.size(); stride *= 2) {
+        for (size_t i = 0; i + stride < contributors.size(); i += 2 * stride) {
+            auto accumulator = AudioSpan<float>(contributors[i]->accumulator).first(jobNumFrames);
+            auto other = AudioSpan<float>(contributors[i + stride]->accumulator).first(jobNumFrames);
+            for (int channel = 0; channel < accumulator.getNumChannels(); ++channel)
+                add<float, true>(other.getConstSpan(channel), accumulator.getSpan(channel));
+        }
+    }
+
+    auto result = AudioSpan<float>(contributors.front()->accumulator).first(jobNumFrames);
+    output.add(result);
+}
+
+void sfz::RenderPool::renderClaimedVoices(Participant& participant, uint32_t job) noexcept
+{
+    ScopedRealtimeSection realtime;
+    bool firstVoice { true };
+    auto currentClaim = claim.load(std::memory_order_acquire);
+    while (jobOf(currentClaim) == job && nextVoiceOf(currentClaim) < numVoicesOf(currentClaim)) {
+        if (!claim.compare_exchange_weak(currentClaim, currentClaim + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            continue;
+
+        // Once a voice is claimed the job cannot end before it is rendered, so its data is stable
+        const auto numFrames = jobNumFrames;
+        auto accumulator = AudioSpan<float>(participant.accumulator).first(numFrames);
+        auto voiceBuffer = AudioSpan<float>(participant.voiceBuffer).first(numFrames);
+        if (firstVoice) {
+            accumulator.fill(0.0f);
+            participant.job.store(job, std::memory_order_relaxed);
+            firstVoice = false;
+        }
+
+        jobVoices[nextVoiceOf(currentClaim)]->renderBlock(voiceBuffer);
+        accumulator.add(voiceBuffer);
+        numRenderedVoices.fetch_add(1, std::memory_order_release);
+        currentClaim = claim.load(std::memory_order_acquire);
+    }
+}
+
+void sfz::RenderPool::workerThread(Participant& participant) noexcept
+{
+    ScopedFTZ ftz;
+    uint32_t lastJob { jobOf(claim.load(std::memory_order_acquire)) };
+    auto lastJobTime = std::chrono::steady_clock::now();
+    while (!quitWorkers) {
+        const auto job = jobOf(claim.load(std::memory_order_acquire));
+        if (job != lastJob) {
+            lastJob = job;
+            renderClaimedVoices(participant, job);
+            lastJobTime = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        // A realtime worker would keep the other threads of its core from running
+        if (!participant.realtime && std::chrono::steady_clock::now() - lastJobTime < workerSpinDuration)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(workerPollInterval);
+    }
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "AudioBuffer.h"
+#include "AudioSpan.h"
+#include "Config.h"
+#include "LeakDetector.h"
+#include "Voice.h"
+#include "absl/types/span.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace sfz {
+/**
+ * Renders voices on a pool of worker threads along with the audio thread.
+ * Each block is a job whose voices are claimed one at a time through a single atomic
+ * counter, so that the work balances itself and the audio thread never waits on a lock:
+ * if the workers are late, it renders the voices itself. The audio thread does not wake
+ * the workers either; they poll for jobs, so publishing one is a single atomic store.
+ * A voice is claimed just before it is rendered, so there is never a claimed voice left
+ * to take back, and the audio thread only waits for the voices being rendered; this is
+ * bounded as long as the workers are not preempted, hence the realtime priority.
+ * Each thread accumulates its voices privately, and the accumulators are summed
+ * pairwise at the end of the block.
+ */
+class RenderPool {
+public:
+    RenderPool();
+    ~RenderPool();
+    RenderPool(const RenderPool&) = delete;
+    RenderPool& operator=(const RenderPool&) = delete;
+
+    /**
+     * Starts or stops workers; 0 renders everything on the calling thread.
+     * Not realtime-safe, and it must not be called while rendering.
+     *
+     * The audio thread waits for the voices the workers claimed, so the workers get a
+     * realtime priority: the one of the calling thread if it has one, or else SCHED_FIFO
+     * at config::renderThreadPriority. The workers the system refuses it to are stopped
+     * unless realtimeOnly is false, which only suits offline rendering; getNumThreads
+     * tells how many were kept.
+     */
+    void setNumThreads(int numThreads, bool realtimeOnly = true) noexcept;
+    int getNumThreads() const noexcept { return static_cast<int>(workers.size()); }
+    /**
+     * @return false if some workers run without a realtime priority, in which case a
+     * preempted worker can delay the audio thread
+     */
+    bool hasRealtimeWorkers() const noexcept;
+    void setSamplesPerBlock(int samplesPerBlock) noexcept;
+    /**
+     * Renders the voices and adds them to the output, returning once all are done.
+     */
+    void render(absl::Span<Voice* const> voices, AudioSpan<float> output) noexcept;
+private:
+    struct Participant {
+        Participant(int samplesPerBlock)
+            : accumulator(config::numChannels, samplesPerBlock)
+            , voiceBuffer(config::numChannels, samplesPerBlock)
+        {
+        }
+        AudioBuffer<float> accumulator;
+        AudioBuffer<float> voiceBuffer;
+        // The last job this participant rendered voices for
+        std::atomic<uint32_t> job { 0 };
+        std::atomic<bool> realtime { false };
+    };
+    void renderClaimedVoices(Participant& participant, uint32_t job) noexcept;
+    void workerThread(Participant& participant) noexcept;
+    void stopWorkers() noexcept;
+
+    // Packs the job number, the number of voices and the next voice to claim, so that
+    // a worker late for a job cannot claim a voice of the next one
+    static constexpr uint64_t packClaim(uint32_t job, uint32_t numVoices, uint32_t nextVoice) noexcept
+    {
+        return (static_cast<uint64_t>(job) << 32) | (static_cast<uint64_t>(numVoices) << 16) | nextVoice;
+    }
+    static constexpr uint32_t jobOf(uint64_t claim) noexcept { return static_cast<uint32_t>(claim >> 32); }
+    static constexpr uint32_t numVoicesOf(uint64_t claim) noexcept { return static_cast<uint32_t>((claim >> 16) & 0xFFFF); }
+    static constexpr uint32_t nextVoiceOf(uint64_t claim) noexcept { return static_cast<uint32_t>(claim & 0xFFFF); }
+    static_assert(config::maxVoices + config::maxVoices / config::stolenVoicesDivider < 0xFFFF, "The voice indices must fit in 16 bits");
+
+    std::atomic<uint64_t> claim { 0 };
+    std::atomic<uint32_t> numRenderedVoices { 0 };
+    uint32_t currentJob { 0 };
+    Voice* const* jobVoices { nullptr };
+    size_t jobNumFrames { 0 };
+
+    int samplesPerBlock { config::defaultSamplesPerBlock };
+    // The first participant is the rendering thread itself
+    std::vector<std::unique_ptr<Participant>> participants;
+    std::vector<Participant*> contributors;
+    std::vector<std::thread> workers;
+    std::atomic<bool> quitWorkers { false };
+    LEAK_DETECTOR(RenderPool);
+};
+}
@@ -0,0 +1,493 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SIMDDispatch.h"
+#include "mathfuns/avx_mathfun.h"
+#include <immintrin.h>
+
+// The loads and stores are unaligned: on CPUs with AVX2 they are as fast as aligned
+// ones on aligned data, and the buffers are only aligned on 16 bytes anyway.
+constexpr size_t VectorSize { 8 };
+
+namespace {
+TARGET_AVX2 inline __m256 broadcastLast(__m256 vector) noexcept
+{
+    return _mm256_permutevar8x32_ps(vector, _mm256_set1_epi32(7));
+}
+
+TARGET_AVX2 inline __m256 prefixSum(__m256 vector) noexcept
+{
+    vector = _mm256_add_ps(vector, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(vector), 4)));
+    vector = _mm256_add_ps(vector, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(vector), 8)));
+    // Each 128-bit lane now holds its own prefix sum; carry the low one into the high one
+    const auto lowSum = _mm256_permutevar8x32_ps(vector, _mm256_set1_epi32(3));
+    return _mm256_add_ps(vector, _mm256_blend_ps(_mm256_setzero_ps(), lowSum, 0xF0));
+}
+
+template <class MathFunction, class ScalarFunction>
+TARGET_AVX2 inline void applyMathFunction(absl::Span<const float> input, absl::Span<float> output, MathFunction mathFunction, ScalarFunction scalarFunction) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    const auto size = std::min(input.size(), output.size());
+    auto* sentinel = in + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (in < lastVector) {
+        _mm256_storeu_ps(out, mathFunction(_mm256_loadu_ps(in)));
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (in < sentinel)
+        *out++ = scalarFunction(*in++);
+}
+
+TARGET_AVX2 inline __m256 sinVector(__m256 x) noexcept { return sin256_ps(x); }
+TARGET_AVX2 inline __m256 cosVector(__m256 x) noexcept { return cos256_ps(x); }
+TARGET_AVX2 inline __m256 expVector(__m256 x) noexcept { return exp256_ps(x); }
+TARGET_AVX2 inline __m256 logVector(__m256 x) noexcept { return log256_ps(x); }
+inline float sinScalar(float x) noexcept { return std::sin(x); }
+inline float cosScalar(float x) noexcept { return std::cos(x); }
+inline float expScalar(float x) noexcept { return std::exp(x); }
+inline float logScalar(float x) noexcept { return std::log(x); }
+}
+
+TARGET_AVX2 void avx2::exp(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    applyMathFunction(input, output, expVector, expScalar);
+}
+
+TARGET_AVX2 void avx2::log(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    applyMathFunction(input, output, logVector, logScalar);
+}
+
+TARGET_AVX2 void avx2::sin(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    applyMathFunction(input, output, sinVector, sinScalar);
+}
+
+TARGET_AVX2 void avx2::cos(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    applyMathFunction(input, output, cosVector, cosScalar);
+}
+
+TARGET_AVX2 void avx2::applyGain(float gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    const auto size = std::min(output.size(), input.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+    const auto mmGain = _mm256_set1_ps(gain);
+
+    while (out < lastVector) {
+        _mm256_storeu_ps(out, _mm256_mul_ps(mmGain, _mm256_loadu_ps(in)));
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetGain<float>(gain, in, out);
+}
+
+TARGET_AVX2 void avx2::applyGainSpan(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    ASSERT(gain.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    auto* g = gain.begin();
+    const auto size = min(output.size(), input.size(), gain.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_loadu_ps(g), _mm256_loadu_ps(in)));
+        g += VectorSize;
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetGainSpan<float>(g, in, out);
+}
+
+TARGET_AVX2 void avx2::multiplyAdd(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    ASSERT(gain.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    auto* g = gain.begin();
+    const auto size = min(output.size(), input.size(), gain.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        _mm256_storeu_ps(out, _mm256_fmadd_ps(_mm256_loadu_ps(g), _mm256_loadu_ps(in), _mm256_loadu_ps(out)));
+        g += VectorSize;
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetMultiplyAdd<float>(g, in, out);
+}
+
+TARGET_AVX2 float avx2::loopingSFZIndex(absl::Span<const float> jumps,
+    absl::Span<float> leftCoeffs,
+    absl::Span<float> rightCoeffs,
+    absl::Span<int> indices,
+    float floatIndex,
+    float loopEnd,
+    float loopStart) noexcept
+{
+    ASSERT(indices.size() >= jumps.size());
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+
+    auto index = indices.data();
+    auto leftCoeff = leftCoeffs.data();
+    auto rightCoeff = rightCoeffs.data();
+    auto jump = jumps.data();
+    const auto size = min(jumps.size(), indices.size(), leftCoeffs.size(), rightCoeffs.size());
+    const auto* sentinel = jump + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    auto mmFloatIndex = _mm256_set1_ps(floatIndex);
+    const auto mmJumpBack = _mm256_set1_ps(loopEnd - loopStart);
+    const auto mmLoopEnd = _mm256_set1_ps(loopEnd);
+    const auto mmRoundingOffset = _mm256_set1_ps(0.4999999552965164184570312f);
+    const auto mmOne = _mm256_set1_ps(1.0f);
+    while (jump < lastVector) {
+        mmFloatIndex = _mm256_add_ps(mmFloatIndex, prefixSum(_mm256_loadu_ps(jump)));
+        // A vector can span several rounds of a short loop
+        auto mmCompared = _mm256_cmp_ps(mmFloatIndex, mmLoopEnd, _CMP_GE_OQ);
+        do {
+            mmFloatIndex = _mm256_blendv_ps(mmFloatIndex, _mm256_sub_ps(mmFloatIndex, mmJumpBack), mmCompared);
+            mmCompared = _mm256_cmp_ps(mmFloatIndex, mmLoopEnd, _CMP_GE_OQ);
+        } while (loopEnd > loopStart && _mm256_movemask_ps(mmCompared) != 0);
+
+        const auto mmIndices = _mm256_cvtps_epi32(_mm256_sub_ps(mmFloatIndex, mmRoundingOffset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(index), mmIndices);
+
+        const auto mmRight = _mm256_sub_ps(mmFloatIndex, _mm256_cvtepi32_ps(mmIndices));
+        _mm256_storeu_ps(leftCoeff, _mm256_sub_ps(mmOne, mmRight));
+        _mm256_storeu_ps(rightCoeff, mmRight);
+
+        mmFloatIndex = broadcastLast(mmFloatIndex);
+        index += VectorSize;
+        jump += VectorSize;
+        leftCoeff += VectorSize;
+        rightCoeff += VectorSize;
+    }
+
+    floatIndex = _mm256_cvtss_f32(mmFloatIndex);
+    while (jump < sentinel)
+        snippetLoopingIndex<float>(jump, leftCoeff, rightCoeff, index, floatIndex, loopEnd, loopStart);
+    return floatIndex;
+}
+
+TARGET_AVX2 float avx2::saturatingSFZIndex(absl::Span<const float> jumps,
+    absl::Span<float> leftCoeffs,
+    absl::Span<float> rightCoeffs,
+    absl::Span<int> indices,
+    float floatIndex,
+    float loopEnd) noexcept
+{
+    ASSERT(indices.size() >= jumps.size());
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+
+    auto index = indices.data();
+    auto leftCoeff = leftCoeffs.data();
+    auto rightCoeff = rightCoeffs.data();
+    auto jump = jumps.data();
+    const auto size = min(jumps.size(), indices.size(), leftCoeffs.size(), rightCoeffs.size());
+    const auto* sentinel = jump + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    auto mmFloatIndex = _mm256_set1_ps(floatIndex);
+    const auto mmLoopEnd = _mm256_set1_ps(loopEnd);
+    const auto mmSaturated = _mm256_set1_ps(loopEnd - 0.000001f);
+    const auto mmRoundingOffset = _mm256_set1_ps(0.4999999552965164184570312f);
+    const auto mmOne = _mm256_set1_ps(1.0f);
+    while (jump < lastVector) {
+        mmFloatIndex = _mm256_add_ps(mmFloatIndex, prefixSum(_mm256_loadu_ps(jump)));
+        const auto mmCompared = _mm256_cmp_ps(mmFloatIndex, mmLoopEnd, _CMP_LT_OQ);
+        mmFloatIndex = _mm256_blendv_ps(mmSaturated, mmFloatIndex, mmCompared);
+
+        const auto mmIndices = _mm256_cvtps_epi32(_mm256_sub_ps(mmFloatIndex, mmRoundingOffset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(index), mmIndices);
+
+        const auto mmRight = _mm256_sub_ps(mmFloatIndex, _mm256_cvtepi32_ps(mmIndices));
+        _mm256_storeu_ps(leftCoeff, _mm256_sub_ps(mmOne, mmRight));
+        _mm256_storeu_ps(rightCoeff, mmRight);
+
+        mmFloatIndex = broadcastLast(mmFloatIndex);
+        index += VectorSize;
+        jump += VectorSize;
+        leftCoeff += VectorSize;
+        rightCoeff += VectorSize;
+    }
+
+    floatIndex = _mm256_cvtss_f32(mmFloatIndex);
+    while (jump < sentinel)
+        snippetSaturatingIndex<float>(jump, leftCoeff, rightCoeff, index, floatIndex, loopEnd);
+    return floatIndex;
+}
+
+TARGET_AVX2 void avx2::interpolateLinear(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+    ASSERT(indices.size() <= output.size());
+
+    auto* index = indices.begin();
+    auto* leftCoeff = leftCoeffs.begin();
+    auto* rightCoeff = rightCoeffs.begin();
+    auto* in = input.data();
+    auto* out = output.begin();
+    const auto size = min(indices.size(), leftCoeffs.size(), rightCoeffs.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    const auto mmOffsets = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    const auto mmOne = _mm256_set1_epi32(1);
+    while (out < lastVector) {
+        const auto mmIndices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index));
+        const auto mmContiguous = _mm256_add_epi32(_mm256_set1_epi32(index[0]), mmOffsets);
+        __m256 mmLeft;
+        __m256 mmRight;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(mmIndices, mmContiguous)) == -1) {
+            // The frames are contiguous when the pitch ratio is close to 1
+            mmLeft = _mm256_loadu_ps(in + index[0]);
+            mmRight = _mm256_loadu_ps(in + index[0] + 1);
+        } else {
+            mmLeft = _mm256_i32gather_ps(in, mmIndices, 4);
+            mmRight = _mm256_i32gather_ps(in, _mm256_add_epi32(mmIndices, mmOne), 4);
+        }
+        mmLeft = _mm256_mul_ps(mmLeft, _mm256_loadu_ps(leftCoeff));
+        _mm256_storeu_ps(out, _mm256_fmadd_ps(mmRight, _mm256_loadu_ps(rightCoeff), mmLeft));
+        index += VectorSize;
+        leftCoeff += VectorSize;
+        rightCoeff += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetInterpolateLinear<float>(index, leftCoeff, rightCoeff, in, out);
+}
+
+TARGET_AVX2 void avx2::interpolateHermite(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(indices.size() == coeffs.size());
+    ASSERT(indices.size() <= output.size());
+
+    auto* index = indices.begin();
+    auto* coeff = coeffs.begin();
+    auto* in = input.data();
+    auto* out = output.begin();
+    const auto size = min(indices.size(), coeffs.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    const auto mmOffsets = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    const auto mmOne = _mm256_set1_epi32(1);
+    // The 4 frames around each index have to be within the input
+    const auto mmLowest = _mm256_setzero_si256();
+    const auto mmHighest = _mm256_set1_epi32(static_cast<int>(input.size()) - 2);
+    while (out < lastVector) {
+        const auto mmIndices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index));
+        const auto mmInside = _mm256_and_si256(_mm256_cmpgt_epi32(mmIndices, mmLowest), _mm256_cmpgt_epi32(mmHighest, mmIndices));
+        if (_mm256_movemask_epi8(mmInside) != -1) {
+            for (size_t i = 0; i < VectorSize; ++i)
+                snippetInterpolateHermite<float>(index, coeff, input, out);
+            continue;
+        }
+
+        const auto mmContiguous = _mm256_add_epi32(_mm256_set1_epi32(index[0]), mmOffsets);
+        __m256 mmXm1;
+        __m256 mmX0;
+        __m256 mmX1;
+        __m256 mmX2;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(mmIndices, mmContiguous)) == -1) {
+            mmXm1 = _mm256_loadu_ps(in + index[0] - 1);
+            mmX0 = _mm256_loadu_ps(in + index[0]);
+            mmX1 = _mm256_loadu_ps(in + index[0] + 1);
+            mmX2 = _mm256_loadu_ps(in + index[0] + 2);
+        } else {
+            mmXm1 = _mm256_i32gather_ps(in, _mm256_sub_epi32(mmIndices, mmOne), 4);
+            mmX0 = _mm256_i32gather_ps(in, mmIndices, 4);
+            mmX1 = _mm256_i32gather_ps(in, _mm256_add_epi32(mmIndices, mmOne), 4);
+            mmX2 = _mm256_i32gather_ps(in, _mm256_add_epi32(mmIndices, _mm256_set1_epi32(2)), 4);
+        }
+
+        const auto mmHalf = _mm256_set1_ps(0.5f);
+        const auto mmC1 = _mm256_mul_ps(mmHalf, _mm256_sub_ps(mmX1, mmXm1));
+        auto mmC2 = _mm256_fnmadd_ps(_mm256_set1_ps(2.5f), mmX0, mmXm1);
+        mmC2 = _mm256_add_ps(mmC2, _mm256_add_ps(mmX1, mmX1));
+        mmC2 = _mm256_fnmadd_ps(mmHalf, mmX2, mmC2);
+        const auto mmC3 = _mm256_fmadd_ps(mmHalf, _mm256_sub_ps(mmX2, mmXm1), _mm256_mul_ps(_mm256_set1_ps(1.5f), _mm256_sub_ps(mmX0, mmX1)));
+        const auto mmT = _mm256_loadu_ps(coeff);
+        auto mmOutput = _mm256_fmadd_ps(mmC3, mmT, mmC2);
+        mmOutput = _mm256_fmadd_ps(mmOutput, mmT, mmC1);
+        mmOutput = _mm256_fmadd_ps(mmOutput, mmT, mmX0);
+        _mm256_storeu_ps(out, mmOutput);
+        index += VectorSize;
+        coeff += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetInterpolateHermite<float>(index, coeff, input, out);
+}
+
+namespace {
+// The products of the taps of one frame, to be summed
+TARGET_AVX2 inline __m256 sincProducts(const float* in, const float* taps, int numTaps, __m256 mmBlend) noexcept
+{
+    auto mmSum = _mm256_setzero_ps();
+    for (int k = 0; k < numTaps; k += VectorSize) {
+        const auto mmTaps = _mm256_fmadd_ps(mmBlend, _mm256_loadu_ps(taps + numTaps + k), _mm256_loadu_ps(taps + k));
+        mmSum = _mm256_fmadd_ps(_mm256_loadu_ps(in + k), mmTaps, mmSum);
+    }
+    return mmSum;
+}
+
+// Lane i of the result is the sum of the lanes of vectors[i]
+TARGET_AVX2 inline __m256 horizontalSums(const __m256* vectors) noexcept
+{
+    const auto sums0123 = _mm256_hadd_ps(_mm256_hadd_ps(vectors[0], vectors[1]), _mm256_hadd_ps(vectors[2], vectors[3]));
+    const auto sums4567 = _mm256_hadd_ps(_mm256_hadd_ps(vectors[4], vectors[5]), _mm256_hadd_ps(vectors[6], vectors[7]));
+    return _mm256_add_ps(_mm256_permute2f128_ps(sums0123, sums4567, 0x20), _mm256_permute2f128_ps(sums0123, sums4567, 0x31));
+}
+}
+
+TARGET_AVX2 void avx2::interpolateSinc(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept
+{
+    ASSERT(indices.size() == coeffs.size());
+    ASSERT(indices.size() <= output.size());
+    ASSERT(numTaps > 0 && table.size() % (2 * numTaps) == 0);
+
+    auto* index = indices.begin();
+    auto* coeff = coeffs.begin();
+    auto* in = input.data();
+    auto* out = output.begin();
+    const auto size = min(indices.size(), coeffs.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    // The taps are processed 8 at a time, so the shorter or odd kernels go the scalar way
+    if (numTaps % VectorSize != 0) {
+        while (out < sentinel)
+            snippetInterpolateSinc<float>(index, coeff, input, out, table, numTaps);
+        return;
+    }
+
+    const int numPhases = static_cast<int>(table.size()) / (2 * numTaps);
+    const int halfTaps = numTaps / 2;
+    const auto mmNumPhases = _mm256_set1_ps(static_cast<float>(numPhases));
+    const auto mmLastPhase = _mm256_set1_epi32(numPhases - 1);
+    // All the taps of each frame have to be within the input
+    const auto mmLowest = _mm256_set1_epi32(halfTaps - 2);
+    const auto mmHighest = _mm256_set1_epi32(static_cast<int>(input.size()) - halfTaps);
+    alignas(32) int phases[VectorSize];
+    alignas(32) float blends[VectorSize];
+    __m256 products[VectorSize];
+    while (out < lastVector) {
+        const auto mmIndices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index));
+        const auto mmInside = _mm256_and_si256(_mm256_cmpgt_epi32(mmIndices, mmLowest), _mm256_cmpgt_epi32(mmHighest, mmIndices));
+        if (_mm256_movemask_epi8(mmInside) != -1) {
+            for (size_t i = 0; i < VectorSize; ++i)
+                snippetInterpolateSinc<float>(index, coeff, input, out, table, numTaps);
+            continue;
+        }
+
+        // One horizontal sum for 8 frames, and the phases computed together
+        const auto mmPosition = _mm256_mul_ps(_mm256_loadu_ps(coeff), mmNumPhases);
+        const auto mmPhase = _mm256_min_epi32(_mm256_cvttps_epi32(mmPosition), mmLastPhase);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(phases), mmPhase);
+        _mm256_store_ps(blends, _mm256_sub_ps(mmPosition, _mm256_cvtepi32_ps(mmPhase)));
+        for (size_t i = 0; i < VectorSize; ++i) {
+            const float* taps = table.data() + 2 * phases[i] * numTaps;
+            products[i] = sincProducts(in + index[i] - halfTaps + 1, taps, numTaps, _mm256_set1_ps(blends[i]));
+        }
+        _mm256_storeu_ps(out, horizontalSums(products));
+        index += VectorSize;
+        coeff += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetInterpolateSinc<float>(index, coeff, input, out, table, numTaps);
+}
+
+TARGET_AVX2 float avx2::linearRamp(absl::Span<float> output, float value, float step) noexcept
+{
+    auto* out = output.begin();
+    const auto* lastVector = output.end() - output.size() % VectorSize;
+
+    auto mmValue = _mm256_set1_ps(value);
+    const auto mmSteps = _mm256_mul_ps(_mm256_set1_ps(step), _mm256_set_ps(8.0f, 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f));
+    while (out < lastVector) {
+        mmValue = _mm256_add_ps(mmValue, mmSteps);
+        _mm256_storeu_ps(out, mmValue);
+        mmValue = broadcastLast(mmValue);
+        out += VectorSize;
+    }
+
+    value = _mm256_cvtss_f32(mmValue);
+    while (out < output.end())
+        snippetRampLinear<float>(out, value, step);
+    return value;
+}
+
+TARGET_AVX2 float avx2::multiplicativeRamp(absl::Span<float> output, float value, float step) noexcept
+{
+    auto* out = output.begin();
+    const auto* lastVector = output.end() - output.size() % VectorSize;
+
+    float steps[VectorSize];
+    steps[0] = step;
+    for (size_t i = 1; i < VectorSize; ++i)
+        steps[i] = steps[i - 1] * step;
+
+    auto mmValue = _mm256_set1_ps(value);
+    const auto mmSteps = _mm256_loadu_ps(steps);
+    while (out < lastVector) {
+        mmValue = _mm256_mul_ps(mmValue, mmSteps);
+        _mm256_storeu_ps(out, mmValue);
+        mmValue = broadcastLast(mmValue);
+        out += VectorSize;
+    }
+
+    value = _mm256_cvtss_f32(mmValue);
+    while (out < output.end())
+        snippetRampMultiplicative<float>(out, value, step);
+    return value;
+}
@@ -0,0 +1,267 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SIMDDispatch.h"
+#include <immintrin.h>
+
+// The loads and stores are unaligned, like the AVX2 ones
+constexpr size_t VectorSize { 16 };
+
+namespace {
+// GCC 12 warns that the unmasked permutes and conversions may use an uninitialized
+// vector, which is the undefined pass-through of their masked builtins. The zero-masked
+// forms over all the lanes compile to the same instructions without the false positive.
+constexpr __mmask16 allLanes { 0xFFFF };
+
+TARGET_AVX512 inline __m512 broadcastLast(__m512 vector) noexcept
+{
+    return _mm512_maskz_permutexvar_ps(allLanes, _mm512_set1_epi32(15), vector);
+}
+
+TARGET_AVX512 inline __m512 shiftUp(__m512 vector, int shift) noexcept
+{
+    const auto indices = _mm512_sub_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), _mm512_set1_epi32(shift));
+    return _mm512_maskz_permutexvar_ps(static_cast<__mmask16>(0xFFFF << shift), indices, vector);
+}
+
+TARGET_AVX512 inline __m512 prefixSum(__m512 vector) noexcept
+{
+    vector = _mm512_add_ps(vector, shiftUp(vector, 1));
+    vector = _mm512_add_ps(vector, shiftUp(vector, 2));
+    vector = _mm512_add_ps(vector, shiftUp(vector, 4));
+    return _mm512_add_ps(vector, shiftUp(vector, 8));
+}
+}
+
+TARGET_AVX512 void avx512::applyGain(float gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    const auto size = std::min(output.size(), input.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+    const auto mmGain = _mm512_set1_ps(gain);
+
+    while (out < lastVector) {
+        _mm512_storeu_ps(out, _mm512_mul_ps(mmGain, _mm512_loadu_ps(in)));
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetGain<float>(gain, in, out);
+}
+
+TARGET_AVX512 void avx512::applyGainSpan(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    ASSERT(gain.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    auto* g = gain.begin();
+    const auto size = min(output.size(), input.size(), gain.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        _mm512_storeu_ps(out, _mm512_mul_ps(_mm512_loadu_ps(g), _mm512_loadu_ps(in)));
+        g += VectorSize;
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetGainSpan<float>(g, in, out);
+}
+
+TARGET_AVX512 void avx512::multiplyAdd(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    ASSERT(gain.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    auto* g = gain.begin();
+    const auto size = min(output.size(), input.size(), gain.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        _mm512_storeu_ps(out, _mm512_fmadd_ps(_mm512_loadu_ps(g), _mm512_loadu_ps(in), _mm512_loadu_ps(out)));
+        g += VectorSize;
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetMultiplyAdd<float>(g, in, out);
+}
+
+TARGET_AVX512 float avx512::loopingSFZIndex(absl::Span<const float> jumps,
+    absl::Span<float> leftCoeffs,
+    absl::Span<float> rightCoeffs,
+    absl::Span<int> indices,
+    float floatIndex,
+    float loopEnd,
+    float loopStart) noexcept
+{
+    ASSERT(indices.size() >= jumps.size());
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+
+    auto index = indices.data();
+    auto leftCoeff = leftCoeffs.data();
+    auto rightCoeff = rightCoeffs.data();
+    auto jump = jumps.data();
+    const auto size = min(jumps.size(), indices.size(), leftCoeffs.size(), rightCoeffs.size());
+    const auto* sentinel = jump + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    auto mmFloatIndex = _mm512_set1_ps(floatIndex);
+    const auto mmJumpBack = _mm512_set1_ps(loopEnd - loopStart);
+    const auto mmLoopEnd = _mm512_set1_ps(loopEnd);
+    const auto mmRoundingOffset = _mm512_set1_ps(0.4999999552965164184570312f);
+    const auto mmOne = _mm512_set1_ps(1.0f);
+    while (jump < lastVector) {
+        mmFloatIndex = _mm512_add_ps(mmFloatIndex, prefixSum(_mm512_loadu_ps(jump)));
+        // A vector can span several rounds of a short loop
+        auto loopedBack = _mm512_cmp_ps_mask(mmFloatIndex, mmLoopEnd, _CMP_GE_OQ);
+        do {
+            mmFloatIndex = _mm512_mask_sub_ps(mmFloatIndex, loopedBack, mmFloatIndex, mmJumpBack);
+            loopedBack = _mm512_cmp_ps_mask(mmFloatIndex, mmLoopEnd, _CMP_GE_OQ);
+        } while (loopEnd > loopStart && loopedBack != 0);
+
+        const auto mmIndices = _mm512_maskz_cvtps_epi32(allLanes, _mm512_sub_ps(mmFloatIndex, mmRoundingOffset));
+        _mm512_storeu_si512(index, mmIndices);
+
+        const auto mmRight = _mm512_sub_ps(mmFloatIndex, _mm512_maskz_cvtepi32_ps(allLanes, mmIndices));
+        _mm512_storeu_ps(leftCoeff, _mm512_sub_ps(mmOne, mmRight));
+        _mm512_storeu_ps(rightCoeff, mmRight);
+
+        mmFloatIndex = broadcastLast(mmFloatIndex);
+        index += VectorSize;
+        jump += VectorSize;
+        leftCoeff += VectorSize;
+        rightCoeff += VectorSize;
+    }
+
+    floatIndex = _mm512_cvtss_f32(mmFloatIndex);
+    while (jump < sentinel)
+        snippetLoopingIndex<float>(jump, leftCoeff, rightCoeff, index, floatIndex, loopEnd, loopStart);
+    return floatIndex;
+}
+
+TARGET_AVX512 float avx512::saturatingSFZIndex(absl::Span<const float> jumps,
+    absl::Span<float> leftCoeffs,
+    absl::Span<float> rightCoeffs,
+    absl::Span<int> indices,
+    float floatIndex,
+    float loopEnd) noexcept
+{
+    ASSERT(indices.size() >= jumps.size());
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+
+    auto index = indices.data();
+    auto leftCoeff = leftCoeffs.data();
+    auto rightCoeff = rightCoeffs.data();
+    auto jump = jumps.data();
+    const auto size = min(jumps.size(), indices.size(), leftCoeffs.size(), rightCoeffs.size());
+    const auto* sentinel = jump + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    auto mmFloatIndex = _mm512_set1_ps(floatIndex);
+    const auto mmLoopEnd = _mm512_set1_ps(loopEnd);
+    const auto mmSaturated = _mm512_set1_ps(loopEnd - 0.000001f);
+    const auto mmRoundingOffset = _mm512_set1_ps(0.4999999552965164184570312f);
+    const auto mmOne = _mm512_set1_ps(1.0f);
+    while (jump < lastVector) {
+        mmFloatIndex = _mm512_add_ps(mmFloatIndex, prefixSum(_mm512_loadu_ps(jump)));
+        const auto saturated = _mm512_cmp_ps_mask(mmFloatIndex, mmLoopEnd, _CMP_GE_OQ);
+        mmFloatIndex = _mm512_mask_blend_ps(saturated, mmFloatIndex, mmSaturated);
+
+        const auto mmIndices = _mm512_maskz_cvtps_epi32(allLanes, _mm512_sub_ps(mmFloatIndex, mmRoundingOffset));
+        _mm512_storeu_si512(index, mmIndices);
+
+        const auto mmRight = _mm512_sub_ps(mmFloatIndex, _mm512_maskz_cvtepi32_ps(allLanes, mmIndices));
+        _mm512_storeu_ps(leftCoeff, _mm512_sub_ps(mmOne, mmRight));
+        _mm512_storeu_ps(rightCoeff, mmRight);
+
+        mmFloatIndex = broadcastLast(mmFloatIndex);
+        index += VectorSize;
+        jump += VectorSize;
+        leftCoeff += VectorSize;
+        rightCoeff += VectorSize;
+    }
+
+    floatIndex = _mm512_cvtss_f32(mmFloatIndex);
+    while (jump < sentinel)
+        snippetSaturatingIndex<float>(jump, leftCoeff, rightCoeff, index, floatIndex, loopEnd);
+    return floatIndex;
+}
+
+TARGET_AVX512 float avx512::linearRamp(absl::Span<float> output, float value, float step) noexcept
+{
+    auto* out = output.begin();
+    const auto* lastVector = output.end() - output.size() % VectorSize;
+
+    auto mmValue = _mm512_set1_ps(value);
+    const auto mmSteps = _mm512_mul_ps(_mm512_set1_ps(step),
+        _mm512_set_ps(16.0f, 15.0f, 14.0f, 13.0f, 12.0f, 11.0f, 10.0f, 9.0f, 8.0f, 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f));
+    while (out < lastVector) {
+        mmValue = _mm512_add_ps(mmValue, mmSteps);
+        _mm512_storeu_ps(out, mmValue);
+        mmValue = broadcastLast(mmValue);
+        out += VectorSize;
+    }
+
+    value = _mm512_cvtss_f32(mmValue);
+    while (out < output.end())
+        snippetRampLinear<float>(out, value, step);
+    return value;
+}
+
+TARGET_AVX512 float avx512::multiplicativeRamp(absl::Span<float> output, float value, float step) noexcept
+{
+    auto* out = output.begin();
+    const auto* lastVector = output.end() - output.size() % VectorSize;
+
+    float steps[VectorSize];
+    steps[0] = step;
+    for (size_t i = 1; i < VectorSize; ++i)
+        steps[i] = steps[i - 1] * step;
+
+    auto mmValue = _mm512_set1_ps(value);
+    const auto mmSteps = _mm512_loadu_ps(steps);
+    while (out < lastVector) {
+        mmValue = _mm512_mul_ps(mmValue, mmSteps);
+        _mm512_storeu_ps(out, mmValue);
+        mmValue = broadcastLast(mmValue);
+        out += VectorSize;
+    }
+
+    value = _mm512_cvtss_f32(mmValue);
+    while (out < output.end())
+        snippetRampMultiplicative<float>(out, value, step);
+    return value;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "SIMDHelpers.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+/**
+ * The x86 SIMD helpers that are chosen at runtime depending on the instruction sets
+ * supported by the CPU. The SSE helpers, which are the baseline, forward their calls
+ * to the implementations for the current SIMDLevel through this table.
+ */
+struct SIMDDispatch {
+    void (*exp)(absl::Span<const float> input, absl::Span<float> output) noexcept;
+    void (*log)(absl::Span<const float> input, absl::Span<float> output) noexcept;
+    void (*sin)(absl::Span<const float> input, absl::Span<float> output) noexcept;
+    void (*cos)(absl::Span<const float> input, absl::Span<float> output) noexcept;
+    void (*applyGain)(float gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+    void (*applyGainSpan)(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+    void (*multiplyAdd)(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+    float (*loopingSFZIndex)(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd, float loopStart) noexcept;
+    float (*saturatingSFZIndex)(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd) noexcept;
+    void (*interpolateLinear)(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept;
+    void (*interpolateHermite)(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept;
+    void (*interpolateSinc)(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept;
+    float (*linearRamp)(absl::Span<float> output, float start, float step) noexcept;
+    float (*multiplicativeRamp)(absl::Span<float> output, float start, float step) noexcept;
+};
+
+namespace sse {
+void exp(absl::Span<const float> input, absl::Span<float> output) noexcept;
+void log(absl::Span<const float> input, absl::Span<float> output) noexcept;
+void sin(absl::Span<const float> input, absl::Span<float> output) noexcept;
+void cos(absl::Span<const float> input, absl::Span<float> output) noexcept;
+void multiplyAdd(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+float loopingSFZIndex(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd, float loopStart) noexcept;
+float saturatingSFZIndex(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd) noexcept;
+void interpolateLinear(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept;
+void interpolateHermite(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept;
+void interpolateSinc(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept;
+float multiplicativeRamp(absl::Span<float> output, float start, float step) noexcept;
+}
+
+// These are compiled with target attributes, and must only be called on CPUs that support them
+namespace avx2 {
+void exp(absl::Span<const float> input, absl::Span<float> output) noexcept;
+void log(absl::Span<const float> input, absl::Span<float> output) noexcept;
+void sin(absl::Span<const float> input, absl::Span<float> output) noexcept;
+void cos(absl::Span<const float> input, absl::Span<float> output) noexcept;
+void applyGain(float gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+void applyGainSpan(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+void multiplyAdd(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+float loopingSFZIndex(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd, float loopStart) noexcept;
+float saturatingSFZIndex(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd) noexcept;
+void interpolateLinear(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept;
+void interpolateHermite(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept;
+void interpolateSinc(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept;
+float linearRamp(absl::Span<float> output, float start, float step) noexcept;
+float multiplicativeRamp(absl::Span<float> output, float start, float step) noexcept;
+}
+
+// The AVX-512 dispatch uses the AVX2 mathfuns and interpolation
+namespace avx512 {
+void applyGain(float gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+void applyGainSpan(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+void multiplyAdd(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept;
+float loopingSFZIndex(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd, float loopStart) noexcept;
+float saturatingSFZIndex(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd) noexcept;
+float linearRamp(absl::Span<float> output, float start, float step) noexcept;
+float multiplicativeRamp(absl::Span<float> output, float start, float step) noexcept;
+}
@@ -23,6 +23,20 @@
 
 #include "SIMDHelpers.h"
 
+SIMDLevel getSupportedSIMDLevel() noexcept
+{
+    return SIMDLevel::Baseline;
+}
+
+SIMDLevel getSIMDLevel() noexcept
+{
+    return SIMDLevel::Baseline;
+}
+
+void setSIMDLevel(SIMDLevel level [[maybe_unused]]) noexcept
+{
+}
+
 template <>
 void readInterleaved<float, true>(absl::Span<const float> input, absl::Span<float> outputLeft, absl::Span<float> outputRight) noexcept
 {
@@ -96,6 +110,24 @@ float saturatingSFZIndex<float, true>(absl::Span<const float> jumps, absl::Span<
 }
 
 
+template <>
+void interpolateLinear<float, true>(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    interpolateLinear<float, false>(indices, leftCoeffs, rightCoeffs, input, output);
+}
+
+template <>
+void interpolateHermite<float, true>(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    interpolateHermite<float, false>(indices, coeffs, input, output);
+}
+
+template <>
+void interpolateSinc<float, true>(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept
+{
+    interpolateSinc<float, false>(indices, coeffs, input, output, table, numTaps);
+}
+
 template <>
 float linearRamp<float, true>(absl::Span<float> output, float start, float step) noexcept
 {
@@ -130,4 +162,16 @@ template <>
 void pan<float, true>(absl::Span<const float> panEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
 {
     pan<float, false>(panEnvelope, leftBuffer, rightBuffer);
-}
\ No newline at end of file
+}
+
+template <>
+void panMono<float, true>(absl::Span<const float> gainEnvelope, absl::Span<const float> panEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    panMono<float, false>(gainEnvelope, panEnvelope, leftBuffer, rightBuffer);
+}
+
+template <>
+void widthPosition<float, true>(absl::Span<const float> gainEnvelope, absl::Span<const float> widthEnvelope, absl::Span<const float> positionEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    widthPosition<float, false>(gainEnvelope, widthEnvelope, positionEnvelope, leftBuffer, rightBuffer);
+}
@@ -29,6 +29,19 @@
 #include <absl/types/span.h>
 #include <cmath>
 
+/**
+ * The instruction sets that the SIMD helpers can use on top of the baseline that the
+ * library is compiled for. The best one that the CPU supports is selected at startup.
+ */
+enum class SIMDLevel { Baseline, AVX2, AVX512 };
+SIMDLevel getSupportedSIMDLevel() noexcept;
+SIMDLevel getSIMDLevel() noexcept;
+/**
+ * Restricts the SIMD helpers to an instruction set, e.g. to compare them in benchmarks.
+ * Levels above the supported one are ignored. Do not call this while rendering.
+ */
+void setSIMDLevel(SIMDLevel level) noexcept;
+
 template <class T>
 inline void snippetRead(const T*& input, T*& outputLeft, T*& outputRight)
 {
@@ -215,6 +228,122 @@ float loopingSFZIndex(absl::Span<const T> jumps, absl::Span<T> leftCoeffs, absl:
 template <>
 float loopingSFZIndex<float, true>(absl::Span<const float> jumps, absl::Span<float> leftCoeff, absl::Span<float> rightCoeff, absl::Span<int> indices, float floatIndex, float loopEnd, float loopStart) noexcept;
 
+template <class T>
+inline void snippetInterpolateLinear(const int*& index, const T*& leftCoeff, const T*& rightCoeff, const T* input, T*& output)
+{
+    *output++ = input[*index] * (*leftCoeff++) + input[*index + 1] * (*rightCoeff++);
+    index++;
+}
+
+/**
+ * Linearly interpolates the input at the positions computed by the SFZ index helpers:
+ * output[i] = input[indices[i]] * leftCoeffs[i] + input[indices[i] + 1] * rightCoeffs[i]
+ */
+template <class T, bool SIMD = SIMDConfig::interpolateLinear>
+void interpolateLinear(absl::Span<const int> indices, absl::Span<const T> leftCoeffs, absl::Span<const T> rightCoeffs, absl::Span<const T> input, absl::Span<T> output) noexcept
+{
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+    ASSERT(indices.size() <= output.size());
+
+    auto* index = indices.begin();
+    auto* leftCoeff = leftCoeffs.begin();
+    auto* rightCoeff = rightCoeffs.begin();
+    auto* out = output.begin();
+    auto* sentinel = out + min(indices.size(), leftCoeffs.size(), rightCoeffs.size(), output.size());
+    while (out < sentinel)
+        snippetInterpolateLinear<T>(index, leftCoeff, rightCoeff, input.data(), out);
+}
+
+template <>
+void interpolateLinear<float, true>(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept;
+
+// Reads the input as silent outside of its bounds
+template <class T>
+inline T sampleOrZero(absl::Span<const T> input, int index)
+{
+    return index >= 0 && index < static_cast<int>(input.size()) ? input[index] : T { 0 };
+}
+
+// Catmull-Rom spline through x0 and x1, at the fraction t between them
+template <class T>
+inline T hermite(T xm1, T x0, T x1, T x2, T t)
+{
+    const T c1 = T { 0.5 } * (x1 - xm1);
+    const T c2 = xm1 - T { 2.5 } * x0 + T { 2 } * x1 - T { 0.5 } * x2;
+    const T c3 = T { 0.5 } * (x2 - xm1) + T { 1.5 } * (x0 - x1);
+    return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+template <class T>
+inline void snippetInterpolateHermite(const int*& index, const T*& coeff, absl::Span<const T> input, T*& output)
+{
+    const int i = *index++;
+    *output++ = hermite(sampleOrZero(input, i - 1), sampleOrZero(input, i), sampleOrZero(input, i + 1), sampleOrZero(input, i + 2), *coeff++);
+}
+
+/**
+ * 4-point Hermite interpolation of the input at the positions computed by the SFZ index
+ * helpers, where coeffs are the fractional parts (the right coefficients of the linear
+ * interpolation). Frames outside of the input are taken as silent.
+ */
+template <class T, bool SIMD = SIMDConfig::interpolateHermite>
+void interpolateHermite(absl::Span<const int> indices, absl::Span<const T> coeffs, absl::Span<const T> input, absl::Span<T> output) noexcept
+{
+    ASSERT(indices.size() == coeffs.size());
+    ASSERT(indices.size() <= output.size());
+
+    auto* index = indices.begin();
+    auto* coeff = coeffs.begin();
+    auto* out = output.begin();
+    auto* sentinel = out + min(indices.size(), coeffs.size(), output.size());
+    while (out < sentinel)
+        snippetInterpolateHermite<T>(index, coeff, input, out);
+}
+
+template <>
+void interpolateHermite<float, true>(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept;
+
+template <class T>
+inline void snippetInterpolateSinc(const int*& index, const T*& coeff, absl::Span<const T> input, T*& output, absl::Span<const T> table, int numTaps)
+{
+    const int numPhases = static_cast<int>(table.size()) / (2 * numTaps);
+    const T position = *coeff++ * numPhases;
+    const int phase = std::min(static_cast<int>(position), numPhases - 1);
+    const T blend = position - phase;
+    const T* taps = table.data() + 2 * phase * numTaps;
+    const int first = *index++ - numTaps / 2 + 1;
+    T sum { 0 };
+    for (int k = 0; k < numTaps; ++k)
+        sum += sampleOrZero(input, first + k) * (taps[k] + blend * taps[numTaps + k]);
+    *output++ = sum;
+}
+
+/**
+ * Windowed-sinc interpolation of the input at the positions computed by the SFZ index
+ * helpers, where coeffs are the fractional parts. The table holds the taps of each
+ * fractional phase followed by their difference with the next phase, as built by
+ * sfz::SincTable; the numTaps frames around each index are read, from index - numTaps / 2 + 1
+ * to index + numTaps / 2. Frames outside of the input are taken as silent.
+ */
+template <class T, bool SIMD = SIMDConfig::interpolateSinc>
+void interpolateSinc(absl::Span<const int> indices, absl::Span<const T> coeffs, absl::Span<const T> input, absl::Span<T> output, absl::Span<const T> table, int numTaps) noexcept
+{
+    ASSERT(indices.size() == coeffs.size());
+    ASSERT(indices.size() <= output.size());
+    ASSERT(numTaps > 0 && table.size() % (2 * numTaps) == 0);
+
+    auto* index = indices.begin();
+    auto* coeff = coeffs.begin();
+    auto* out = output.begin();
+    auto* sentinel = out + min(indices.size(), coeffs.size(), output.size());
+    while (out < sentinel)
+        snippetInterpolateSinc<T>(index, coeff, input, out, table, numTaps);
+}
+
+template <>
+void interpolateSinc<float, true>(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept;
+
 template <class T>
 inline void snippetGain(T gain, const T*& input, T*& output)
 {
@@ -412,4 +541,71 @@ void pan(absl::Span<const T> panEnvelope, absl::Span<T> leftBuffer, absl::Span<T
 }
 
 template <>
-void pan<float, true>(absl::Span<const float> panEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept;
\ No newline at end of file
+void pan<float, true>(absl::Span<const float> panEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept;
+
+template <class T>
+inline void snippetPanMono(const T*& gain, const T*& pan, T*& left, T*& right)
+{
+    const auto circlePan = piFour<T> * (static_cast<T>(1.0) + *pan++);
+    const auto sample = *gain++ * *left;
+    *left++ = sample * std::cos(circlePan);
+    *right++ = sample * std::sin(circlePan);
+}
+
+/**
+ * Applies a gain to a mono voice in the left buffer and pans it on both buffers,
+ * in a single pass over the block.
+ */
+template <class T, bool SIMD = SIMDConfig::panMono>
+void panMono(absl::Span<const T> gainEnvelope, absl::Span<const T> panEnvelope, absl::Span<T> leftBuffer, absl::Span<T> rightBuffer) noexcept
+{
+    ASSERT(panEnvelope.size() >= gainEnvelope.size());
+    ASSERT(leftBuffer.size() >= gainEnvelope.size());
+    ASSERT(rightBuffer.size() >= gainEnvelope.size());
+    auto* gain = gainEnvelope.begin();
+    auto* pan = panEnvelope.begin();
+    auto* left = leftBuffer.begin();
+    auto* right = rightBuffer.begin();
+    auto* sentinel = gain + min(gainEnvelope.size(), panEnvelope.size(), leftBuffer.size(), rightBuffer.size());
+    while (gain < sentinel)
+        snippetPanMono(gain, pan, left, right);
+}
+
+template <>
+void panMono<float, true>(absl::Span<const float> gainEnvelope, absl::Span<const float> panEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept;
+
+template <class T>
+inline void snippetWidthPosition(const T*& gain, const T*& width, const T*& position, T*& left, T*& right)
+{
+    const auto circleWidth = piFour<T> * (static_cast<T>(1.0) + *width++);
+    const auto circlePosition = piFour<T> * (static_cast<T>(1.0) + *position++);
+    const auto scaledGain = *gain++ * sqrtTwoInv<T>;
+    const auto side = scaledGain * (*left - *right) * std::cos(circleWidth);
+    const auto mid = scaledGain * (*left + *right) * std::sin(circleWidth);
+    *left++ = sqrtTwoInv<T> * (mid + std::cos(circlePosition) * side);
+    *right++ = sqrtTwoInv<T> * (mid + std::sin(circlePosition) * side);
+}
+
+/**
+ * Applies a gain to a stereo voice, then its width and position through a mid/side
+ * transform, in a single pass over the block.
+ */
+template <class T, bool SIMD = SIMDConfig::widthPosition>
+void widthPosition(absl::Span<const T> gainEnvelope, absl::Span<const T> widthEnvelope, absl::Span<const T> positionEnvelope, absl::Span<T> leftBuffer, absl::Span<T> rightBuffer) noexcept
+{
+    ASSERT(widthEnvelope.size() >= gainEnvelope.size());
+    ASSERT(positionEnvelope.size() >= gainEnvelope.size());
+    ASSERT(leftBuffer.size() >= gainEnvelope.size());
+    ASSERT(rightBuffer.size() >= gainEnvelope.size());
+    auto* gain = gainEnvelope.begin();
+    auto* width = widthEnvelope.begin();
+    auto* position = positionEnvelope.begin();
+    auto* left = leftBuffer.begin();
+    auto* right = rightBuffer.begin();
+    auto* sentinel = gain + min(gainEnvelope.size(), widthEnvelope.size(), positionEnvelope.size(), leftBuffer.size(), rightBuffer.size());
+    while (gain < sentinel)
+        snippetWidthPosition(gain, width, position, left, right);
+}
+
+template <>
+void widthPosition<float, true>(absl::Span<const float> gainEnvelope, absl::Span<const float> widthEnvelope, absl::Span<const float> positionEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept;
@@ -0,0 +1,716 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SIMDHelpers.h"
+#include <arm_neon.h>
+#include "mathfuns/neon_mathfun.h"
+
+// NEON loads and stores do not require any particular alignment, and are as fast
+// on unaligned data as on aligned data on the cores we target, so the vector loops
+// do not need an alignment prologue.
+constexpr size_t VectorSize { 4 };
+
+namespace {
+inline float32x4_t prefixSum(float32x4_t vector) noexcept
+{
+    const auto zero = vdupq_n_f32(0.0f);
+    vector = vaddq_f32(vector, vextq_f32(zero, vector, 3));
+    return vaddq_f32(vector, vextq_f32(zero, vector, 2));
+}
+
+inline float32x4_t broadcastLast(float32x4_t vector) noexcept
+{
+    return vdupq_n_f32(vgetq_lane_f32(vector, 3));
+}
+
+inline bool anyTrue(uint32x4_t mask) noexcept
+{
+    const auto half = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+    return (vget_lane_u32(half, 0) | vget_lane_u32(half, 1)) != 0;
+}
+
+inline bool allTrue(uint32x4_t mask) noexcept
+{
+    const auto half = vand_u32(vget_low_u32(mask), vget_high_u32(mask));
+    return (vget_lane_u32(half, 0) & vget_lane_u32(half, 1)) != 0;
+}
+
+inline float32x4_t circleAngle(const float* value) noexcept
+{
+    return vmulq_n_f32(vaddq_f32(vdupq_n_f32(1.0f), vld1q_f32(value)), piFour<float>);
+}
+
+template <class MathFunction, class ScalarFunction>
+inline void applyMathFunction(absl::Span<const float> input, absl::Span<float> output, MathFunction mathFunction, ScalarFunction scalarFunction) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    const auto size = std::min(input.size(), output.size());
+    auto* sentinel = in + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (in < lastVector) {
+        vst1q_f32(out, mathFunction(vld1q_f32(in)));
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (in < sentinel)
+        *out++ = scalarFunction(*in++);
+}
+}
+
+SIMDLevel getSupportedSIMDLevel() noexcept
+{
+    return SIMDLevel::Baseline;
+}
+
+SIMDLevel getSIMDLevel() noexcept
+{
+    return SIMDLevel::Baseline;
+}
+
+void setSIMDLevel(SIMDLevel level [[maybe_unused]]) noexcept
+{
+}
+
+template <>
+void readInterleaved<float, true>(absl::Span<const float> input, absl::Span<float> outputLeft, absl::Span<float> outputRight) noexcept
+{
+    // The size of the outputs is not big enough for the input...
+    ASSERT(outputLeft.size() >= input.size() / 2);
+    ASSERT(outputRight.size() >= input.size() / 2);
+    // Input is too small
+    ASSERT(input.size() > 1);
+
+    auto* in = input.begin();
+    auto* lOut = outputLeft.begin();
+    auto* rOut = outputRight.begin();
+
+    const auto size = std::min(input.size(), std::min(outputLeft.size() * 2, outputRight.size() * 2));
+    const auto* sentinel = in + size;
+    const auto* lastVector = sentinel - size % (2 * VectorSize);
+
+    while (in < lastVector) {
+        const auto registers = vld2q_f32(in);
+        vst1q_f32(lOut, registers.val[0]);
+        vst1q_f32(rOut, registers.val[1]);
+        in += 2 * VectorSize;
+        lOut += VectorSize;
+        rOut += VectorSize;
+    }
+
+    while (in < sentinel - 1)
+        snippetRead<float>(in, lOut, rOut);
+}
+
+template <>
+void writeInterleaved<float, true>(absl::Span<const float> inputLeft, absl::Span<const float> inputRight, absl::Span<float> output) noexcept
+{
+    // The size of the output is not big enough for the inputs...
+    ASSERT(inputLeft.size() <= output.size() / 2);
+    ASSERT(inputRight.size() <= output.size() / 2);
+
+    auto* lIn = inputLeft.begin();
+    auto* rIn = inputRight.begin();
+    auto* out = output.begin();
+
+    const auto size = std::min(output.size(), std::min(inputLeft.size(), inputRight.size()) * 2);
+    const auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % (2 * VectorSize);
+
+    while (out < lastVector) {
+        float32x4x2_t registers;
+        registers.val[0] = vld1q_f32(lIn);
+        registers.val[1] = vld1q_f32(rIn);
+        vst2q_f32(out, registers);
+        out += 2 * VectorSize;
+        lIn += VectorSize;
+        rIn += VectorSize;
+    }
+
+    while (out < sentinel - 1)
+        snippetWrite<float>(out, lIn, rIn);
+}
+
+template <>
+void fill<float, true>(absl::Span<float> output, float value) noexcept
+{
+    const auto mmValue = vdupq_n_f32(value);
+    auto* out = output.begin();
+    const auto* lastVector = output.end() - output.size() % VectorSize;
+
+    while (out < lastVector) {
+        vst1q_f32(out, mmValue);
+        out += VectorSize;
+    }
+
+    while (out < output.end())
+        *out++ = value;
+}
+
+template <>
+void exp<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    applyMathFunction(input, output, exp_ps, [](float x) { return std::exp(x); });
+}
+
+template <>
+void log<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    applyMathFunction(input, output, log_ps, [](float x) { return std::log(x); });
+}
+
+template <>
+void sin<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    applyMathFunction(input, output, sin_ps, [](float x) { return std::sin(x); });
+}
+
+template <>
+void cos<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    applyMathFunction(input, output, cos_ps, [](float x) { return std::cos(x); });
+}
+
+template <>
+void applyGain<float, true>(float gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    auto* in = input.begin();
+    auto* out = output.begin();
+    const auto size = std::min(output.size(), input.size());
+    const auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        vst1q_f32(out, vmulq_n_f32(vld1q_f32(in), gain));
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        *out++ = gain * (*in++);
+}
+
+template <>
+void applyGain<float, true>(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    auto* in = input.begin();
+    auto* out = output.begin();
+    auto* g = gain.begin();
+    const auto size = min(output.size(), input.size(), gain.size());
+    const auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        vst1q_f32(out, vmulq_f32(vld1q_f32(g), vld1q_f32(in)));
+        g += VectorSize;
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetGainSpan<float>(g, in, out);
+}
+
+template <>
+void multiplyAdd<float, true>(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    auto* in = input.begin();
+    auto* out = output.begin();
+    auto* g = gain.begin();
+    const auto size = min(output.size(), input.size(), gain.size());
+    const auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        vst1q_f32(out, vmlaq_f32(vld1q_f32(out), vld1q_f32(g), vld1q_f32(in)));
+        g += VectorSize;
+        in += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetMultiplyAdd<float>(g, in, out);
+}
+
+template <>
+float loopingSFZIndex<float, true>(absl::Span<const float> jumps,
+    absl::Span<float> leftCoeffs,
+    absl::Span<float> rightCoeffs,
+    absl::Span<int> indices,
+    float floatIndex,
+    float loopEnd,
+    float loopStart) noexcept
+{
+    ASSERT(indices.size() >= jumps.size());
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+
+    auto index = indices.data();
+    auto leftCoeff = leftCoeffs.data();
+    auto rightCoeff = rightCoeffs.data();
+    auto jump = jumps.data();
+    const auto size = min(jumps.size(), indices.size(), leftCoeffs.size(), rightCoeffs.size());
+    const auto* sentinel = jump + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    auto mmFloatIndex = vdupq_n_f32(floatIndex);
+    const auto mmJumpBack = vdupq_n_f32(loopEnd - loopStart);
+    const auto mmLoopEnd = vdupq_n_f32(loopEnd);
+    const auto mmOne = vdupq_n_f32(1.0f);
+    while (jump < lastVector) {
+        mmFloatIndex = vaddq_f32(mmFloatIndex, prefixSum(vld1q_f32(jump)));
+        // A vector can span several rounds of a short loop
+        auto mmCompared = vcgeq_f32(mmFloatIndex, mmLoopEnd);
+        do {
+            mmFloatIndex = vbslq_f32(mmCompared, vsubq_f32(mmFloatIndex, mmJumpBack), mmFloatIndex);
+            mmCompared = vcgeq_f32(mmFloatIndex, mmLoopEnd);
+        } while (loopEnd > loopStart && anyTrue(mmCompared));
+
+        // The indices are positive, so truncating matches the scalar cast
+        const auto mmIndices = vcvtq_s32_f32(mmFloatIndex);
+        vst1q_s32(index, mmIndices);
+
+        const auto mmRight = vsubq_f32(mmFloatIndex, vcvtq_f32_s32(mmIndices));
+        vst1q_f32(leftCoeff, vsubq_f32(mmOne, mmRight));
+        vst1q_f32(rightCoeff, mmRight);
+
+        mmFloatIndex = broadcastLast(mmFloatIndex);
+        index += VectorSize;
+        jump += VectorSize;
+        leftCoeff += VectorSize;
+        rightCoeff += VectorSize;
+    }
+
+    floatIndex = vgetq_lane_f32(mmFloatIndex, 0);
+    while (jump < sentinel)
+        snippetLoopingIndex<float>(jump, leftCoeff, rightCoeff, index, floatIndex, loopEnd, loopStart);
+    return floatIndex;
+}
+
+template <>
+float saturatingSFZIndex<float, true>(absl::Span<const float> jumps,
+    absl::Span<float> leftCoeffs,
+    absl::Span<float> rightCoeffs,
+    absl::Span<int> indices,
+    float floatIndex,
+    float loopEnd) noexcept
+{
+    ASSERT(indices.size() >= jumps.size());
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+
+    auto index = indices.data();
+    auto leftCoeff = leftCoeffs.data();
+    auto rightCoeff = rightCoeffs.data();
+    auto jump = jumps.data();
+    const auto size = min(jumps.size(), indices.size(), leftCoeffs.size(), rightCoeffs.size());
+    const auto* sentinel = jump + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    auto mmFloatIndex = vdupq_n_f32(floatIndex);
+    const auto mmLoopEnd = vdupq_n_f32(loopEnd);
+    const auto mmLastIndex = vdupq_n_s32(static_cast<int>(loopEnd) - 1);
+    const auto mmOne = vdupq_n_f32(1.0f);
+    while (jump < lastVector) {
+        mmFloatIndex = vaddq_f32(mmFloatIndex, prefixSum(vld1q_f32(jump)));
+        // Saturated lanes read the last sample entirely, as in the scalar version
+        const auto mmCompared = vcltq_f32(mmFloatIndex, mmLoopEnd);
+        mmFloatIndex = vbslq_f32(mmCompared, mmFloatIndex, mmLoopEnd);
+
+        const auto mmIndices = vbslq_s32(mmCompared, vcvtq_s32_f32(mmFloatIndex), mmLastIndex);
+        vst1q_s32(index, mmIndices);
+
+        const auto mmRight = vbslq_f32(mmCompared, vsubq_f32(mmFloatIndex, vcvtq_f32_s32(mmIndices)), mmOne);
+        vst1q_f32(leftCoeff, vsubq_f32(mmOne, mmRight));
+        vst1q_f32(rightCoeff, mmRight);
+
+        mmFloatIndex = broadcastLast(mmFloatIndex);
+        index += VectorSize;
+        jump += VectorSize;
+        leftCoeff += VectorSize;
+        rightCoeff += VectorSize;
+    }
+
+    floatIndex = vgetq_lane_f32(mmFloatIndex, 0);
+    while (jump < sentinel)
+        snippetSaturatingIndex<float>(jump, leftCoeff, rightCoeff, index, floatIndex, loopEnd);
+    return floatIndex;
+}
+
+template <>
+void interpolateLinear<float, true>(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+    ASSERT(indices.size() <= output.size());
+
+    auto* index = indices.begin();
+    auto* leftCoeff = leftCoeffs.begin();
+    auto* rightCoeff = rightCoeffs.begin();
+    auto* in = input.data();
+    auto* out = output.begin();
+    const auto size = min(indices.size(), leftCoeffs.size(), rightCoeffs.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    const int offsets[VectorSize] { 0, 1, 2, 3 };
+    const auto mmOffsets = vld1q_s32(offsets);
+    while (out < lastVector) {
+        const auto mmContiguous = vaddq_s32(vdupq_n_s32(index[0]), mmOffsets);
+        float32x4_t mmLeft;
+        float32x4_t mmRight;
+        if (allTrue(vceqq_s32(vld1q_s32(index), mmContiguous))) {
+            // The frames are contiguous when the pitch ratio is close to 1
+            mmLeft = vld1q_f32(in + index[0]);
+            mmRight = vld1q_f32(in + index[0] + 1);
+        } else {
+            const float left[VectorSize] { in[index[0]], in[index[1]], in[index[2]], in[index[3]] };
+            const float right[VectorSize] { in[index[0] + 1], in[index[1] + 1], in[index[2] + 1], in[index[3] + 1] };
+            mmLeft = vld1q_f32(left);
+            mmRight = vld1q_f32(right);
+        }
+        mmLeft = vmulq_f32(mmLeft, vld1q_f32(leftCoeff));
+        vst1q_f32(out, vmlaq_f32(mmLeft, mmRight, vld1q_f32(rightCoeff)));
+        index += VectorSize;
+        leftCoeff += VectorSize;
+        rightCoeff += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetInterpolateLinear<float>(index, leftCoeff, rightCoeff, in, out);
+}
+
+template <>
+void interpolateHermite<float, true>(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(indices.size() == coeffs.size());
+    ASSERT(indices.size() <= output.size());
+
+    auto* index = indices.begin();
+    auto* coeff = coeffs.begin();
+    auto* in = input.data();
+    auto* out = output.begin();
+    const auto size = min(indices.size(), coeffs.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    const int offsets[VectorSize] { 0, 1, 2, 3 };
+    const auto mmOffsets = vld1q_s32(offsets);
+    // The 4 frames around each index have to be within the input
+    const auto mmLowest = vdupq_n_s32(0);
+    const auto mmHighest = vdupq_n_s32(static_cast<int>(input.size()) - 2);
+    while (out < lastVector) {
+        const auto mmIndices = vld1q_s32(index);
+        if (!allTrue(vandq_u32(vcgtq_s32(mmIndices, mmLowest), vcltq_s32(mmIndices, mmHighest)))) {
+            for (size_t i = 0; i < VectorSize; ++i)
+                snippetInterpolateHermite<float>(index, coeff, input, out);
+            continue;
+        }
+
+        const auto mmContiguous = vaddq_s32(vdupq_n_s32(index[0]), mmOffsets);
+        float32x4_t mmXm1;
+        float32x4_t mmX0;
+        float32x4_t mmX1;
+        float32x4_t mmX2;
+        if (allTrue(vceqq_s32(mmIndices, mmContiguous))) {
+            mmXm1 = vld1q_f32(in + index[0] - 1);
+            mmX0 = vld1q_f32(in + index[0]);
+            mmX1 = vld1q_f32(in + index[0] + 1);
+            mmX2 = vld1q_f32(in + index[0] + 2);
+        } else {
+            const float xm1[VectorSize] { in[index[0] - 1], in[index[1] - 1], in[index[2] - 1], in[index[3] - 1] };
+            const float x0[VectorSize] { in[index[0]], in[index[1]], in[index[2]], in[index[3]] };
+            const float x1[VectorSize] { in[index[0] + 1], in[index[1] + 1], in[index[2] + 1], in[index[3] + 1] };
+            const float x2[VectorSize] { in[index[0] + 2], in[index[1] + 2], in[index[2] + 2], in[index[3] + 2] };
+            mmXm1 = vld1q_f32(xm1);
+            mmX0 = vld1q_f32(x0);
+            mmX1 = vld1q_f32(x1);
+            mmX2 = vld1q_f32(x2);
+        }
+
+        const auto mmC1 = vmulq_n_f32(vsubq_f32(mmX1, mmXm1), 0.5f);
+        auto mmC2 = vmlsq_n_f32(mmXm1, mmX0, 2.5f);
+        mmC2 = vaddq_f32(mmC2, vaddq_f32(mmX1, mmX1));
+        mmC2 = vmlsq_n_f32(mmC2, mmX2, 0.5f);
+        const auto mmC3 = vmlaq_n_f32(vmulq_n_f32(vsubq_f32(mmX2, mmXm1), 0.5f), vsubq_f32(mmX0, mmX1), 1.5f);
+        const auto mmT = vld1q_f32(coeff);
+        auto mmOutput = vmlaq_f32(mmC2, mmC3, mmT);
+        mmOutput = vmlaq_f32(mmC1, mmOutput, mmT);
+        mmOutput = vmlaq_f32(mmX0, mmOutput, mmT);
+        vst1q_f32(out, mmOutput);
+        index += VectorSize;
+        coeff += VectorSize;
+        out += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetInterpolateHermite<float>(index, coeff, input, out);
+}
+
+template <>
+void interpolateSinc<float, true>(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept
+{
+    ASSERT(indices.size() == coeffs.size());
+    ASSERT(indices.size() <= output.size());
+    ASSERT(numTaps > 0 && table.size() % (2 * numTaps) == 0);
+
+    auto* index = indices.begin();
+    auto* coeff = coeffs.begin();
+    auto* in = input.data();
+    auto* out = output.begin();
+    auto* sentinel = out + min(indices.size(), coeffs.size(), output.size());
+
+    const int numPhases = static_cast<int>(table.size()) / (2 * numTaps);
+    const int lastFirst = static_cast<int>(input.size()) - numTaps;
+    const bool vectorTaps = numTaps % VectorSize == 0;
+    while (out < sentinel) {
+        const int first = *index - numTaps / 2 + 1;
+        if (!vectorTaps || first < 0 || first > lastFirst) {
+            snippetInterpolateSinc<float>(index, coeff, input, out, table, numTaps);
+            continue;
+        }
+
+        const float position = *coeff * numPhases;
+        const int phase = std::min(static_cast<int>(position), numPhases - 1);
+        const float blend = position - phase;
+        const float* taps = table.data() + 2 * phase * numTaps;
+        auto mmSum = vdupq_n_f32(0.0f);
+        for (int k = 0; k < numTaps; k += VectorSize) {
+            const auto mmTaps = vmlaq_n_f32(vld1q_f32(taps + k), vld1q_f32(taps + numTaps + k), blend);
+            mmSum = vmlaq_f32(mmSum, vld1q_f32(in + first + k), mmTaps);
+        }
+        const auto halfSum = vadd_f32(vget_low_f32(mmSum), vget_high_f32(mmSum));
+        *out++ = vget_lane_f32(vpadd_f32(halfSum, halfSum), 0);
+        index++;
+        coeff++;
+    }
+}
+
+template <>
+float linearRamp<float, true>(absl::Span<float> output, float value, float step) noexcept
+{
+    auto* out = output.begin();
+    const auto* lastVector = output.end() - output.size() % VectorSize;
+
+    const float steps[VectorSize] { step, step + step, step + step + step, step + step + step + step };
+    auto mmValue = vdupq_n_f32(value);
+    const auto mmSteps = vld1q_f32(steps);
+
+    while (out < lastVector) {
+        mmValue = vaddq_f32(mmValue, mmSteps);
+        vst1q_f32(out, mmValue);
+        mmValue = broadcastLast(mmValue);
+        out += VectorSize;
+    }
+
+    value = vgetq_lane_f32(mmValue, 0);
+    while (out < output.end())
+        snippetRampLinear<float>(out, value, step);
+    return value;
+}
+
+template <>
+float multiplicativeRamp<float, true>(absl::Span<float> output, float value, float step) noexcept
+{
+    auto* out = output.begin();
+    const auto* lastVector = output.end() - output.size() % VectorSize;
+
+    const float steps[VectorSize] { step, step * step, step * step * step, step * step * step * step };
+    auto mmValue = vdupq_n_f32(value);
+    const auto mmSteps = vld1q_f32(steps);
+
+    while (out < lastVector) {
+        mmValue = vmulq_f32(mmValue, mmSteps);
+        vst1q_f32(out, mmValue);
+        mmValue = broadcastLast(mmValue);
+        out += VectorSize;
+    }
+
+    value = vgetq_lane_f32(mmValue, 0);
+    while (out < output.end())
+        snippetRampMultiplicative<float>(out, value, step);
+    return value;
+}
+
+template <>
+void add<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    const auto size = min(input.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        vst1q_f32(out, vaddq_f32(vld1q_f32(in), vld1q_f32(out)));
+        out += VectorSize;
+        in += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetAdd<float>(in, out);
+}
+
+template <>
+void subtract<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    const auto size = min(input.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        vst1q_f32(out, vsubq_f32(vld1q_f32(out), vld1q_f32(in)));
+        out += VectorSize;
+        in += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetSubtract<float>(in, out);
+}
+
+template <>
+void copy<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    auto* in = input.begin();
+    auto* out = output.begin();
+    const auto size = min(input.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    while (out < lastVector) {
+        vst1q_f32(out, vld1q_f32(in));
+        out += VectorSize;
+        in += VectorSize;
+    }
+
+    while (out < sentinel)
+        snippetCopy<float>(in, out);
+}
+
+template <>
+void pan<float, true>(absl::Span<const float> panEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    ASSERT(leftBuffer.size() >= panEnvelope.size());
+    ASSERT(rightBuffer.size() >= panEnvelope.size());
+    auto* pan = panEnvelope.begin();
+    auto* left = leftBuffer.begin();
+    auto* right = rightBuffer.begin();
+    const auto size = min(panEnvelope.size(), leftBuffer.size(), rightBuffer.size());
+    auto* sentinel = pan + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    float32x4_t mmCos;
+    float32x4_t mmSin;
+    while (pan < lastVector) {
+        sincos_ps(circleAngle(pan), &mmSin, &mmCos);
+        vst1q_f32(left, vmulq_f32(mmCos, vld1q_f32(left)));
+        vst1q_f32(right, vmulq_f32(mmSin, vld1q_f32(right)));
+        left += VectorSize;
+        right += VectorSize;
+        pan += VectorSize;
+    }
+
+    while (pan < sentinel)
+        snippetPan(pan, left, right);
+}
+
+template <>
+void panMono<float, true>(absl::Span<const float> gainEnvelope, absl::Span<const float> panEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    ASSERT(panEnvelope.size() >= gainEnvelope.size());
+    ASSERT(leftBuffer.size() >= gainEnvelope.size());
+    ASSERT(rightBuffer.size() >= gainEnvelope.size());
+    auto* gain = gainEnvelope.begin();
+    auto* pan = panEnvelope.begin();
+    auto* left = leftBuffer.begin();
+    auto* right = rightBuffer.begin();
+    const auto size = min(gainEnvelope.size(), panEnvelope.size(), leftBuffer.size(), rightBuffer.size());
+    auto* sentinel = gain + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    float32x4_t mmCos;
+    float32x4_t mmSin;
+    while (gain < lastVector) {
+        sincos_ps(circleAngle(pan), &mmSin, &mmCos);
+        const auto mmSample = vmulq_f32(vld1q_f32(gain), vld1q_f32(left));
+        vst1q_f32(left, vmulq_f32(mmSample, mmCos));
+        vst1q_f32(right, vmulq_f32(mmSample, mmSin));
+        gain += VectorSize;
+        pan += VectorSize;
+        left += VectorSize;
+        right += VectorSize;
+    }
+
+    while (gain < sentinel)
+        snippetPanMono(gain, pan, left, right);
+}
+
+template <>
+void widthPosition<float, true>(absl::Span<const float> gainEnvelope, absl::Span<const float> widthEnvelope, absl::Span<const float> positionEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    ASSERT(widthEnvelope.size() >= gainEnvelope.size());
+    ASSERT(positionEnvelope.size() >= gainEnvelope.size());
+    ASSERT(leftBuffer.size() >= gainEnvelope.size());
+    ASSERT(rightBuffer.size() >= gainEnvelope.size());
+    auto* gain = gainEnvelope.begin();
+    auto* width = widthEnvelope.begin();
+    auto* position = positionEnvelope.begin();
+    auto* left = leftBuffer.begin();
+    auto* right = rightBuffer.begin();
+    const auto size = min(gainEnvelope.size(), widthEnvelope.size(), positionEnvelope.size(), leftBuffer.size(), rightBuffer.size());
+    auto* sentinel = gain + size;
+    const auto* lastVector = sentinel - size % VectorSize;
+
+    float32x4_t mmWidthCos;
+    float32x4_t mmWidthSin;
+    float32x4_t mmPositionCos;
+    float32x4_t mmPositionSin;
+    while (gain < lastVector) {
+        sincos_ps(circleAngle(width), &mmWidthSin, &mmWidthCos);
+        sincos_ps(circleAngle(position), &mmPositionSin, &mmPositionCos);
+        const auto mmGain = vmulq_n_f32(vld1q_f32(gain), sqrtTwoInv<float>);
+        const auto mmLeft = vld1q_f32(left);
+        const auto mmRight = vld1q_f32(right);
+        const auto mmSide = vmulq_f32(vmulq_f32(mmGain, vsubq_f32(mmLeft, mmRight)), mmWidthCos);
+        const auto mmMid = vmulq_f32(vmulq_f32(mmGain, vaddq_f32(mmLeft, mmRight)), mmWidthSin);
+        vst1q_f32(left, vmulq_n_f32(vmlaq_f32(mmMid, mmPositionCos, mmSide), sqrtTwoInv<float>));
+        vst1q_f32(right, vmulq_n_f32(vmlaq_f32(mmMid, mmPositionSin, mmSide), sqrtTwoInv<float>));
+        gain += VectorSize;
+        width += VectorSize;
+        position += VectorSize;
+        left += VectorSize;
+        right += VectorSize;
+    }
+
+    while (gain < sentinel)
+        snippetWidthPosition(gain, width, position, left, right);
+}
@@ -21,7 +21,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include "SIMDHelpers.h"
+#include "SIMDDispatch.h"
 #include <xmmintrin.h>
 
 #if HAVE_X86INTRIN_H
@@ -75,6 +75,11 @@ bool unaligned(const float* ptr1, const float* ptr2, const float* ptr3, const fl
     return unaligned(ptr1) || unaligned(ptr2) || unaligned(ptr3) || unaligned(ptr4);
 }
 
+bool unaligned(const float* ptr1, const float* ptr2, const float* ptr3, const float* ptr4, const float* ptr5)
+{
+    return unaligned(ptr1, ptr2, ptr3, ptr4) || unaligned(ptr5);
+}
+
 template <>
 void readInterleaved<float, true>(absl::Span<const float> input, absl::Span<float> outputLeft, absl::Span<float> outputRight) noexcept
 {
@@ -172,8 +177,7 @@ void fill<float, true>(absl::Span<float> output, float value) noexcept
         *out++ = value;
 }
 
-template <>
-void exp<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+void sse::exp(absl::Span<const float> input, absl::Span<float> output) noexcept
 {
     ASSERT(output.size() >= input.size());
     auto* in = input.begin();
@@ -194,8 +198,7 @@ void exp<float, true>(absl::Span<const float> input, absl::Span<float> output) n
         *out++ = std::exp(*in++);
 }
 
-template <>
-void cos<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+void sse::cos(absl::Span<const float> input, absl::Span<float> output) noexcept
 {
     ASSERT(output.size() >= input.size());
     auto* in = input.begin();
@@ -204,7 +207,7 @@ void cos<float, true>(absl::Span<const float> input, absl::Span<float> output) n
     const auto* lastAligned = prevAligned(sentinel);
 
     while (unaligned(in, out) && in < lastAligned)
-        *out++ = std::exp(*in++);
+        *out++ = std::cos(*in++);
 
     while (in < lastAligned) {
         _mm_store_ps(out, cos_ps(_mm_load_ps(in)));
@@ -213,11 +216,10 @@ void cos<float, true>(absl::Span<const float> input, absl::Span<float> output) n
     }
 
     while (in < sentinel)
-        *out++ = std::exp(*in++);
+        *out++ = std::cos(*in++);
 }
 
-template <>
-void log<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+void sse::log(absl::Span<const float> input, absl::Span<float> output) noexcept
 {
     ASSERT(output.size() >= input.size());
     auto* in = input.begin();
@@ -226,7 +228,7 @@ void log<float, true>(absl::Span<const float> input, absl::Span<float> output) n
     const auto* lastAligned = prevAligned(sentinel);
 
     while (unaligned(in, out) && in < lastAligned)
-        *out++ = std::exp(*in++);
+        *out++ = std::log(*in++);
 
     while (in < lastAligned) {
         _mm_store_ps(out, log_ps(_mm_load_ps(in)));
@@ -235,11 +237,10 @@ void log<float, true>(absl::Span<const float> input, absl::Span<float> output) n
     }
 
     while (in < sentinel)
-        *out++ = std::exp(*in++);
+        *out++ = std::log(*in++);
 }
 
-template <>
-void sin<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+void sse::sin(absl::Span<const float> input, absl::Span<float> output) noexcept
 {
     ASSERT(output.size() >= input.size());
     auto* in = input.begin();
@@ -248,7 +249,7 @@ void sin<float, true>(absl::Span<const float> input, absl::Span<float> output) n
     const auto* lastAligned = prevAligned(sentinel);
 
     while (unaligned(in, out) && in < lastAligned)
-        *out++ = std::exp(*in++);
+        *out++ = std::sin(*in++);
 
     while (in < lastAligned) {
         _mm_store_ps(out, sin_ps(_mm_load_ps(in)));
@@ -257,56 +258,10 @@ void sin<float, true>(absl::Span<const float> input, absl::Span<float> output) n
     }
 
     while (in < sentinel)
-        *out++ = std::exp(*in++);
+        *out++ = std::sin(*in++);
 }
 
-template <>
-void applyGain<float, true>(float gain, absl::Span<const float> input, absl::Span<float> output) noexcept
-{
-    auto* in = input.begin();
-    auto* out = output.begin();
-    const auto size = std::min(output.size(), input.size());
-    const auto* lastAligned = prevAligned(output.begin() + size);
-    const auto mmGain = _mm_set_ps1(gain);
-
-    while (unaligned(out, in) && out < lastAligned)
-        *out++ = gain * (*in++);
-
-    while (out < lastAligned) {
-        _mm_store_ps(out, _mm_mul_ps(mmGain, _mm_load_ps(in)));
-        in += TypeAlignment;
-        out += TypeAlignment;
-    }
-
-    while (out < output.end())
-        *out++ = gain * (*in++);
-}
-
-template <>
-void applyGain<float, true>(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
-{
-    auto* in = input.begin();
-    auto* out = output.begin();
-    auto* g = gain.begin();
-    const auto size = std::min(output.size(), std::min(input.size(), gain.size()));
-    const auto* lastAligned = prevAligned(output.begin() + size);
-
-    while (unaligned(out, in, g) && out < lastAligned)
-        snippetGainSpan<float>(g, in, out);
-
-    while (out < lastAligned) {
-        _mm_store_ps(out, _mm_mul_ps(_mm_load_ps(g), _mm_load_ps(in)));
-        g += TypeAlignment;
-        in += TypeAlignment;
-        out += TypeAlignment;
-    }
-
-    while (out < output.end())
-        snippetGainSpan<float>(g, in, out);
-}
-
-template <>
-void multiplyAdd<float, true>(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+void sse::multiplyAdd(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
 {
     auto* in = input.begin();
     auto* out = output.begin();
@@ -330,8 +285,7 @@ void multiplyAdd<float, true>(absl::Span<const float> gain, absl::Span<const flo
         snippetMultiplyAdd<float>(g, in, out);
 }
 
-template <>
-float loopingSFZIndex<float, true>(absl::Span<const float> jumps,
+float sse::loopingSFZIndex(absl::Span<const float> jumps,
     absl::Span<float> leftCoeffs,
     absl::Span<float> rightCoeffs,
     absl::Span<int> indices,
@@ -392,8 +346,7 @@ float loopingSFZIndex<float, true>(absl::Span<const float> jumps,
     return floatIndex;
 }
 
-template <>
-float saturatingSFZIndex<float, true>(absl::Span<const float> jumps,
+float sse::saturatingSFZIndex(absl::Span<const float> jumps,
     absl::Span<float> leftCoeffs,
     absl::Span<float> rightCoeffs,
     absl::Span<int> indices,
@@ -450,33 +403,184 @@ float saturatingSFZIndex<float, true>(absl::Span<const float> jumps,
     return floatIndex;
 }
 
-template <>
-float linearRamp<float, true>(absl::Span<float> output, float value, float step) noexcept
+void sse::interpolateLinear(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
 {
+    ASSERT(indices.size() == leftCoeffs.size());
+    ASSERT(indices.size() == rightCoeffs.size());
+    ASSERT(indices.size() <= output.size());
+
+    auto* index = indices.begin();
+    auto* leftCoeff = leftCoeffs.begin();
+    auto* rightCoeff = rightCoeffs.begin();
+    auto* in = input.data();
     auto* out = output.begin();
-    const auto* lastAligned = prevAligned(output.end());
+    const auto size = min(indices.size(), leftCoeffs.size(), rightCoeffs.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % TypeAlignment;
+
+    const auto mmOffsets = _mm_set_epi32(3, 2, 1, 0);
+    while (out < lastVector) {
+        const auto mmIndices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(index));
+        const auto mmContiguous = _mm_add_epi32(_mm_set1_epi32(index[0]), mmOffsets);
+        __m128 mmLeft;
+        __m128 mmRight;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(mmIndices, mmContiguous)) == 0xFFFF) {
+            // The frames are contiguous when the pitch ratio is close to 1
+            mmLeft = _mm_loadu_ps(in + index[0]);
+            mmRight = _mm_loadu_ps(in + index[0] + 1);
+        } else {
+            mmLeft = _mm_set_ps(in[index[3]], in[index[2]], in[index[1]], in[index[0]]);
+            mmRight = _mm_set_ps(in[index[3] + 1], in[index[2] + 1], in[index[1] + 1], in[index[0] + 1]);
+        }
+        mmLeft = _mm_mul_ps(mmLeft, _mm_loadu_ps(leftCoeff));
+        mmRight = _mm_mul_ps(mmRight, _mm_loadu_ps(rightCoeff));
+        _mm_storeu_ps(out, _mm_add_ps(mmLeft, mmRight));
+        index += TypeAlignment;
+        leftCoeff += TypeAlignment;
+        rightCoeff += TypeAlignment;
+        out += TypeAlignment;
+    }
 
-    while (unaligned(out) && out < lastAligned)
-        snippetRampLinear<float>(out, value, step);
+    while (out < sentinel)
+        snippetInterpolateLinear<float>(index, leftCoeff, rightCoeff, in, out);
+}
 
-    auto mmValue = _mm_set1_ps(value);
-    auto mmStep = _mm_set_ps(step + step + step + step, step + step + step, step + step, step);
+void sse::interpolateHermite(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    ASSERT(indices.size() == coeffs.size());
+    ASSERT(indices.size() <= output.size());
 
-    while (out < lastAligned) {
-        mmValue = _mm_add_ps(mmValue, mmStep);
-        _mm_store_ps(out, mmValue);
-        mmValue = _mm_shuffle_ps(mmValue, mmValue, _MM_SHUFFLE(3, 3, 3, 3));
+    auto* index = indices.begin();
+    auto* coeff = coeffs.begin();
+    auto* in = input.data();
+    auto* out = output.begin();
+    const auto size = min(indices.size(), coeffs.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % TypeAlignment;
+
+    const auto mmOffsets = _mm_set_epi32(3, 2, 1, 0);
+    // The 4 frames around each index have to be within the input
+    const auto mmLowest = _mm_setzero_si128();
+    const auto mmHighest = _mm_set1_epi32(static_cast<int>(input.size()) - 2);
+    while (out < lastVector) {
+        const auto mmIndices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(index));
+        const auto mmInside = _mm_and_si128(_mm_cmpgt_epi32(mmIndices, mmLowest), _mm_cmplt_epi32(mmIndices, mmHighest));
+        if (_mm_movemask_epi8(mmInside) != 0xFFFF) {
+            for (unsigned i = 0; i < TypeAlignment; ++i)
+                snippetInterpolateHermite<float>(index, coeff, input, out);
+            continue;
+        }
+
+        const auto mmContiguous = _mm_add_epi32(_mm_set1_epi32(index[0]), mmOffsets);
+        __m128 mmXm1;
+        __m128 mmX0;
+        __m128 mmX1;
+        __m128 mmX2;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(mmIndices, mmContiguous)) == 0xFFFF) {
+            mmXm1 = _mm_loadu_ps(in + index[0] - 1);
+            mmX0 = _mm_loadu_ps(in + index[0]);
+            mmX1 = _mm_loadu_ps(in + index[0] + 1);
+            mmX2 = _mm_loadu_ps(in + index[0] + 2);
+        } else {
+            mmXm1 = _mm_set_ps(in[index[3] - 1], in[index[2] - 1], in[index[1] - 1], in[index[0] - 1]);
+            mmX0 = _mm_set_ps(in[index[3]], in[index[2]], in[index[1]], in[index[0]]);
+            mmX1 = _mm_set_ps(in[index[3] + 1], in[index[2] + 1], in[index[1] + 1], in[index[0] + 1]);
+            mmX2 = _mm_set_ps(in[index[3] + 2], in[index[2] + 2], in[index[1] + 2], in[index[0] + 2]);
+        }
+
+        const auto mmHalf = _mm_set1_ps(0.5f);
+        const auto mmC1 = _mm_mul_ps(mmHalf, _mm_sub_ps(mmX1, mmXm1));
+        auto mmC2 = _mm_sub_ps(mmXm1, _mm_mul_ps(_mm_set1_ps(2.5f), mmX0));
+        mmC2 = _mm_add_ps(mmC2, _mm_add_ps(mmX1, mmX1));
+        mmC2 = _mm_sub_ps(mmC2, _mm_mul_ps(mmHalf, mmX2));
+        const auto mmC3 = _mm_add_ps(_mm_mul_ps(mmHalf, _mm_sub_ps(mmX2, mmXm1)), _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(mmX0, mmX1)));
+        const auto mmT = _mm_loadu_ps(coeff);
+        auto mmOutput = _mm_add_ps(_mm_mul_ps(mmC3, mmT), mmC2);
+        mmOutput = _mm_add_ps(_mm_mul_ps(mmOutput, mmT), mmC1);
+        mmOutput = _mm_add_ps(_mm_mul_ps(mmOutput, mmT), mmX0);
+        _mm_storeu_ps(out, mmOutput);
+        index += TypeAlignment;
+        coeff += TypeAlignment;
         out += TypeAlignment;
     }
 
-    value = _mm_cvtss_f32(mmValue);
-    while (out < output.end())
-        snippetRampLinear<float>(out, value, step);
-    return value;
+    while (out < sentinel)
+        snippetInterpolateHermite<float>(index, coeff, input, out);
 }
 
-template <>
-float multiplicativeRamp<float, true>(absl::Span<float> output, float value, float step) noexcept
+namespace {
+// The products of the taps of one frame, to be summed
+inline __m128 sincProducts(const float* in, const float* taps, int numTaps, __m128 mmBlend) noexcept
+{
+    auto mmSum = _mm_setzero_ps();
+    for (int k = 0; k < numTaps; k += TypeAlignment) {
+        const auto mmTaps = _mm_add_ps(_mm_loadu_ps(taps + k), _mm_mul_ps(mmBlend, _mm_loadu_ps(taps + numTaps + k)));
+        mmSum = _mm_add_ps(mmSum, _mm_mul_ps(_mm_loadu_ps(in + k), mmTaps));
+    }
+    return mmSum;
+}
+}
+
+void sse::interpolateSinc(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept
+{
+    ASSERT(indices.size() == coeffs.size());
+    ASSERT(indices.size() <= output.size());
+    ASSERT(numTaps > 0 && table.size() % (2 * numTaps) == 0);
+
+    auto* index = indices.begin();
+    auto* coeff = coeffs.begin();
+    auto* in = input.data();
+    auto* out = output.begin();
+    const auto size = min(indices.size(), coeffs.size(), output.size());
+    auto* sentinel = out + size;
+    const auto* lastVector = sentinel - size % TypeAlignment;
+
+    // The taps are processed 4 at a time, so the shorter or odd kernels go the scalar way
+    if (numTaps % TypeAlignment != 0) {
+        while (out < sentinel)
+            snippetInterpolateSinc<float>(index, coeff, input, out, table, numTaps);
+        return;
+    }
+
+    const int numPhases = static_cast<int>(table.size()) / (2 * numTaps);
+    const int halfTaps = numTaps / 2;
+    const auto mmNumPhases = _mm_set1_ps(static_cast<float>(numPhases));
+    const auto mmLastPhase = _mm_set1_ps(static_cast<float>(numPhases - 1));
+    // All the taps of each frame have to be within the input
+    const auto mmLowest = _mm_set1_epi32(halfTaps - 2);
+    const auto mmHighest = _mm_set1_epi32(static_cast<int>(input.size()) - halfTaps);
+    alignas(16) int phases[TypeAlignment];
+    alignas(16) float blends[TypeAlignment];
+    while (out < lastVector) {
+        const auto mmIndices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(index));
+        const auto mmInside = _mm_and_si128(_mm_cmpgt_epi32(mmIndices, mmLowest), _mm_cmplt_epi32(mmIndices, mmHighest));
+        if (_mm_movemask_epi8(mmInside) != 0xFFFF) {
+            for (unsigned i = 0; i < TypeAlignment; ++i)
+                snippetInterpolateSinc<float>(index, coeff, input, out, table, numTaps);
+            continue;
+        }
+
+        // One horizontal sum for 4 frames, and the phases computed together
+        const auto mmPosition = _mm_mul_ps(_mm_loadu_ps(coeff), mmNumPhases);
+        const auto mmPhase = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(mmPosition)), mmLastPhase);
+        _mm_store_si128(reinterpret_cast<__m128i*>(phases), _mm_cvttps_epi32(mmPhase));
+        _mm_store_ps(blends, _mm_sub_ps(mmPosition, mmPhase));
+        auto mmSum0 = sincProducts(in + index[0] - halfTaps + 1, table.data() + 2 * phases[0] * numTaps, numTaps, _mm_set1_ps(blends[0]));
+        auto mmSum1 = sincProducts(in + index[1] - halfTaps + 1, table.data() + 2 * phases[1] * numTaps, numTaps, _mm_set1_ps(blends[1]));
+        auto mmSum2 = sincProducts(in + index[2] - halfTaps + 1, table.data() + 2 * phases[2] * numTaps, numTaps, _mm_set1_ps(blends[2]));
+        auto mmSum3 = sincProducts(in + index[3] - halfTaps + 1, table.data() + 2 * phases[3] * numTaps, numTaps, _mm_set1_ps(blends[3]));
+        _MM_TRANSPOSE4_PS(mmSum0, mmSum1, mmSum2, mmSum3);
+        _mm_storeu_ps(out, _mm_add_ps(_mm_add_ps(mmSum0, mmSum1), _mm_add_ps(mmSum2, mmSum3)));
+        index += TypeAlignment;
+        coeff += TypeAlignment;
+        out += TypeAlignment;
+    }
+
+    while (out < sentinel)
+        snippetInterpolateSinc<float>(index, coeff, input, out, table, numTaps);
+}
+
+float sse::multiplicativeRamp(absl::Span<float> output, float value, float step) noexcept
 {
     auto* out = output.begin();
     const auto* lastAligned = prevAligned(output.end());
@@ -600,4 +704,290 @@ void pan<float, true>(absl::Span<const float> panEnvelope, absl::Span<float> lef
 
     while (pan < sentinel)
         snippetPan(pan, left, right);
-}
\ No newline at end of file
+}
+
+template <>
+void panMono<float, true>(absl::Span<const float> gainEnvelope, absl::Span<const float> panEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    ASSERT(panEnvelope.size() >= gainEnvelope.size());
+    ASSERT(leftBuffer.size() >= gainEnvelope.size());
+    ASSERT(rightBuffer.size() >= gainEnvelope.size());
+    auto* gain = gainEnvelope.begin();
+    auto* pan = panEnvelope.begin();
+    auto* left = leftBuffer.begin();
+    auto* right = rightBuffer.begin();
+    auto* sentinel = gain + min(gainEnvelope.size(), panEnvelope.size(), leftBuffer.size(), rightBuffer.size());
+    const auto* lastAligned = prevAligned(sentinel);
+
+    while (unaligned(gain, pan, left, right) && gain < lastAligned)
+        snippetPanMono(gain, pan, left, right);
+
+    const auto mmOne = _mm_set_ps1(1.0f);
+    const auto mmPiFour = _mm_set_ps1(piFour<float>);
+    __m128 mmCos;
+    __m128 mmSin;
+    while (gain < lastAligned) {
+        sincos_ps(_mm_mul_ps(mmPiFour, _mm_add_ps(mmOne, _mm_load_ps(pan))), &mmSin, &mmCos);
+        const auto mmSample = _mm_mul_ps(_mm_load_ps(gain), _mm_load_ps(left));
+        _mm_store_ps(left, _mm_mul_ps(mmSample, mmCos));
+        _mm_store_ps(right, _mm_mul_ps(mmSample, mmSin));
+        gain += TypeAlignment;
+        pan += TypeAlignment;
+        left += TypeAlignment;
+        right += TypeAlignment;
+    }
+
+    while (gain < sentinel)
+        snippetPanMono(gain, pan, left, right);
+}
+
+template <>
+void widthPosition<float, true>(absl::Span<const float> gainEnvelope, absl::Span<const float> widthEnvelope, absl::Span<const float> positionEnvelope, absl::Span<float> leftBuffer, absl::Span<float> rightBuffer) noexcept
+{
+    ASSERT(widthEnvelope.size() >= gainEnvelope.size());
+    ASSERT(positionEnvelope.size() >= gainEnvelope.size());
+    ASSERT(leftBuffer.size() >= gainEnvelope.size());
+    ASSERT(rightBuffer.size() >= gainEnvelope.size());
+    auto* gain = gainEnvelope.begin();
+    auto* width = widthEnvelope.begin();
+    auto* position = positionEnvelope.begin();
+    auto* left = leftBuffer.begin();
+    auto* right = rightBuffer.begin();
+    auto* sentinel = gain + min(gainEnvelope.size(), widthEnvelope.size(), positionEnvelope.size(), leftBuffer.size(), rightBuffer.size());
+    const auto* lastAligned = prevAligned(sentinel);
+
+    while (unaligned(gain, width, position, left, right) && gain < lastAligned)
+        snippetWidthPosition(gain, width, position, left, right);
+
+    const auto mmOne = _mm_set_ps1(1.0f);
+    const auto mmPiFour = _mm_set_ps1(piFour<float>);
+    const auto mmSqrtTwoInv = _mm_set_ps1(sqrtTwoInv<float>);
+    __m128 mmWidthCos;
+    __m128 mmWidthSin;
+    __m128 mmPositionCos;
+    __m128 mmPositionSin;
+    while (gain < lastAligned) {
+        sincos_ps(_mm_mul_ps(mmPiFour, _mm_add_ps(mmOne, _mm_load_ps(width))), &mmWidthSin, &mmWidthCos);
+        sincos_ps(_mm_mul_ps(mmPiFour, _mm_add_ps(mmOne, _mm_load_ps(position))), &mmPositionSin, &mmPositionCos);
+        const auto mmGain = _mm_mul_ps(mmSqrtTwoInv, _mm_load_ps(gain));
+        const auto mmLeft = _mm_load_ps(left);
+        const auto mmRight = _mm_load_ps(right);
+        const auto mmSide = _mm_mul_ps(_mm_mul_ps(mmGain, _mm_sub_ps(mmLeft, mmRight)), mmWidthCos);
+        const auto mmMid = _mm_mul_ps(_mm_mul_ps(mmGain, _mm_add_ps(mmLeft, mmRight)), mmWidthSin);
+        _mm_store_ps(left, _mm_mul_ps(mmSqrtTwoInv, _mm_add_ps(mmMid, _mm_mul_ps(mmPositionCos, mmSide))));
+        _mm_store_ps(right, _mm_mul_ps(mmSqrtTwoInv, _mm_add_ps(mmMid, _mm_mul_ps(mmPositionSin, mmSide))));
+        gain += TypeAlignment;
+        width += TypeAlignment;
+        position += TypeAlignment;
+        left += TypeAlignment;
+        right += TypeAlignment;
+    }
+
+    while (gain < sentinel)
+        snippetWidthPosition(gain, width, position, left, right);
+}
+
+namespace {
+// The compiler vectorizes the plain gain and ramp loops better than the SSE versions
+constexpr SIMDDispatch sseDispatch {
+    sse::exp,
+    sse::log,
+    sse::sin,
+    sse::cos,
+    applyGain<float, false>,
+    applyGain<float, false>,
+    sse::multiplyAdd,
+    sse::loopingSFZIndex,
+    sse::saturatingSFZIndex,
+    sse::interpolateLinear,
+    sse::interpolateHermite,
+    sse::interpolateSinc,
+    linearRamp<float, false>,
+    sse::multiplicativeRamp,
+};
+
+constexpr SIMDDispatch avx2Dispatch {
+    avx2::exp,
+    avx2::log,
+    avx2::sin,
+    avx2::cos,
+    avx2::applyGain,
+    avx2::applyGainSpan,
+    avx2::multiplyAdd,
+    avx2::loopingSFZIndex,
+    avx2::saturatingSFZIndex,
+    avx2::interpolateLinear,
+    avx2::interpolateHermite,
+    avx2::interpolateSinc,
+    avx2::linearRamp,
+    avx2::multiplicativeRamp,
+};
+
+constexpr SIMDDispatch avx512Dispatch {
+    avx2::exp,
+    avx2::log,
+    avx2::sin,
+    avx2::cos,
+    avx512::applyGain,
+    avx512::applyGainSpan,
+    avx512::multiplyAdd,
+    avx512::loopingSFZIndex,
+    avx512::saturatingSFZIndex,
+    avx2::interpolateLinear,
+    avx2::interpolateHermite,
+    avx2::interpolateSinc,
+    avx512::linearRamp,
+    avx512::multiplicativeRamp,
+};
+
+SIMDLevel detectSIMDLevel() noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    const bool hasAVX2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    const bool hasAVX512 = hasAVX2 && __builtin_cpu_supports("avx512f");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool hasFMA = (info[2] & (1 << 12)) != 0;
+    const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+    const auto xcr0 = hasOSXSave ? _xgetbv(0) : 0;
+    // The OS must save the YMM registers, and the ZMM ones for AVX-512
+    const bool hasYMMState = (xcr0 & 0x06) == 0x06;
+    const bool hasZMMState = (xcr0 & 0xE6) == 0xE6;
+    bool hasAVX2 { false };
+    bool hasAVX512 { false };
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        hasAVX2 = hasFMA && hasYMMState && (info[1] & (1 << 5)) != 0;
+        hasAVX512 = hasAVX2 && hasZMMState && (info[1] & (1 << 16)) != 0;
+    }
+#else
+    constexpr bool hasAVX2 { false };
+    constexpr bool hasAVX512 { false };
+#endif
+    if (hasAVX512)
+        return SIMDLevel::AVX512;
+    if (hasAVX2)
+        return SIMDLevel::AVX2;
+    return SIMDLevel::Baseline;
+}
+
+const SIMDLevel supportedLevel { detectSIMDLevel() };
+SIMDLevel currentLevel { SIMDLevel::Baseline };
+// Starts on SSE so that the helpers work during static initialization
+SIMDDispatch dispatch { sseDispatch };
+[[maybe_unused]] const bool dispatchInitialized = (setSIMDLevel(supportedLevel), true);
+}
+
+SIMDLevel getSupportedSIMDLevel() noexcept
+{
+    return supportedLevel;
+}
+
+SIMDLevel getSIMDLevel() noexcept
+{
+    return currentLevel;
+}
+
+void setSIMDLevel(SIMDLevel level) noexcept
+{
+    currentLevel = std::min(level, detectSIMDLevel());
+    switch (currentLevel) {
+    case SIMDLevel::AVX512:
+        dispatch = avx512Dispatch;
+        break;
+    case SIMDLevel::AVX2:
+        dispatch = avx2Dispatch;
+        break;
+    case SIMDLevel::Baseline:
+        dispatch = sseDispatch;
+        break;
+    }
+}
+
+template <>
+void exp<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.exp(input, output);
+}
+
+template <>
+void log<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.log(input, output);
+}
+
+template <>
+void sin<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.sin(input, output);
+}
+
+template <>
+void cos<float, true>(absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.cos(input, output);
+}
+
+template <>
+void applyGain<float, true>(float gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.applyGain(gain, input, output);
+}
+
+template <>
+void applyGain<float, true>(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.applyGainSpan(gain, input, output);
+}
+
+template <>
+void multiplyAdd<float, true>(absl::Span<const float> gain, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.multiplyAdd(gain, input, output);
+}
+
+template <>
+float loopingSFZIndex<float, true>(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd, float loopStart) noexcept
+{
+    return dispatch.loopingSFZIndex(jumps, leftCoeffs, rightCoeffs, indices, floatIndex, loopEnd, loopStart);
+}
+
+template <>
+float saturatingSFZIndex<float, true>(absl::Span<const float> jumps, absl::Span<float> leftCoeffs, absl::Span<float> rightCoeffs, absl::Span<int> indices, float floatIndex, float loopEnd) noexcept
+{
+    return dispatch.saturatingSFZIndex(jumps, leftCoeffs, rightCoeffs, indices, floatIndex, loopEnd);
+}
+
+template <>
+void interpolateLinear<float, true>(absl::Span<const int> indices, absl::Span<const float> leftCoeffs, absl::Span<const float> rightCoeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.interpolateLinear(indices, leftCoeffs, rightCoeffs, input, output);
+}
+
+template <>
+void interpolateHermite<float, true>(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output) noexcept
+{
+    dispatch.interpolateHermite(indices, coeffs, input, output);
+}
+
+template <>
+void interpolateSinc<float, true>(absl::Span<const int> indices, absl::Span<const float> coeffs, absl::Span<const float> input, absl::Span<float> output, absl::Span<const float> table, int numTaps) noexcept
+{
+    dispatch.interpolateSinc(indices, coeffs, input, output, table, numTaps);
+}
+
+template <>
+float linearRamp<float, true>(absl::Span<float> output, float start, float step) noexcept
+{
+    return dispatch.linearRamp(output, start, step);
+}
+
+template <>
+float multiplicativeRamp<float, true>(absl::Span<float> output, float start, float step) noexcept
+{
+    return dispatch.multiplicativeRamp(output, start, step);
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SampleCache.h"
+#include <algorithm>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#define SFIZZ_HAVE_STAT
+#endif
+
+sfz::SampleCache& sfz::SampleCache::getInstance() noexcept
+{
+    static SampleCache instance;
+    return instance;
+}
+
+std::optional<sfz::SampleCache::FileIdentity> sfz::SampleCache::identify(const std::filesystem::path& file) noexcept
+{
+    std::error_code error;
+    const auto canonicalPath = std::filesystem::canonical(file, error);
+    if (error)
+        return {};
+
+    FileIdentity identity;
+    identity.path = canonicalPath.string();
+#ifdef SFIZZ_HAVE_STAT
+    struct stat fileStatus;
+    if (::stat(canonicalPath.c_str(), &fileStatus) != 0)
+        return {};
+
+    identity.device = static_cast<uint64_t>(fileStatus.st_dev);
+    identity.inode = static_cast<uint64_t>(fileStatus.st_ino);
+    identity.modificationTime = static_cast<int64_t>(fileStatus.st_mtime);
+#else
+    const auto modificationTime = std::filesystem::last_write_time(canonicalPath, error);
+    if (error)
+        return {};
+
+    identity.modificationTime = static_cast<int64_t>(modificationTime.time_since_epoch().count());
+#endif
+    return identity;
+}
+
+std::shared_ptr<sfz::CachedSample> sfz::SampleCache::find(const FileIdentity& identity, int oversamplingFactor) noexcept
+{
+    std::lock_guard<std::mutex> entriesLock { entriesMutex };
+    if (auto entry = entries.find(std::make_pair(identity.path, oversamplingFactor)); entry != entries.end() && entry->second.identity == identity) {
+        if (auto sample = entry->second.sample.lock()) {
+            hits++;
+            return sample;
+        }
+    }
+
+    misses++;
+    return {};
+}
+
+std::shared_ptr<sfz::CachedSample> sfz::SampleCache::insert(const FileIdentity& identity, std::shared_ptr<CachedSample> sample) noexcept
+{
+    std::lock_guard<std::mutex> entriesLock { entriesMutex };
+    auto& entry = entries[std::make_pair(identity.path, sample->oversamplingFactor)];
+    if (entry.identity == identity) {
+        if (auto existingSample = entry.sample.lock())
+            return existingSample;
+    }
+
+    // A modified file replaces the old entry; the pools still using the old data keep it alive
+    entry.identity = identity;
+    entry.sample = sample;
+
+    if (entries.size() >= nextPurgeSize) {
+        purgeExpired();
+        nextPurgeSize = std::max(minimumPurgeSize, 2 * entries.size());
+    }
+
+    return sample;
+}
+
+void sfz::SampleCache::purgeExpired() noexcept
+{
+    for (auto entry = entries.begin(); entry != entries.end();) {
+        if (entry->second.sample.expired())
+            entries.erase(entry++);
+        else
+            ++entry;
+    }
+}
+
+sfz::SampleCache::Statistics sfz::SampleCache::getStatistics() noexcept
+{
+    Statistics statistics;
+    statistics.hits = hits;
+    statistics.misses = misses;
+
+    std::lock_guard<std::mutex> entriesLock { entriesMutex };
+    statistics.numCachedSamples = std::count_if(entries.begin(), entries.end(), [](const auto& entry) {
+        return !entry.second.sample.expired();
+    });
+    return statistics;
+}
+
+void sfz::SampleCache::resetStatistics() noexcept
+{
+    hits = 0;
+    misses = 0;
+}
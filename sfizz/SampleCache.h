@@ -0,0 +1,160 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "AudioBuffer.h"
+#include "Config.h"
+#include "Defaults.h"
+#include "MappedAudioFile.h"
+#include "filesystem.h"
+#include <absl/container/flat_hash_map.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace sfz {
+/**
+ * Sample data shared between all the file pools of the process.
+ * The preload can be evicted under memory pressure and restored later. Voices acquire
+ * it for as long as they play, and an acquired preload is never evicted; a voice that
+ * fails to acquire it streams the whole sample instead.
+ */
+struct CachedSample {
+    uint32_t end { Default::sampleEndRange.getEnd() };
+    uint32_t loopBegin { Default::loopRange.getStart() };
+    uint32_t loopEnd { Default::loopRange.getEnd() };
+    double sampleRate { config::defaultSampleRate };
+    int numChannels { 1 };
+    uint32_t numPreloadedFrames { 0 };
+    // The preload holds numPreloadedFrames times this many frames, see FilePool::setOversamplingFactor
+    int oversamplingFactor { 1 };
+    std::filesystem::path file;
+    std::unique_ptr<AudioBuffer<float>> preloadedData;
+    std::unique_ptr<MappedAudioFile> mappedFile;
+    std::atomic<bool> reloadRequested { false };
+
+    bool acquirePreload() noexcept
+    {
+        lastUse.store(now(), std::memory_order_relaxed);
+        auto state = preloadState.load(std::memory_order_relaxed);
+        do {
+            if (state & evictedFlag)
+                return false;
+        } while (!preloadState.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed));
+        return true;
+    }
+    void releasePreload() noexcept { preloadState.fetch_sub(1, std::memory_order_release); }
+    bool isPreloadResident() const noexcept { return !(preloadState.load(std::memory_order_acquire) & evictedFlag); }
+    /**
+     * Frees the preload if no voice is using it.
+     */
+    bool tryEvictPreload() noexcept
+    {
+        uint32_t unused { 0 };
+        if (!preloadState.compare_exchange_strong(unused, evictedFlag, std::memory_order_acq_rel))
+            return false;
+        preloadedData.reset();
+        return true;
+    }
+    /**
+     * Publishes the preload again after an eviction.
+     */
+    void restorePreload(std::unique_ptr<AudioBuffer<float>> data) noexcept
+    {
+        preloadedData = std::move(data);
+        lastUse.store(now(), std::memory_order_relaxed);
+        preloadState.store(0, std::memory_order_release);
+    }
+    size_t getPreloadSize() const noexcept { return static_cast<size_t>(numPreloadedFrames) * oversamplingFactor * numChannels * sizeof(float); }
+    int64_t getLastUse() const noexcept { return lastUse.load(std::memory_order_relaxed); }
+private:
+    static int64_t now() noexcept { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+    // The highest bit is set while evicted, the rest counts the voices using the preload
+    static constexpr uint32_t evictedFlag { 1u << 31 };
+    std::atomic<uint32_t> preloadState { 0 };
+    std::atomic<int64_t> lastUse { now() };
+};
+
+/**
+ * Process-wide cache of the loaded samples, so that several Synth instances using the
+ * same files only preload and map them once. The cache only holds weak references:
+ * a sample is released when the last file pool holding it lets go.
+ * Files are identified by their canonical path, and a change of inode or modification
+ * time counts as a different file. Each oversampling factor has its own copy of a file.
+ */
+class SampleCache {
+public:
+    static SampleCache& getInstance() noexcept;
+
+    struct FileIdentity {
+        std::string path;
+        uint64_t device { 0 };
+        uint64_t inode { 0 };
+        int64_t modificationTime { 0 };
+        bool operator==(const FileIdentity& other) const noexcept
+        {
+            return path == other.path && device == other.device && inode == other.inode && modificationTime == other.modificationTime;
+        }
+    };
+    /**
+     * @return the identity of an existing file, or nothing if it cannot be accessed
+     */
+    static std::optional<FileIdentity> identify(const std::filesystem::path& file) noexcept;
+    /**
+     * Looks up a sample and updates the hit and miss counters.
+     */
+    std::shared_ptr<CachedSample> find(const FileIdentity& identity, int oversamplingFactor = 1) noexcept;
+    /**
+     * Adds a freshly loaded sample. If another thread inserted the same file in the
+     * meantime, its sample is returned instead and should be used.
+     */
+    std::shared_ptr<CachedSample> insert(const FileIdentity& identity, std::shared_ptr<CachedSample> sample) noexcept;
+
+    struct Statistics {
+        uint64_t hits { 0 };
+        uint64_t misses { 0 };
+        size_t numCachedSamples { 0 };
+    };
+    Statistics getStatistics() noexcept;
+    void resetStatistics() noexcept;
+private:
+    SampleCache() = default;
+    void purgeExpired() noexcept;
+    struct Entry {
+        FileIdentity identity;
+        std::weak_ptr<CachedSample> sample;
+    };
+    std::mutex entriesMutex;
+    // Keyed by path and oversampling factor
+    absl::flat_hash_map<std::pair<std::string, int>, Entry> entries;
+    size_t nextPurgeSize { minimumPurgeSize };
+    static constexpr size_t minimumPurgeSize { 64 };
+    std::atomic<uint64_t> hits { 0 };
+    std::atomic<uint64_t> misses { 0 };
+};
+}
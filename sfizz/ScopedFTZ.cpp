@@ -28,6 +28,7 @@
 #include <intrin.h>
 #elif (HAVE_ARM_NEON_H)
 #include "arm_neon.h"
+#include <cstdint>
 #endif
 
 
@@ -37,6 +38,12 @@ ScopedFTZ::ScopedFTZ()
     unsigned mask = _MM_DENORMALS_ZERO_MASK | _MM_FLUSH_ZERO_MASK;
     registerState = _mm_getcsr();
     _mm_setcsr((registerState & (~mask)) | mask);
+#elif HAVE_ARM_NEON_H && __aarch64__
+    // The FZ bit moved to the 64-bit FPCR, whose upper half is reserved
+    uint64_t state;
+    asm volatile("mrs %0, fpcr" : "=r"(state));
+    registerState = static_cast<unsigned>(state);
+    asm volatile("msr fpcr, %0" : : "r"(state | (1 << 24)));
 #elif HAVE_ARM_NEON_H
     intptr_t mask = (1 << 24);
     asm volatile("vmrs %0, fpscr" : "=r"(registerState));
@@ -48,7 +55,9 @@ ScopedFTZ::~ScopedFTZ()
 {
 #if (HAVE_X86INTRIN_H || HAVE_INTRIN_H)
     _mm_setcsr(registerState);
+#elif HAVE_ARM_NEON_H && __aarch64__
+    asm volatile("msr fpcr, %0" : : "r"(static_cast<uint64_t>(registerState)));
 #elif HAVE_ARM_NEON_H
-    asm volatile("vmsr %0, fpscr" : : "ri"(registerState));
+    asm volatile("vmsr fpscr, %0" : : "r"(registerState));
 #endif
 }
\ No newline at end of file
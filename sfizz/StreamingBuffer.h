@@ -0,0 +1,159 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "AudioBuffer.h"
+#include "AudioSpan.h"
+#include "Config.h"
+#include "Debug.h"
+#include "LeakDetector.h"
+#include "SIMDHelpers.h"
+#include <absl/types/span.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace sfz {
+/**
+ * Fixed-size ring of frames filled by the file loading thread and read by a single voice.
+ * Each stream is identified by a ticket; the loader only copies and publishes frames while
+ * its ticket is still the current one. A loader registers as a writer before checking its
+ * ticket, and start waits for the writers of an earlier stream to finish their copy, so
+ * a stale loader never overwrites the frames of the new stream. Those copies are a single
+ * chunk long, since the loader reads the file beforehand.
+ * The ring is surrounded by history frames mirroring its end and guard frames mirroring its
+ * start, so that the interpolation can read a few frames on each side of an index without
+ * wrapping. The writer keeps the history frames free, since the reader may still need them.
+ */
+class StreamingBuffer {
+public:
+    StreamingBuffer(int numChannels = config::numChannels, uint32_t capacity = config::streamingBufferSize,
+        uint32_t numHistoryFrames = 0, uint32_t numGuardFrames = 1)
+        : capacity(capacity)
+        , mask(capacity - 1)
+        , numHistoryFrames(numHistoryFrames)
+        , numGuardFrames(numGuardFrames)
+        , frames(numChannels, numHistoryFrames + capacity + numGuardFrames)
+    {
+        // The capacity has to be a power of 2
+        ASSERT((capacity & mask) == 0);
+        ASSERT(numHistoryFrames < capacity && numGuardFrames <= capacity);
+    }
+
+    // Reader side
+    void start(unsigned ticket) noexcept
+    {
+        // The writers registered before this store finish their copy, the later ones see
+        // that their ticket is over
+        state.store(pack(noTicket, 0), std::memory_order_seq_cst);
+        while (writers.load(std::memory_order_seq_cst) != 0)
+            std::this_thread::yield();
+
+        // Before the first lap, the frames preceding the stream are silent
+        for (int channelIndex = 0; channelIndex < frames.getNumChannels(); ++channelIndex)
+            ::fill<float>(frames.getSpan(channelIndex).first(numHistoryFrames), 0.0f);
+        consumed.store(0, std::memory_order_relaxed);
+        state.store(pack(ticket, 0), std::memory_order_release);
+    }
+    // Leaves the frames to the writers still copying; the next start waits for them
+    void stop() noexcept { state.store(pack(noTicket, 0), std::memory_order_release); }
+    uint32_t availableFrames(unsigned ticket) const noexcept
+    {
+        const auto currentState = state.load(std::memory_order_acquire);
+        if (ticketOf(currentState) != ticket)
+            return 0;
+        return writtenOf(currentState);
+    }
+    void consume(uint32_t position) noexcept { consumed.store(position, std::memory_order_release); }
+    absl::Span<const float> getSpan(int channelIndex) const noexcept
+    {
+        return frames.getConstSpan(channelIndex).subspan(numHistoryFrames, capacity + numGuardFrames);
+    }
+    // Includes the history frames, so that ring frame i is at index i + getNumHistoryFrames()
+    absl::Span<const float> getPaddedSpan(int channelIndex) const noexcept { return frames.getConstSpan(channelIndex); }
+    uint32_t getCapacity() const noexcept { return capacity; }
+    uint32_t getNumHistoryFrames() const noexcept { return numHistoryFrames; }
+    uint32_t getNumGuardFrames() const noexcept { return numGuardFrames; }
+    int getNumChannels() const noexcept { return frames.getNumChannels(); }
+
+    // Writer side
+    bool isCurrent(unsigned ticket) const noexcept
+    {
+        return ticket != noTicket && ticketOf(state.load(std::memory_order_acquire)) == ticket;
+    }
+    uint32_t freeFrames(uint32_t written) const noexcept
+    {
+        return capacity - numHistoryFrames - (written - consumed.load(std::memory_order_acquire));
+    }
+    // Whether a loader is copying frames, in which case start would wait for it
+    bool isBeingWritten() const noexcept { return writers.load(std::memory_order_acquire) != 0; }
+    bool write(unsigned ticket, uint32_t position, AudioSpan<const float> input) noexcept
+    {
+        writers.fetch_add(1, std::memory_order_seq_cst);
+        if (ticket == noTicket || ticketOf(state.load(std::memory_order_seq_cst)) != ticket) {
+            writers.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+
+        const auto numFrames = static_cast<uint32_t>(input.getNumFrames());
+        ASSERT(numFrames <= freeFrames(position));
+        ASSERT(input.getNumChannels() <= frames.getNumChannels());
+
+        const auto start = position & mask;
+        const auto firstPart = std::min(numFrames, capacity - start);
+        for (int channelIndex = 0; channelIndex < input.getNumChannels(); ++channelIndex) {
+            const auto in = input.getConstSpan(channelIndex);
+            const auto padded = frames.getSpan(channelIndex);
+            const auto out = padded.subspan(numHistoryFrames);
+            ::copy<float>(in.first(firstPart), out.subspan(start, firstPart));
+            ::copy<float>(in.subspan(firstPart), out.first(numFrames - firstPart));
+            if (start < numGuardFrames || firstPart < numFrames)
+                ::copy<float>(out.first(numGuardFrames), out.subspan(capacity, numGuardFrames));
+            if (start + firstPart > capacity - numHistoryFrames)
+                ::copy<float>(out.subspan(capacity - numHistoryFrames, numHistoryFrames), padded.first(numHistoryFrames));
+        }
+
+        auto expected = pack(ticket, position);
+        const bool published = state.compare_exchange_strong(expected, pack(ticket, position + numFrames), std::memory_order_acq_rel);
+        writers.fetch_sub(1, std::memory_order_release);
+        return published;
+    }
+
+    static constexpr unsigned noTicket { 0 };
+private:
+    static constexpr uint64_t pack(unsigned ticket, uint32_t written) noexcept { return (static_cast<uint64_t>(ticket) << 32) | written; }
+    static constexpr unsigned ticketOf(uint64_t state) noexcept { return static_cast<unsigned>(state >> 32); }
+    static constexpr uint32_t writtenOf(uint64_t state) noexcept { return static_cast<uint32_t>(state); }
+
+    const uint32_t capacity;
+    const uint32_t mask;
+    const uint32_t numHistoryFrames;
+    const uint32_t numGuardFrames;
+    AudioBuffer<float> frames;
+    std::atomic<uint64_t> state { pack(noTicket, 0) };
+    std::atomic<uint32_t> consumed { 0 };
+    std::atomic<int> writers { 0 };
+    LEAK_DETECTOR(StreamingBuffer);
+};
+
+}
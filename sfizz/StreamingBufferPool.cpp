@@ -0,0 +1,87 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "StreamingBufferPool.h"
+#include <algorithm>
+
+sfz::StreamingBufferPool::StreamingBufferPool(int maxBuffers, int numSpareBuffers)
+    : maxBuffers(maxBuffers)
+    , numSpareBuffers(std::min(numSpareBuffers, maxBuffers))
+    , newBuffers(maxBuffers)
+{
+    buffers.reserve(maxBuffers);
+    freeBuffers.reserve(maxBuffers);
+    replenish();
+}
+
+sfz::StreamingBuffer* sfz::StreamingBufferPool::acquire() noexcept
+{
+    if (freeBuffers.empty()) {
+        StreamingBuffer* buffer;
+        while (newBuffers.try_dequeue(buffer))
+            freeBuffers.push_back(buffer);
+    }
+
+    if (freeBuffers.empty())
+        return nullptr;
+
+    // The most recently released buffers are the likeliest to still be written to
+    auto available = std::find_if(freeBuffers.rbegin(), freeBuffers.rend(), [](const StreamingBuffer* buffer) {
+        return !buffer->isBeingWritten();
+    });
+    if (available != freeBuffers.rend())
+        std::iter_swap(available, freeBuffers.rbegin());
+
+    auto buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    numSpare--;
+    return buffer;
+}
+
+void sfz::StreamingBufferPool::release(StreamingBuffer* buffer) noexcept
+{
+    if (buffer == nullptr)
+        return;
+
+    freeBuffers.push_back(buffer);
+    numSpare++;
+}
+
+void sfz::StreamingBufferPool::replenish() noexcept
+{
+    if (numSpare.load() >= numSpareBuffers)
+        return;
+
+    std::unique_lock<std::mutex> lock { replenishMutex, std::try_to_lock };
+    if (!lock.owns_lock())
+        return;
+
+    while (numSpare.load() < numSpareBuffers && static_cast<int>(buffers.size()) < maxBuffers) {
+        buffers.push_back(std::make_unique<StreamingBuffer>(config::numChannels, config::streamingBufferSize,
+            config::maxInterpolationHistory, config::maxInterpolationLookahead));
+        // The queue holds as many buffers as the pool, so this never allocates nor fails
+        newBuffers.try_enqueue(buffers.back().get());
+        numAllocated++;
+        numSpare++;
+    }
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+#include "Config.h"
+#include "LeakDetector.h"
+#include "StreamingBuffer.h"
+#include "readerwriterqueue.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sfz {
+/**
+ * The streaming buffers of the voices. Each one is large, and most voices play from their
+ * preloaded data or a generator, so a voice only holds a buffer while it streams.
+ * The audio thread takes and returns the buffers without locking or allocating, while
+ * another thread keeps a few spare ones allocated, up to the maximum number of voices.
+ * The buffers are only freed with the pool. A loader of the previous voice may still be
+ * copying a chunk into a returned buffer, in which case StreamingBuffer::start waits for
+ * it; acquire hands out the buffers that no loader is writing to first.
+ */
+class StreamingBufferPool {
+public:
+    StreamingBufferPool(int maxBuffers = config::maxVoices + config::maxVoices / config::stolenVoicesDivider,
+        int numSpareBuffers = config::numSpareStreamingBuffers);
+    StreamingBufferPool(const StreamingBufferPool&) = delete;
+    StreamingBufferPool& operator=(const StreamingBufferPool&) = delete;
+
+    // Audio thread; acquire returns nullptr when no buffer is spare
+    StreamingBuffer* acquire() noexcept;
+    void release(StreamingBuffer* buffer) noexcept;
+
+    /**
+     * Allocates buffers until enough of them are spare. Any thread but the audio one may
+     * call it, and it returns at once if another thread is already at it.
+     */
+    void replenish() noexcept;
+    int getNumAllocated() const noexcept { return numAllocated.load(); }
+    int getNumSpare() const noexcept { return numSpare.load(); }
+private:
+    const int maxBuffers;
+    const int numSpareBuffers;
+    // Grown by the replenishing thread and never shrunk
+    std::vector<std::unique_ptr<StreamingBuffer>> buffers;
+    std::mutex replenishMutex;
+    moodycamel::ReaderWriterQueue<StreamingBuffer*> newBuffers;
+    // Only touched by the audio thread
+    std::vector<StreamingBuffer*> freeBuffers;
+    std::atomic<int> numSpare { 0 };
+    std::atomic<int> numAllocated { 0 };
+    LEAK_DETECTOR(StreamingBufferPool);
+};
+}
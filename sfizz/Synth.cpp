@@ -23,21 +23,79 @@
 
 #include "Synth.h"
 #include "Debug.h"
+#include "RealtimeChecks.h"
 #include "ScopedFTZ.h"
 #include "StringViewHelpers.h"
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_set.h"
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <utility>
 
 sfz::Synth::Synth()
 {
-    for (int i = 0; i < config::numVoices; ++i)
-        voices.push_back(std::make_unique<Voice>(ccState));
+    instrument = std::make_unique<Instrument>();
+    loadedInstrument = instrument.get();
+    drainingInstruments.reserve(config::maxDrainingInstruments);
+    setNumVoices(config::numVoices);
+}
+
+sfz::Synth::~Synth()
+{
+    if (loadingThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> requestLock { requestMutex };
+            quitLoadingThread = true;
+        }
+        loadRequested.notify_one();
+        loadingThread.join();
+    }
+
+    std::unique_ptr<Instrument> pending { pendingInstrument.exchange(nullptr) };
+    reclaimInstruments();
+}
+
+void sfz::Synth::setNumVoices(int numVoices) noexcept
+{
+    this->numVoices = std::clamp(numVoices, 1, config::maxVoices);
+
+    // The pending loads are for the voices about to be destroyed
+    resetVoices();
+    filePool.cancelLoading();
+
+    const int numAllocatedVoices = this->numVoices + std::max(1, this->numVoices / config::stolenVoicesDivider);
+    voices.clear();
+    for (int i = 0; i < numAllocatedVoices; ++i) {
+        auto voice = std::make_unique<Voice>(ccState);
+        voice->setSampleRate(sampleRate);
+        voice->setSamplesPerBlock(samplesPerBlock);
+        voice->setSampleQuality(sampleQuality);
+        voices.push_back(std::move(voice));
+    }
+    activeVoices.reserve(voices.size());
+    freeVoices.reserve(voices.size());
+    resetVoices();
+}
+
+void sfz::Synth::resetVoices() noexcept
+{
+    activeVoices.clear();
+    freeVoices.clear();
+    numStolenVoices = 0;
+    // The free voices are taken from the back, in the same order as the voices
+    for (auto voice = voices.rbegin(); voice != voices.rend(); ++voice) {
+        (*voice)->reset();
+        filePool.releaseStreamingBuffer((*voice)->takeStreamingBuffer());
+        freeVoices.push_back(voice->get());
+    }
 }
 
 void sfz::Synth::callback(std::string_view header, const std::vector<Opcode>& members)
 {
+    if (!instrumentCacheDirectory.empty() && !loadedFromCache)
+        parsedHeaders.push_back({ header, members });
+
     switch (hash(header)) {
     case hash("global"):
         // We shouldn't have multiple global headers in file
@@ -96,7 +154,7 @@ void sfz::Synth::buildRegion(const std::vector<Opcode>& regionOpcodes)
     parseOpcodes(groupOpcodes);
     parseOpcodes(regionOpcodes);
 
-    regions.push_back(std::move(lastRegion));
+    loadingInstrument->regions.push_back(std::move(lastRegion));
 }
 
 void sfz::Synth::clear()
@@ -106,15 +164,64 @@ void sfz::Synth::clear()
     numGroups = 0;
     numMasters = 0;
     numCurves = 0;
-    fileTicket = -1;
     defaultSwitch = std::nullopt;
-    for (auto& state : ccState)
-        state = 0;
     ccNames.clear();
     globalOpcodes.clear();
     masterOpcodes.clear();
     groupOpcodes.clear();
-    regions.clear();
+    unknownOpcodes.clear();
+    loadingInstrument = std::make_unique<Instrument>();
+    filePool.clear();
+    loadedFromCache = false;
+    parsedHeaders.clear();
+    instrumentCache.close();
+}
+
+void sfz::Synth::setInstrumentCacheDirectory(const std::filesystem::path& directory, bool storePreloads) noexcept
+{
+    instrumentCacheDirectory = directory;
+    cachePreloads = storePreloads;
+}
+
+bool sfz::Synth::loadFromCache(const std::filesystem::path& file, const std::filesystem::path& cacheFile)
+{
+    if (!instrumentCache.open(cacheFile, file))
+        return false;
+
+    DBG("Loading " << file << " from the instrument cache");
+    loadedFromCache = true;
+    restoreParsedState(file, instrumentCache.getDefines(), instrumentCache.getIncludedFiles());
+    for (auto& header : instrumentCache.getHeaders())
+        callback(header.name, header.members);
+
+    // The samples are resolved relative to the default path set in the replayed headers
+    filePool.setRootDirectory(this->rootDirectory);
+    for (auto& sample : instrumentCache.getSamples()) {
+        if (!filePool.restoreSample(sample))
+            DBG("Could not restore " << sample.name << " from the instrument cache");
+    }
+
+    return true;
+}
+
+void sfz::Synth::writeCache(const std::filesystem::path& file, const std::filesystem::path& cacheFile)
+{
+    InstrumentCache::Contents contents;
+    contents.sfzFile = file;
+    contents.includedFiles = getIncludedFiles();
+    contents.defines = getDefines();
+    contents.headers = std::move(parsedHeaders);
+    contents.storePreloads = cachePreloads;
+    // The views point into the regions, which outlive the write
+    absl::flat_hash_set<std::string_view> storedSamples;
+    for (auto& region : loadingInstrument->regions) {
+        if (region->cachedSample && storedSamples.insert(region->sample).second)
+            contents.samples.emplace_back(region->sample, region->cachedSample);
+    }
+
+    if (!InstrumentCache::write(cacheFile, contents))
+        DBG("Could not write the instrument cache " << cacheFile);
+    parsedHeaders.clear();
 }
 
 void sfz::Synth::handleGlobalOpcodes(const std::vector<Opcode>& members)
@@ -134,7 +241,7 @@ void sfz::Synth::handleControlOpcodes(const std::vector<Opcode>& members)
         switch (hash(member.opcode)) {
         case hash("set_cc"):
             if (member.parameter && Default::ccRange.containsWithEnd(*member.parameter))
-                setValueFromOpcode(member, ccState[*member.parameter], Default::ccRange);
+                setValueFromOpcode(member, loadingInstrument->ccState[*member.parameter], Default::ccRange);
             break;
         case hash("label_cc"):
             if (member.parameter && Default::ccRange.containsWithEnd(*member.parameter))
@@ -170,12 +277,138 @@ void addEndpointsToVelocityCurve(sfz::Region& region)
 }
 
 bool sfz::Synth::loadSfzFile(const std::filesystem::path& filename)
+{
+    std::lock_guard<std::mutex> loadLock { loadMutex };
+    const bool loaded = loadInstrument(filename);
+
+    // Nothing renders meanwhile, so the instrument is replaced right away
+    resetVoices();
+    drainingInstruments.clear();
+    std::unique_ptr<Instrument> pending { pendingInstrument.exchange(nullptr) };
+    reclaimInstruments();
+    instrument = std::move(loadingInstrument);
+    loadedInstrument = instrument.get();
+    applyInstrumentCCs();
+    return loaded;
+}
+
+bool sfz::Synth::loadSfzFileAsync(const std::filesystem::path& file) noexcept
+{
+    std::lock_guard<std::mutex> requestLock { requestMutex };
+    if (loadingStatus == LoadingStatus::Loading)
+        return false;
+
+    requestedFile = file;
+    loadingStatus = LoadingStatus::Loading;
+    if (!loadingThread.joinable())
+        loadingThread = std::thread(&Synth::loadRequestedFiles, this);
+    loadRequested.notify_one();
+    return true;
+}
+
+void sfz::Synth::loadRequestedFiles() noexcept
+{
+    using namespace std::chrono_literals;
+    while (true) {
+        std::filesystem::path file;
+        {
+            // Wakes up regularly to destroy the instruments handed back by the audio thread
+            std::unique_lock<std::mutex> requestLock { requestMutex };
+            loadRequested.wait_for(requestLock, 100ms, [this]() { return quitLoadingThread || !requestedFile.empty(); });
+            if (quitLoadingThread)
+                return;
+            std::swap(file, requestedFile);
+        }
+
+        std::lock_guard<std::mutex> loadLock { loadMutex };
+        if (!file.empty()) {
+            if (loadInstrument(file)) {
+                loadedInstrument = loadingInstrument.get();
+                // The audio thread may not have taken the previous instrument yet
+                std::unique_ptr<Instrument> skipped { pendingInstrument.exchange(loadingInstrument.release()) };
+                loadingStatus = LoadingStatus::Loaded;
+            } else {
+                loadingInstrument.reset();
+                loadingStatus = LoadingStatus::Failed;
+            }
+        }
+        reclaimInstruments();
+    }
+}
+
+void sfz::Synth::swapInstrument() noexcept
+{
+    // The voices start in order, so the voices of a replaced instrument have all stopped
+    // once the oldest one playing started after the replacement
+    uint64_t oldestStartOrder { numStartedVoices };
+    for (auto voice : activeVoices)
+        oldestStartOrder = std::min(oldestStartOrder, voice->getStartOrder());
+
+    auto drained = drainingInstruments.begin();
+    while (drained != drainingInstruments.end() && drained->replacedAt <= oldestStartOrder
+        && retiredInstruments.try_enqueue(drained->instrument.get())) {
+        drained->instrument.release();
+        ++drained;
+    }
+    drainingInstruments.erase(drainingInstruments.begin(), drained);
+
+    if (pendingInstrument.load() == nullptr)
+        return;
+
+    if (drainingInstruments.size() == config::maxDrainingInstruments) {
+        // Fades out the oldest instrument still playing before replacing the current one
+        for (auto voice : activeVoices) {
+            if (voice->getStartOrder() < drainingInstruments.front().replacedAt && !voice->isStolen()) {
+                voice->steal(0);
+                numStolenVoices++;
+            }
+        }
+        return;
+    }
+
+    if (auto next = pendingInstrument.exchange(nullptr)) {
+        drainingInstruments.push_back({ std::move(instrument), numStartedVoices });
+        instrument.reset(next);
+        applyInstrumentCCs();
+    }
+}
+
+void sfz::Synth::applyInstrumentCCs() noexcept
+{
+    for (int ccNumber = 0; ccNumber < static_cast<int>(ccState.size()); ++ccNumber) {
+        if (!receivedCCs.test(ccNumber)) {
+            ccState[ccNumber] = instrument->ccState[ccNumber];
+            continue;
+        }
+
+        // The regions were loaded with the defaults, so they learn the live value
+        for (auto& region : instrument->regions)
+            region->registerCC(region->channelRange.getStart(), ccNumber, ccState[ccNumber]);
+    }
+}
+
+void sfz::Synth::reclaimInstruments() noexcept
+{
+    Instrument* retired;
+    while (retiredInstruments.try_dequeue(retired))
+        std::unique_ptr<Instrument> destroyed { retired };
+}
+
+bool sfz::Synth::loadInstrument(const std::filesystem::path& filename)
 {
     clear();
-    auto parserReturned = sfz::Parser::loadSfzFile(filename);
+    std::filesystem::path cacheFile;
+    if (!instrumentCacheDirectory.empty())
+        cacheFile = instrumentCacheDirectory / InstrumentCache::getCacheFileName(filename);
+
+    auto parserReturned = !cacheFile.empty() && loadFromCache(filename, cacheFile);
+    if (!parserReturned)
+        parserReturned = sfz::Parser::loadSfzFile(filename);
+
     if (!parserReturned)
         return false;
 
+    auto& regions = loadingInstrument->regions;
     if (regions.empty())
         return false;
 
@@ -196,19 +429,30 @@ bool sfz::Synth::loadSfzFile(const std::filesystem::path& filename)
             }
             region->sampleEnd = std::min(region->sampleEnd, fileInformation->end);
             region->loopRange.shrinkIfSmaller(fileInformation->loopBegin, fileInformation->loopEnd);
-            region->preloadedData = fileInformation->preloadedData;
+            region->cachedSample = fileInformation->sample;
             region->sampleRate = fileInformation->sampleRate;
         }
 
-        for (auto note = region->keyRange.getStart(); note <= region->keyRange.getEnd(); note++)
-            noteActivationLists[note].push_back(region);
+        for (int note = 0; note < 128; note++) {
+            if (region->isAffectedByNote(note))
+                loadingInstrument->noteActivationLists[note].push_back(region);
+        }
 
-        for (auto cc = region->keyRange.getStart(); cc <= region->keyRange.getEnd(); cc++)
-            ccActivationLists[cc].push_back(region);
+        for (int cc = 0; cc < 128; cc++) {
+            if (region->isAffectedByCC(cc))
+                loadingInstrument->ccActivationLists[cc].push_back(region);
+        }
+
+        if (region->isAffectedByPitchWheel())
+            loadingInstrument->pitchWheelActivationList.push_back(region);
+        if (region->isAffectedByAftertouch())
+            loadingInstrument->aftertouchActivationList.push_back(region);
+        if (region->isAffectedByTempo())
+            loadingInstrument->tempoActivationList.push_back(region);
 
         // Defaults
         for (int ccIndex = 1; ccIndex < 128; ccIndex++)
-            region->registerCC(region->channelRange.getStart(), ccIndex, ccState[ccIndex]);
+            region->registerCC(region->channelRange.getStart(), ccIndex, loadingInstrument->ccState[ccIndex]);
 
         if (defaultSwitch) {
             region->registerNoteOn(region->channelRange.getStart(), *defaultSwitch, 127, 1.0);
@@ -225,41 +469,115 @@ bool sfz::Synth::loadSfzFile(const std::filesystem::path& filename)
 
     DBG("Removed " << regions.size() - std::distance(regions.begin(), lastRegion) - 1 << " out of " << regions.size() << " regions.");
     regions.resize(std::distance(regions.begin(), lastRegion) + 1);
+    if (!cacheFile.empty() && !loadedFromCache)
+        writeCache(filename, cacheFile);
+
     return parserReturned;
 }
 
-sfz::Voice* sfz::Synth::findFreeVoice() noexcept
+sfz::Voice* sfz::Synth::findFreeVoice(int delay, int channel, int number, Voice::TriggerType triggerType) noexcept
 {
-    auto freeVoice = absl::c_find_if(voices, [](const auto& voice) { return voice->isFree(); });
-    if (freeVoice == voices.end()) {
-        DBG("Voices are overloaded, can't start a new note");
+    if (static_cast<int>(activeVoices.size()) - numStolenVoices >= numVoices) {
+        if (auto stolenVoice = findVoiceToSteal(channel, number, triggerType)) {
+            stolenVoice->steal(delay);
+            numStolenVoices++;
+        }
+    }
+
+    if (!freeVoices.empty()) {
+        auto freeVoice = freeVoices.back();
+        freeVoices.pop_back();
+        activeVoices.push_back(freeVoice);
+        return freeVoice;
+    }
+
+    // Too many voices are fading out at once: cut the oldest one short
+    Voice* oldestStolenVoice { nullptr };
+    for (auto voice : activeVoices) {
+        if (voice->isStolen() && (oldestStolenVoice == nullptr || voice->getStartOrder() < oldestStolenVoice->getStartOrder()))
+            oldestStolenVoice = voice;
+    }
+
+    if (oldestStolenVoice == nullptr) {
+        numDroppedNotes.fetch_add(1, std::memory_order_relaxed);
         return {};
     }
-    return freeVoice->get();
+
+    oldestStolenVoice->reset();
+    numStolenVoices--;
+    return oldestStolenVoice;
 }
 
-void sfz::Synth::getNumActiveVoices() const noexcept
+sfz::Voice* sfz::Synth::findVoiceToSteal(int channel, int number, Voice::TriggerType triggerType) noexcept
 {
-    auto activeVoices { 0 };
-    for (const auto& voice : voices) {
-        if (!voice->isFree())
-            activeVoices++;
+    const bool isNote = (triggerType != Voice::TriggerType::CC);
+    auto isSameNote = [&](const Voice* voice) {
+        return isNote && voice->getTriggerType() != Voice::TriggerType::CC
+            && voice->getTriggerChannel() == channel && voice->getTriggerNumber() == number;
+    };
+
+    // The policy decides first, and the oldest voice wins among equals
+    auto isBetterVictim = [&](const Voice* voice, const Voice* victim) {
+        switch (stealingPolicy) {
+        case StealingPolicy::Quietest:
+            if (voice->getEnvelopeLevel() != victim->getEnvelopeLevel())
+                return voice->getEnvelopeLevel() < victim->getEnvelopeLevel();
+            break;
+        case StealingPolicy::SameNoteFirst:
+            if (isSameNote(voice) != isSameNote(victim))
+                return isSameNote(voice);
+            break;
+        case StealingPolicy::ReleasedFirst:
+            if (voice->isReleased() != victim->isReleased())
+                return voice->isReleased();
+            break;
+        case StealingPolicy::Oldest:
+            break;
+        }
+        return voice->getStartOrder() < victim->getStartOrder();
+    };
+
+    Voice* victim { nullptr };
+    for (auto voice : activeVoices) {
+        if (!voice->isStolen() && (victim == nullptr || isBetterVictim(voice, victim)))
+            victim = voice;
     }
+    return victim;
 }
 
-void sfz::Synth::garbageCollect() noexcept
+void sfz::Synth::startVoice(Region* region, int delay, int channel, int number, uint8_t value, Voice::TriggerType triggerType) noexcept
 {
-    for (auto& voice : voices) {
-        voice->garbageCollect();
+    auto voice = findFreeVoice(delay, channel, number, triggerType);
+    if (voice == nullptr)
+        return;
+
+    // A stolen voice cut short still holds the buffer of its previous stream
+    filePool.releaseStreamingBuffer(voice->takeStreamingBuffer());
+    voice->startVoice(region, delay, channel, number, value, triggerType);
+    voice->setStartOrder(numStartedVoices++);
+    if (voice->needsFileData()) {
+        // Offline renders rather wait for the loading threads to allocate more buffers
+        const auto timeout = std::chrono::milliseconds(freewheeling ? config::freewheelingTimeout : 0);
+        if (auto buffer = filePool.acquireStreamingBuffer(timeout)) {
+            voice->expectFileData(buffer, fileTicket);
+            filePool.enqueueLoading(voice, region, fileTicket++);
+        } else {
+            voice->skipFileData();
+        }
     }
 }
 
+int sfz::Synth::getNumActiveVoices() const noexcept
+{
+    return static_cast<int>(activeVoices.size());
+}
 void sfz::Synth::setSamplesPerBlock(int samplesPerBlock) noexcept
 {
     this->samplesPerBlock = samplesPerBlock;
     this->tempBuffer.resize(samplesPerBlock);
     for (auto& voice : voices)
         voice->setSamplesPerBlock(samplesPerBlock);
+    renderPool.setSamplesPerBlock(samplesPerBlock);
 }
 
 void sfz::Synth::setSampleRate(float sampleRate) noexcept
@@ -269,87 +587,267 @@ void sfz::Synth::setSampleRate(float sampleRate) noexcept
         voice->setSampleRate(sampleRate);
 }
 
+void sfz::Synth::setSampleQuality(int quality) noexcept
+{
+    sampleQuality = std::clamp(quality, 0, config::maxSampleQuality);
+    // Builds the tables now rather than when a voice starts on the audio thread
+    getSincTable(interpolatorModel(sampleQuality), 1.0f);
+    for (auto& voice : voices)
+        voice->setSampleQuality(sampleQuality);
+}
+
 void sfz::Synth::renderBlock(AudioSpan<float> buffer) noexcept
 {
+    ScopedRealtimeSection realtime;
     ScopedFTZ ftz;
+    swapInstrument();
+    processCommands(static_cast<int>(buffer.getNumFrames()));
+    if (freewheeling)
+        waitForStreams(buffer.getNumFrames());
+
     buffer.fill(0.0f);
-    auto tempSpan = AudioSpan<float>(tempBuffer).first(buffer.getNumFrames());
-    for (auto& voice : voices) {
-        voice->renderBlock(tempSpan);
-        buffer.add(tempSpan);
+    if (renderPool.getNumThreads() > 0 && activeVoices.size() > 1) {
+        renderPool.render(activeVoices, buffer);
+    } else {
+        auto tempSpan = AudioSpan<float>(tempBuffer).first(buffer.getNumFrames());
+        for (auto voice : activeVoices) {
+            voice->renderBlock(tempSpan);
+            buffer.add(tempSpan);
+        }
+    }
+
+    for (size_t i = 0; i < activeVoices.size();) {
+        auto voice = activeVoices[i];
+        if (voice->isFree()) {
+            activeVoices[i] = activeVoices.back();
+            activeVoices.pop_back();
+            filePool.releaseStreamingBuffer(voice->takeStreamingBuffer());
+            freeVoices.push_back(voice);
+            if (voice->isStolen())
+                numStolenVoices--;
+        } else {
+            ++i;
+        }
+    }
+}
+
+void sfz::Synth::waitForStreams(size_t numFrames) noexcept
+{
+    // A stream that never arrives, for instance from an unreadable file, is given up on
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config::freewheelingTimeout);
+    for (auto voice : activeVoices) {
+        while (!voice->isStreamReady(numFrames) && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
 }
 
 void sfz::Synth::noteOn(int delay, int channel, int noteNumber, uint8_t velocity) noexcept
 {
+    ScopedRealtimeSection realtime;
+    // The activation lists are indexed by note
+    if (noteNumber < Default::keyRange.getStart() || noteNumber > Default::keyRange.getEnd())
+        return;
+
     auto randValue = randNoteDistribution(Random::randomGenerator);
 
-    for (auto& region : regions) {
+    for (auto region : instrument->noteActivationLists[noteNumber]) {
         if (region->registerNoteOn(channel, noteNumber, velocity, randValue)) {
-            for (auto& voice : voices) {
+            // Release triggers started by the off groups can add active voices
+            for (size_t i = 0; i < activeVoices.size(); ++i) {
+                auto voice = activeVoices[i];
                 if (voice->checkOffGroup(delay, region->group))
                     noteOff(delay, voice->getTriggerChannel(), voice->getTriggerNumber(), 0);
             }
 
-            auto voice = findFreeVoice();
-            if (voice == nullptr)
-                continue;
-
-            voice->startVoice(region.get(), delay, channel, noteNumber, velocity, Voice::TriggerType::NoteOn);
-            if (!region->isGenerator()) {
-                voice->expectFileData(fileTicket);
-                filePool.enqueueLoading(voice, region->sample, region->trueSampleEnd(), fileTicket++);
-            }
+            startVoice(region, delay, channel, noteNumber, velocity, Voice::TriggerType::NoteOn);
         }
     }
 }
 
 void sfz::Synth::noteOff(int delay, int channel, int noteNumber, uint8_t velocity) noexcept
 {
+    ScopedRealtimeSection realtime;
+    // The activation lists are indexed by note
+    if (noteNumber < Default::keyRange.getStart() || noteNumber > Default::keyRange.getEnd())
+        return;
+
     auto randValue = randNoteDistribution(Random::randomGenerator);
-    for (auto& voice : voices)
+    for (auto voice : activeVoices)
         voice->registerNoteOff(delay, channel, noteNumber, velocity);
 
-    for (auto& region : regions) {
-        if (region->registerNoteOff(channel, noteNumber, velocity, randValue)) {
-            auto voice = findFreeVoice();
-            if (voice == nullptr)
-                continue;
-
-            voice->startVoice(region.get(), delay, channel, noteNumber, velocity, Voice::TriggerType::NoteOff);
-            if (!region->isGenerator()) {
-                voice->expectFileData(fileTicket);
-                filePool.enqueueLoading(voice, region->sample, region->trueSampleEnd(), fileTicket++);
-            }
-        }
+    for (auto region : instrument->noteActivationLists[noteNumber]) {
+        if (region->registerNoteOff(channel, noteNumber, velocity, randValue))
+            startVoice(region, delay, channel, noteNumber, velocity, Voice::TriggerType::NoteOff);
     }
 }
 
 void sfz::Synth::cc(int delay, int channel, int ccNumber, uint8_t ccValue) noexcept
 {
-    for (auto& voice : voices)
+    ScopedRealtimeSection realtime;
+    if (ccNumber < Default::ccRange.getStart() || ccNumber > Default::ccRange.getEnd())
+        return;
+
+    for (auto voice : activeVoices)
         voice->registerCC(delay, channel, ccNumber, ccValue);
 
     ccState[ccNumber] = ccValue;
+    receivedCCs.set(ccNumber);
 
-    for (auto& region : regions) {
-        if (region->registerCC(channel, ccNumber, ccValue)) {
-            auto voice = findFreeVoice();
-            if (voice == nullptr)
-                continue;
+    for (auto region : instrument->ccActivationLists[ccNumber]) {
+        if (region->registerCC(channel, ccNumber, ccValue))
+            startVoice(region, delay, channel, ccNumber, ccValue, Voice::TriggerType::CC);
+    }
+}
 
-            voice->startVoice(region.get(), delay, channel, ccNumber, ccValue, Voice::TriggerType::CC);
-            if (!region->isGenerator()) {
-                voice->expectFileData(fileTicket);
-                filePool.enqueueLoading(voice, region->sample, region->trueSampleEnd(), fileTicket++);
-            }
+void sfz::Synth::pitchWheel(int delay, int channel, int pitch) noexcept
+{
+    ScopedRealtimeSection realtime;
+    for (auto region : instrument->pitchWheelActivationList)
+        region->registerPitchWheel(channel, pitch);
+
+    for (auto voice : activeVoices)
+        voice->registerPitchWheel(delay, channel, pitch);
+}
+
+void sfz::Synth::aftertouch(int delay, int channel, uint8_t aftertouch) noexcept
+{
+    ScopedRealtimeSection realtime;
+    for (auto region : instrument->aftertouchActivationList)
+        region->registerAftertouch(channel, aftertouch);
+
+    for (auto voice : activeVoices)
+        voice->registerAftertouch(delay, channel, aftertouch);
+}
+
+void sfz::Synth::tempo(int delay, float secondsPerQuarter) noexcept
+{
+    ScopedRealtimeSection realtime;
+    for (auto region : instrument->tempoActivationList)
+        region->registerTempo(secondsPerQuarter);
+
+    for (auto voice : activeVoices)
+        voice->registerTempo(delay, secondsPerQuarter);
+}
+
+bool sfz::Synth::sendNoteOn(int delay, int channel, int noteNumber, uint8_t velocity) noexcept
+{
+    SynthCommand command;
+    command.type = SynthCommand::Type::NoteOn;
+    command.delay = delay;
+    command.channel = channel;
+    command.number = noteNumber;
+    command.value = velocity;
+    return commandQueue.push(command);
+}
+
+bool sfz::Synth::sendNoteOff(int delay, int channel, int noteNumber, uint8_t velocity) noexcept
+{
+    SynthCommand command;
+    command.type = SynthCommand::Type::NoteOff;
+    command.delay = delay;
+    command.channel = channel;
+    command.number = noteNumber;
+    command.value = velocity;
+    return commandQueue.push(command);
+}
+
+bool sfz::Synth::sendCC(int delay, int channel, int ccNumber, uint8_t ccValue) noexcept
+{
+    SynthCommand command;
+    command.type = SynthCommand::Type::CC;
+    command.delay = delay;
+    command.channel = channel;
+    command.number = ccNumber;
+    command.value = ccValue;
+    return commandQueue.push(command);
+}
+
+bool sfz::Synth::sendPitchWheel(int delay, int channel, int pitch) noexcept
+{
+    SynthCommand command;
+    command.type = SynthCommand::Type::PitchWheel;
+    command.delay = delay;
+    command.channel = channel;
+    command.number = pitch;
+    return commandQueue.push(command);
+}
+
+bool sfz::Synth::sendAftertouch(int delay, int channel, uint8_t aftertouch) noexcept
+{
+    SynthCommand command;
+    command.type = SynthCommand::Type::Aftertouch;
+    command.delay = delay;
+    command.channel = channel;
+    command.value = aftertouch;
+    return commandQueue.push(command);
+}
+
+bool sfz::Synth::sendTempo(int delay, float secondsPerQuarter) noexcept
+{
+    SynthCommand command;
+    command.type = SynthCommand::Type::Tempo;
+    command.delay = delay;
+    command.seconds = secondsPerQuarter;
+    return commandQueue.push(command);
+}
+
+bool sfz::Synth::sendSampleQuality(int quality) noexcept
+{
+    SynthCommand command;
+    command.type = SynthCommand::Type::SampleQuality;
+    command.number = std::clamp(quality, 0, config::maxSampleQuality);
+    // The audio thread must not build the tables
+    getSincTable(interpolatorModel(command.number), 1.0f);
+    return commandQueue.push(command);
+}
+
+bool sfz::Synth::sendStealingPolicy(StealingPolicy policy) noexcept
+{
+    SynthCommand command;
+    command.type = SynthCommand::Type::StealingPolicy;
+    command.number = static_cast<int>(policy);
+    return commandQueue.push(command);
+}
+
+void sfz::Synth::processCommands(int numFrames) noexcept
+{
+    SynthCommand command;
+    while (commandQueue.pop(command)) {
+        const auto delay = std::max(0, std::min(command.delay, numFrames - 1));
+        switch (command.type) {
+        case SynthCommand::Type::NoteOn:
+            noteOn(delay, command.channel, command.number, command.value);
+            break;
+        case SynthCommand::Type::NoteOff:
+            noteOff(delay, command.channel, command.number, command.value);
+            break;
+        case SynthCommand::Type::CC:
+            cc(delay, command.channel, command.number, command.value);
+            break;
+        case SynthCommand::Type::PitchWheel:
+            pitchWheel(delay, command.channel, command.number);
+            break;
+        case SynthCommand::Type::Aftertouch:
+            aftertouch(delay, command.channel, command.value);
+            break;
+        case SynthCommand::Type::Tempo:
+            tempo(delay, command.seconds);
+            break;
+        case SynthCommand::Type::SampleQuality:
+            sampleQuality = command.number;
+            for (auto& voice : voices)
+                voice->setSampleQuality(sampleQuality);
+            break;
+        case SynthCommand::Type::StealingPolicy:
+            stealingPolicy = static_cast<StealingPolicy>(command.number);
+            break;
         }
     }
 }
 
 int sfz::Synth::getNumRegions() const noexcept
 {
-    return static_cast<int>(regions.size());
+    return static_cast<int>(loadedInstrument->regions.size());
 }
 int sfz::Synth::getNumGroups() const noexcept
 {
@@ -365,7 +863,7 @@ int sfz::Synth::getNumCurves() const noexcept
 }
 const sfz::Region* sfz::Synth::getRegionView(int idx) const noexcept
 {
-    return (size_t)idx < regions.size() ? regions[idx].get() : nullptr;
+    return (size_t)idx < loadedInstrument->regions.size() ? loadedInstrument->regions[idx].get() : nullptr;
 }
 std::set<std::string_view> sfz::Synth::getUnknownOpcodes() const noexcept
 {
@@ -374,4 +872,12 @@ std::set<std::string_view> sfz::Synth::getUnknownOpcodes() const noexcept
 size_t sfz::Synth::getNumPreloadedSamples() const noexcept
 {
     return filePool.getNumPreloadedSamples();
+}
+void sfz::Synth::setPreloadMemoryBudget(size_t bytes) noexcept
+{
+    filePool.setMemoryBudget(bytes);
+}
+sfz::FilePool::Statistics sfz::Synth::getFilePoolStatistics() const noexcept
+{
+    return filePool.getStatistics();
 }
\ No newline at end of file
@@ -22,16 +22,25 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
+#include "CommandQueue.h"
 #include "FilePool.h"
+#include "InstrumentCache.h"
 #include "Parser.h"
 #include "Region.h"
+#include "RenderPool.h"
 #include "LeakDetector.h"
 #include "AudioSpan.h"
 #include "absl/types/span.h"
+#include "readerwriterqueue.h"
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <mutex>
 #include <optional>
 #include <random>
 #include <set>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 namespace sfz {
@@ -39,8 +48,31 @@ namespace sfz {
 class Synth : public Parser {
 public:
     Synth();
+    ~Synth();
+    enum class StealingPolicy {
+        Oldest,
+        Quietest, // lowest amplitude envelope level
+        SameNoteFirst,
+        ReleasedFirst
+    };
 
     bool loadSfzFile(const std::filesystem::path& file) final;
+    /**
+     * Loads a file on a background thread while the current instrument keeps playing. The new
+     * instrument takes over at the start of a later renderBlock, and the notes already playing
+     * finish on the previous one, which is then destroyed off the audio thread. The CCs sent
+     * so far keep their values on both, and only the others take the new set_cc defaults.
+     * Returns false while another load is in progress. The getters describing the instrument
+     * are only valid once the loading status has left LoadingStatus::Loading.
+     */
+    bool loadSfzFileAsync(const std::filesystem::path& file) noexcept;
+    enum class LoadingStatus {
+        Idle,
+        Loading,
+        Loaded, // the new instrument plays from the next block on
+        Failed // the previous instrument keeps playing
+    };
+    LoadingStatus getLoadingStatus() const noexcept { return loadingStatus; }
     int getNumRegions() const noexcept;
     int getNumGroups() const noexcept;
     int getNumMasters() const noexcept;
@@ -48,6 +80,15 @@ public:
     const Region* getRegionView(int idx) const noexcept;
     std::set<std::string_view> getUnknownOpcodes() const noexcept;
     size_t getNumPreloadedSamples() const noexcept;
+    void setPreloadMemoryBudget(size_t bytes) noexcept;
+    FilePool::Statistics getFilePoolStatistics() const noexcept;
+    /**
+     * Keeps a compiled copy of the loaded instruments in a directory, and loads them from
+     * there as long as the sfz files, their includes and their samples are unchanged.
+     * An empty directory disables the cache, which is the default.
+     */
+    void setInstrumentCacheDirectory(const std::filesystem::path& directory, bool storePreloads = true) noexcept;
+    bool isLoadedFromCache() const noexcept { return loadedFromCache; }
 
     void setSamplesPerBlock(int samplesPerBlock) noexcept;
     void setSampleRate(float sampleRate) noexcept;
@@ -58,9 +99,69 @@ public:
     void pitchWheel(int delay, int channel, int pitch) noexcept;
     void aftertouch(int delay, int channel, uint8_t aftertouch) noexcept;
     void tempo(int delay, float secondsPerQuarter) noexcept;
+    /**
+     * Thread-safe counterparts of the event methods, of setSampleQuality and of
+     * setStealingPolicy. They can be called from any thread while the audio thread renders,
+     * and take effect at the start of the next renderBlock, with delays counted from there.
+     * They fail when too many commands are pending. The other methods must not run
+     * concurrently with renderBlock.
+     */
+    bool sendNoteOn(int delay, int channel, int noteNumber, uint8_t velocity) noexcept;
+    bool sendNoteOff(int delay, int channel, int noteNumber, uint8_t velocity) noexcept;
+    bool sendCC(int delay, int channel, int ccNumber, uint8_t ccValue) noexcept;
+    bool sendPitchWheel(int delay, int channel, int pitch) noexcept;
+    bool sendAftertouch(int delay, int channel, uint8_t aftertouch) noexcept;
+    bool sendTempo(int delay, float secondsPerQuarter) noexcept;
+    bool sendSampleQuality(int quality) noexcept;
+    bool sendStealingPolicy(StealingPolicy policy) noexcept;
 
-    void getNumActiveVoices() const noexcept;
-    void garbageCollect() noexcept;
+    /**
+     * Sets how many notes can play at once, at most config::maxVoices. Past that, new notes
+     * steal the playing voices, which fade out over config::fastReleaseDuration.
+     * This reallocates the voices and stops them, so it is not realtime-safe.
+     */
+    void setNumVoices(int numVoices) noexcept;
+    int getNumVoices() const noexcept { return numVoices; }
+    void setStealingPolicy(StealingPolicy policy) noexcept { stealingPolicy = policy; }
+    StealingPolicy getStealingPolicy() const noexcept { return stealingPolicy; }
+    // The stolen voices count as active until they have faded out
+    int getNumActiveVoices() const noexcept;
+    // Notes that were not played because every voice was fading out a stolen one
+    uint64_t getNumDroppedNotes() const noexcept { return numDroppedNotes.load(std::memory_order_relaxed); }
+    /**
+     * Renders the voices on this many threads besides the audio thread; 0 renders serially,
+     * which is the default. This starts or stops threads, so it is not realtime-safe.
+     * The threads need a realtime priority, and the ones the system refuses it to are
+     * stopped unless realtimeOnly is false, as when rendering offline; see RenderPool.
+     */
+    void setNumRenderThreads(int numThreads, bool realtimeOnly = true) noexcept { renderPool.setNumThreads(numThreads, realtimeOnly); }
+    int getNumRenderThreads() const noexcept { return renderPool.getNumThreads(); }
+    bool hasRealtimeRenderThreads() const noexcept { return renderPool.hasRealtimeWorkers(); }
+    /**
+     * Chooses how the samples are resampled when they are transposed or do not match the
+     * output rate: 0 is linear, the default and the cheapest, 1 is a 4-point Hermite spline,
+     * and 2 to 4 are windowed sincs on 8, 16 and 32 points. The voices started afterwards
+     * use the new quality. Choosing a sinc quality for the first time computes its tables,
+     * so it is not realtime-safe.
+     */
+    void setSampleQuality(int quality) noexcept;
+    int getSampleQuality() const noexcept { return sampleQuality; }
+    /**
+     * Upsamples the preloaded data by 1, the default, 2 or 4 when loading the samples, which
+     * lets a cheap sample quality play them almost as cleanly as a windowed sinc at the cost
+     * of as many times the preload memory (see getFilePoolStatistics). Factors in between
+     * are rounded down. This applies from the next loaded instrument.
+     */
+    void setOversamplingFactor(int factor) noexcept { filePool.setOversamplingFactor(factor); }
+    int getOversamplingFactor() const noexcept { return filePool.getOversamplingFactor(); }
+    /**
+     * Makes renderBlock wait until the loading threads have streamed what the voices read,
+     * and the streaming voices for their buffers, instead of leaving gaps or cutting notes short
+     * when the loading threads fall behind, so that offline renders come out the
+     * same every time. Waiting blocks the rendering, so this is not for realtime use.
+     */
+    void setFreewheeling(bool freewheeling) noexcept { this->freewheeling = freewheeling; }
+    bool isFreewheeling() const noexcept { return freewheeling; }
 protected:
     void callback(std::string_view header, const std::vector<Opcode>& members) final;
 
@@ -71,25 +172,93 @@ private:
     int numMasters { 0 };
     int numCurves { 0 };
     void clear();
+    bool loadInstrument(const std::filesystem::path& file);
     void handleGlobalOpcodes(const std::vector<Opcode>& members);
     void handleControlOpcodes(const std::vector<Opcode>& members);
     void buildRegion(const std::vector<Opcode>& regionOpcodes);
-    
+    bool loadFromCache(const std::filesystem::path& file, const std::filesystem::path& cacheFile);
+    void writeCache(const std::filesystem::path& file, const std::filesystem::path& cacheFile);
+
+    std::filesystem::path instrumentCacheDirectory;
+    bool cachePreloads { true };
+    bool loadedFromCache { false };
+    // The parsed headers are recorded while loading without a cache so that one can be written
+    std::vector<InstrumentCache::Header> parsedHeaders;
+    InstrumentCache instrumentCache;
+
     std::vector<Opcode> globalOpcodes;
     std::vector<Opcode> masterOpcodes;
     std::vector<Opcode> groupOpcodes;
 
-    FilePool filePool;
+    // The live CC values, shared by the voices of every instrument. The CCs received from
+    // the player keep their values when an instrument replaces another, and the others take
+    // the set_cc defaults of the new instrument.
     CCValueArray ccState;
-    Voice* findFreeVoice() noexcept;
+    std::bitset<128> receivedCCs;
+    void applyInstrumentCCs() noexcept;
+    Voice* findFreeVoice(int delay, int channel, int number, Voice::TriggerType triggerType) noexcept;
+    Voice* findVoiceToSteal(int channel, int number, Voice::TriggerType triggerType) noexcept;
+    void startVoice(Region* region, int delay, int channel, int number, uint8_t value, Voice::TriggerType triggerType) noexcept;
     std::vector<CCNamePair> ccNames;
     std::optional<uint8_t> defaultSwitch;
     std::set<std::string_view> unknownOpcodes;
     using RegionPtrVector = std::vector<Region*>;
-    std::vector<std::unique_ptr<Region>> regions;
+    // What the audio thread plays from a loaded file
+    struct Instrument {
+        std::vector<std::unique_ptr<Region>> regions;
+        std::array<RegionPtrVector, 128> noteActivationLists;
+        std::array<RegionPtrVector, 128> ccActivationLists;
+        RegionPtrVector pitchWheelActivationList;
+        RegionPtrVector aftertouchActivationList;
+        RegionPtrVector tempoActivationList;
+        CCValueArray ccState {}; // the set_cc values
+        LEAK_DETECTOR(Instrument);
+    };
+    // The instrument being parsed, then the last one loaded which the getters describe
+    std::unique_ptr<Instrument> loadingInstrument;
+    const Instrument* loadedInstrument { nullptr };
+    // The asynchronous loads hand their instrument over to the audio thread through this slot.
+    // It keeps the instruments it replaces until their voices stop, then hands them back
+    // to be destroyed on the loading thread.
+    std::atomic<Instrument*> pendingInstrument { nullptr };
+    std::unique_ptr<Instrument> instrument;
+    struct DrainingInstrument {
+        std::unique_ptr<Instrument> instrument;
+        uint64_t replacedAt; // the voices started before this play the instrument
+    };
+    std::vector<DrainingInstrument> drainingInstruments;
+    moodycamel::ReaderWriterQueue<Instrument*> retiredInstruments { config::maxDrainingInstruments };
+    void swapInstrument() noexcept;
+    void reclaimInstruments() noexcept;
+
+    std::mutex loadMutex; // one load at a time, as the parsing state is shared
+    std::mutex requestMutex;
+    std::condition_variable loadRequested;
+    std::filesystem::path requestedFile;
+    bool quitLoadingThread { false };
+    std::atomic<LoadingStatus> loadingStatus { LoadingStatus::Idle };
+    std::thread loadingThread;
+    void loadRequestedFiles() noexcept;
+
     std::vector<std::unique_ptr<Voice>> voices;
-    std::array<RegionPtrVector, 128> noteActivationLists;
-    std::array<RegionPtrVector, 128> ccActivationLists;
+    // Every voice is either playing or waiting to be started, so that rendering
+    // and event handling only go through the playing ones
+    std::vector<Voice*> activeVoices;
+    std::vector<Voice*> freeVoices;
+    void resetVoices() noexcept;
+    CommandQueue commandQueue;
+    void processCommands(int numFrames) noexcept;
+    int numVoices { config::numVoices };
+    int numStolenVoices { 0 };
+    uint64_t numStartedVoices { 0 };
+    std::atomic<uint64_t> numDroppedNotes { 0 };
+    StealingPolicy stealingPolicy { StealingPolicy::Oldest };
+    int sampleQuality { config::defaultSampleQuality };
+    bool freewheeling { false };
+    void waitForStreams(size_t numFrames) noexcept;
+    RenderPool renderPool;
+    // The file pool streams into the voices so it has to be destroyed first
+    FilePool filePool;
 
     AudioBuffer<float> tempBuffer { 2, config::defaultSamplesPerBlock };
     int samplesPerBlock { config::defaultSamplesPerBlock };
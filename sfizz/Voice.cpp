@@ -40,15 +40,15 @@ void sfz::Voice::startVoice(Region* region, int delay, int channel, int number,
     triggerNumber = number;
     triggerChannel = channel;
     triggerValue = value;
+    stolen = false;
 
+    releasePreloadedData();
     this->region = region;
 
     ASSERT(delay >= 0);
     if (delay < 0)
         delay = 0;
 
-    DBG("Starting voice with " << region->sample);
-
     state = State::playing;
     speedRatio = static_cast<float>(region->sampleRate / this->sampleRate);
     pitchRatio = region->getBasePitchVariation(number, value);
@@ -58,7 +58,6 @@ void sfz::Voice::startVoice(Region* region, int delay, int channel, int number,
     if (region->volumeCC)
         volumedB += normalizeCC(ccState[region->volumeCC->first]) * region->volumeCC->second;
     volumeEnvelope.reset(db2mag(volumedB));
-    DBG("Base volume: " << baseVolumedB << " dB - with modifier: " << volumedB << " dB");
 
     baseGain = region->getBaseGain();
     baseGain *= region->getCrossfadeGain(ccState);
@@ -69,34 +68,61 @@ void sfz::Voice::startVoice(Region* region, int delay, int channel, int number,
     if (region->amplitudeCC)
         gain *= normalizeCC(ccState[region->amplitudeCC->first]) * normalizePercents(region->amplitudeCC->second);
     amplitudeEnvelope.reset(gain);
-    DBG("Base gain: " << baseGain << " - with modifier: " << gain);
 
     basePan = normalizeNegativePercents(region->pan);
     auto pan = basePan;
     if (region->panCC)
         pan += normalizeCC(ccState[region->panCC->first]) * normalizeNegativePercents(region->panCC->second);
     panEnvelope.reset(pan);
-    DBG("Base pan: " << basePan << " - with modifier: " << pan);
 
     basePosition = normalizeNegativePercents(region->position);
     auto position = basePosition;
     if (region->positionCC)
         position += normalizeCC(ccState[region->positionCC->first]) * normalizeNegativePercents(region->positionCC->second);
     positionEnvelope.reset(position);
-    DBG("Base position: " << basePosition << " - with modifier: " << position);
 
     baseWidth = normalizeNegativePercents(region->width);
     auto width = baseWidth;
     if (region->widthCC)
         width += normalizeCC(ccState[region->widthCC->first]) * normalizeNegativePercents(region->widthCC->second);
     widthEnvelope.reset(width);
-    DBG("Base width: " << baseWidth << " - with modifier: " << width);
 
     sourcePosition = region->getOffset();
-    floatPosition = static_cast<float>(sourcePosition);
-    initialDelay = delay + region->getDelay();
+    streaming = false;
+    endsAtStreamSwitch = false;
+    streamOrigin = 0;
+    oversampling = 1;
+    if (!region->isGenerator() && region->cachedSample->acquirePreload()) {
+        preloadedData = region->cachedSample->preloadedData.get();
+        oversampling = region->cachedSample->oversamplingFactor;
+    }
+    floatPosition = static_cast<float>(sourcePosition * oversampling);
+
+    // Without preloaded data, for instance when it was evicted, the whole sample is streamed
+    fileDataNeeded = !region->isGenerator() && (preloadedData == nullptr || !region->canUsePreloadedData());
+    interpolator = interpolatorModel(sampleQuality);
+    if (fileDataNeeded) {
+        // The voice switches to the stream before the interpolation reads past the preloaded
+        // data, and the stream starts early enough for the interpolation to never straddle both
+        const auto numPreloadedFrames = preloadedData != nullptr ? static_cast<uint32_t>(preloadedData->getNumFrames() / oversampling) : 0;
+        const auto history = static_cast<uint32_t>(interpolationHistory(interpolator));
+        const auto lookahead = static_cast<uint32_t>(interpolationLookahead(interpolator));
+        streamSwitch = numPreloadedFrames > lookahead ? numPreloadedFrames - lookahead : 0;
+        if (sourcePosition >= streamSwitch)
+            streamSwitch = sourcePosition;
+        streamStart = streamSwitch > history ? streamSwitch - history : 0;
+        if (sourcePosition == streamSwitch) {
+            floatPosition = static_cast<float>(sourcePosition - streamStart);
+            streaming = true;
+        }
+        const auto sampleEnd = region->trueSampleEnd();
+        streamLength = sampleEnd > streamStart ? sampleEnd - streamStart : 0;
+    }
+    // The oversampled preload is read with a larger step than the stream, for the same pitch
+    sincTable = getSincTable(interpolator, pitchRatio * speedRatio * (streaming ? 1 : oversampling));
+    initialDelay = delay + static_cast<uint32_t>(std::lround(region->getDelay() * sampleRate));
     baseFrequency = midiNoteFrequency(number) * pitchRatio;
-    prepareEGEnvelope(delay, value);
+    prepareEGEnvelope(initialDelay, value);
 }
 
 void sfz::Voice::prepareEGEnvelope(int delay, uint8_t velocity) noexcept
@@ -115,15 +141,6 @@ void sfz::Voice::prepareEGEnvelope(int delay, uint8_t velocity) noexcept
         normalizePercents(region->amplitudeEG.getStart(ccState, velocity)));
 }
 
-void sfz::Voice::setFileData(std::unique_ptr<AudioBuffer<float>> file, unsigned ticket) noexcept
-{
-    if (ticket != this->ticket)
-        return;
-
-    fileData = std::move(file);
-    dataReady.store(true);
-}
-
 bool sfz::Voice::isFree() const noexcept
 {
     return (region == nullptr);
@@ -211,6 +228,11 @@ void sfz::Voice::setSampleRate(float sampleRate) noexcept
     this->sampleRate = sampleRate;
 }
 
+void sfz::Voice::setSampleQuality(int quality) noexcept
+{
+    sampleQuality = quality;
+}
+
 void sfz::Voice::setSamplesPerBlock(int samplesPerBlock) noexcept
 {
     this->samplesPerBlock = samplesPerBlock;
@@ -232,10 +254,18 @@ void sfz::Voice::renderBlock(AudioSpan<float> buffer) noexcept
     if (state == State::idle || region == nullptr)
         return;
 
-    if (region->isGenerator())
-        fillWithGenerator(buffer);
-    else
-        fillWithData(buffer);
+    // The data starts at the trigger frame, while the envelopes cover the whole block
+    // since their events are timed from its start
+    const auto numDelayFrames = min(static_cast<size_t>(initialDelay), buffer.getNumFrames());
+    initialDelay -= static_cast<uint32_t>(numDelayFrames);
+    const auto dataSpan = buffer.subspan(numDelayFrames);
+    if (dataSpan.getNumFrames() > 0) {
+        if (region->isGenerator()) {
+            fillWithGenerator(dataSpan);
+        } else if (const auto sampleEnd = fillWithData(dataSpan)) {
+            release(static_cast<int>(numDelayFrames + *sampleEnd));
+        }
+    }
 
     if (region->isStereo())
         processStereo(buffer);
@@ -249,118 +279,122 @@ void sfz::Voice::renderBlock(AudioSpan<float> buffer) noexcept
 void sfz::Voice::processMono(AudioSpan<float> buffer) noexcept
 {
     const auto numSamples = buffer.getNumFrames();
-    auto leftBuffer = buffer.getSpan(0);
-    auto rightBuffer = buffer.getSpan(1);
-    
-    auto span1 = tempSpan1.first(numSamples);
-    auto span2 = tempSpan2.first(numSamples);
-
-    // Amplitude envelope
-    amplitudeEnvelope.getBlock(span1);
-    ::applyGain<float>(span1, leftBuffer);
+    auto gainSpan = tempSpan1.first(numSamples);
+    auto panSpan = tempSpan2.first(numSamples);
 
-    // AmpEG envelope
-    egEnvelope.getBlock(span1);
-    ::applyGain<float>(span1, leftBuffer);
-
-    // Volume envelope
-    volumeEnvelope.getBlock(span1);
-    ::applyGain<float>(span1, leftBuffer);
-
-    // Prepare for stereo output
-    ::copy<float>(leftBuffer, rightBuffer);
-
-    panEnvelope.getBlock(span1);
+    computeGain(gainSpan, panSpan);
     // We assume that the pan envelope is already normalized between -1 and 1
-    // Check bm_pan for your architecture to check if it's interesting to use the pan helper instead
-    ::fill<float>(span2, 1.0f);
-    ::add<float>(span1, span2);
-    ::applyGain<float>(piFour<float>, span2);
-    ::cos<float>(span2, span1);
-    ::sin<float>(span2, span2);
-    ::applyGain<float>(span1, leftBuffer);
-    ::applyGain<float>(span2, rightBuffer);
+    panEnvelope.getBlock(panSpan);
+    ::panMono<float>(gainSpan, panSpan, buffer.getSpan(0), buffer.getSpan(1));
 }
 
 void sfz::Voice::processStereo(AudioSpan<float> buffer) noexcept
 {
     const auto numSamples = buffer.getNumFrames();
-    auto span1 = tempSpan1.first(numSamples);
-    auto span2 = tempSpan2.first(numSamples);
-    auto span3 = tempSpan3.first(numSamples);
-    auto leftBuffer = buffer.getSpan(0);
-    auto rightBuffer = buffer.getSpan(1);
-
-    // Amplitude envelope
-    amplitudeEnvelope.getBlock(span1);
-    buffer.applyGain(span1);
-    
-    // AmpEG envelope
-    egEnvelope.getBlock(span1);
-    buffer.applyGain(span1);
-
-    // Volume envelope
-    volumeEnvelope.getBlock(span1);
-    buffer.applyGain(span1);
-
-    // Create mid/side from left/right in the output buffer
-    ::copy<float>(rightBuffer, span1);
-    ::add<float>(leftBuffer, rightBuffer);
-    ::subtract<float>(span1, leftBuffer);
-    ::applyGain<float>(sqrtTwoInv<float>, leftBuffer);
-    ::applyGain<float>(sqrtTwoInv<float>, rightBuffer);
-
-    // Apply the width process
-    widthEnvelope.getBlock(span1);
-    ::fill<float>(span2, 1.0f);
-    ::add<float>(span1, span2);
-    ::applyGain<float>(piFour<float>, span2);
-    ::cos<float>(span2, span1);
-    ::sin<float>(span2, span2);
-    ::applyGain<float>(span1, leftBuffer);
-    ::applyGain<float>(span2, rightBuffer);
-
-    // Apply a position to the "left" channel which is supposed to be our mid channel
+    auto gainSpan = tempSpan1.first(numSamples);
+    auto widthSpan = tempSpan2.first(numSamples);
+    auto positionSpan = tempSpan3.first(numSamples);
+
+    computeGain(gainSpan, widthSpan);
+    widthEnvelope.getBlock(widthSpan);
+    // The position applies to the mid channel
     // TODO: add panning here too?
-    positionEnvelope.getBlock(span1);
-    ::fill<float>(span2, 1.0f);
-    ::add<float>(span1, span2);
-    ::applyGain<float>(piFour<float>, span2);
-    ::cos<float>(span2, span1);
-    ::sin<float>(span2, span2);
-    ::copy<float>(leftBuffer, span3);
-    ::copy<float>(rightBuffer, leftBuffer);
-    ::multiplyAdd<float>(span1, span3, leftBuffer);
-    ::multiplyAdd<float>(span2, span3, rightBuffer);
-    ::applyGain<float>(sqrtTwoInv<float>, leftBuffer);
-    ::applyGain<float>(sqrtTwoInv<float>, rightBuffer);
-}
-
-void sfz::Voice::fillWithData(AudioSpan<float> buffer) noexcept
-{
-    auto source { [&]() {
-        if (region->canUsePreloadedData() || !dataReady)
-            return AudioSpan<const float>(*region->preloadedData);
-        else
-            return AudioSpan<const float>(*fileData);
-    }() };
+    positionEnvelope.getBlock(positionSpan);
+    ::widthPosition<float>(gainSpan, widthSpan, positionSpan, buffer.getSpan(0), buffer.getSpan(1));
+}
+
+void sfz::Voice::computeGain(absl::Span<float> gain, absl::Span<float> temp) noexcept
+{
+    amplitudeEnvelope.getBlock(gain);
+    egEnvelope.getBlock(temp);
+    ::applyGain<float>(temp, gain);
+    volumeEnvelope.getBlock(temp);
+    ::applyGain<float>(temp, gain);
+}
+
+std::optional<size_t> sfz::Voice::fillWithData(AudioSpan<float> buffer) noexcept
+{
+    if (!fileDataNeeded)
+        return fillWithPreloadedData(buffer);
+
+    size_t numPreloadedFrames { 0 };
+    if (!streaming) {
+        // Play from the preloaded data until we reach the switch to the stream
+        const auto jump = pitchRatio * speedRatio * oversampling;
+        const auto switchPosition = static_cast<float>(streamSwitch * oversampling);
+        const auto framesToStream = static_cast<int>(std::ceil((switchPosition - floatPosition) / jump)) - 1;
+        numPreloadedFrames = min(static_cast<size_t>(std::max(framesToStream, 0)), buffer.getNumFrames());
+        while (numPreloadedFrames < buffer.getNumFrames() && floatPosition + (numPreloadedFrames + 1) * jump < switchPosition)
+            numPreloadedFrames++;
+
+        const auto startPosition = floatPosition;
+        if (numPreloadedFrames > 0) {
+            auto indices = indexSpan.first(numPreloadedFrames);
+            auto jumps = tempSpan1.first(numPreloadedFrames);
+            auto leftCoeffs = tempSpan1.first(numPreloadedFrames);
+            auto rightCoeffs = tempSpan2.first(numPreloadedFrames);
+
+            ::fill<float>(jumps, jump);
+            floatPosition = ::saturatingSFZIndex<float, false>(
+                jumps,
+                leftCoeffs,
+                rightCoeffs,
+                indices,
+                floatPosition,
+                switchPosition);
+
+            fillInterpolated(AudioSpan<const float>(*preloadedData), buffer.first(numPreloadedFrames));
+        }
+
+        if (endsAtStreamSwitch && numPreloadedFrames > 0) {
+            // Fades out linearly, reaching 0 at the switch since there is no stream to switch to
+            const auto fadeLength = jump * config::fastReleaseDuration * sampleRate;
+            auto fade = tempSpan1.first(numPreloadedFrames);
+            ::linearRamp<float>(fade, (switchPosition - startPosition) / fadeLength, -jump / fadeLength);
+            for (auto& gain : fade)
+                gain = std::clamp(gain, 0.0f, 1.0f);
+            for (int channelIndex = 0; channelIndex < static_cast<int>(buffer.getNumChannels()); ++channelIndex)
+                ::applyGain<float>(fade, buffer.getSpan(channelIndex).first(numPreloadedFrames));
+        }
+
+        if (numPreloadedFrames == buffer.getNumFrames())
+            return {};
 
+        if (endsAtStreamSwitch)
+            return numPreloadedFrames;
+
+        streaming = true;
+        floatPosition = floatPosition / oversampling - static_cast<float>(streamStart);
+        sincTable = getSincTable(interpolator, pitchRatio * speedRatio);
+    }
+
+    const auto numStreamedFrames = fillWithStream(buffer.subspan(numPreloadedFrames));
+    if (numPreloadedFrames + numStreamedFrames < buffer.getNumFrames())
+        return numPreloadedFrames + numStreamedFrames;
+
+    return {};
+}
+
+std::optional<size_t> sfz::Voice::fillWithPreloadedData(AudioSpan<float> buffer) noexcept
+{
+    auto source = AudioSpan<const float>(*preloadedData);
     auto indices = indexSpan.first(buffer.getNumFrames());
     auto jumps = tempSpan1.first(buffer.getNumFrames());
     auto leftCoeffs = tempSpan1.first(buffer.getNumFrames());
     auto rightCoeffs = tempSpan2.first(buffer.getNumFrames());
+    const auto numSampleFrames = source.getNumFrames() / oversampling;
 
-    ::fill<float>(jumps, pitchRatio * speedRatio);
+    ::fill<float>(jumps, pitchRatio * speedRatio * oversampling);
 
-    if (region->shouldLoop() && region->trueSampleEnd() <= source.getNumFrames()) {
+    if (region->shouldLoop() && region->trueSampleEnd() <= numSampleFrames) {
         floatPosition = ::loopingSFZIndex<float, false>(
             jumps,
             leftCoeffs,
             rightCoeffs,
             indices,
             floatPosition,
-            region->trueSampleEnd() - 1,
-            region->loopRange.getStart());
+            (region->trueSampleEnd() - 1) * oversampling,
+            region->loopRange.getStart() * oversampling);
     } else {
         floatPosition = ::saturatingSFZIndex<float, false>(
             jumps,
@@ -368,38 +402,133 @@ void sfz::Voice::fillWithData(AudioSpan<float> buffer) noexcept
             rightCoeffs,
             indices,
             floatPosition,
-            source.getNumFrames() - 1);
+            (numSampleFrames - 1) * oversampling);
     }
 
-    auto ind = indices.data();
-    auto leftCoeff = leftCoeffs.data();
-    auto rightCoeff = rightCoeffs.data();
-    auto left = buffer.getChannel(0);
-    if (source.getNumChannels() == 1) {
-        while (ind < indices.end()) {
-            *left = source.getChannel(0)[*ind] * (*leftCoeff) + source.getChannel(0)[*ind + 1] * (*rightCoeff);
-            left++;
-            ind++;
-            leftCoeff++;
-            rightCoeff++;
-        }
-    } else {
-        auto right = buffer.getChannel(1);
-        while (ind < indices.end()) {
-            *left = source.getChannel(0)[*ind] * (*leftCoeff) + source.getChannel(0)[*ind + 1] * (*rightCoeff);
-            *right = source.getChannel(1)[*ind] * (*leftCoeff) + source.getChannel(1)[*ind + 1] * (*rightCoeff);
-            left++;
-            right++;
-            ind++;
-            leftCoeff++;
-            rightCoeff++;
-        }
+    fillInterpolated(source, buffer);
+
+    if (!region->shouldLoop() && (floatPosition + 1.01f * oversampling) > source.getNumFrames())
+        return static_cast<size_t>(std::distance(indices.begin(), absl::c_find(indices, static_cast<int>((region->trueSampleEnd() - 1) * oversampling))));
+
+    return {};
+}
+
+bool sfz::Voice::isStreamReady(size_t numFrames) const noexcept
+{
+    if (!fileDataNeeded || state == State::idle || endsAtStreamSwitch)
+        return true;
+
+    const auto jump = pitchRatio * speedRatio;
+    if (!streaming && floatPosition + numFrames * jump * oversampling < streamSwitch * oversampling)
+        return true;
+
+    // Mirrors the reads of fillWithStream, in stream frames
+    const double position = streaming
+        ? streamOrigin + static_cast<double>(floatPosition)
+        : std::max(0.0, static_cast<double>(floatPosition) / oversampling - streamStart);
+    auto neededFrames = static_cast<uint32_t>(std::ceil(position + numFrames * jump)) + interpolationLookahead(interpolator) + 1;
+    if (!region->shouldLoop())
+        neededFrames = min(neededFrames, streamLength);
+
+    // The loader cannot write further ahead than the ring holds
+    const auto consumed = streaming ? static_cast<uint32_t>(position) : 0;
+    neededFrames = min(neededFrames, consumed + streamingBuffer->getCapacity() - streamingBuffer->getNumHistoryFrames());
+    return streamingBuffer->availableFrames(ticket) >= neededFrames;
+}
+
+size_t sfz::Voice::fillWithStream(AudioSpan<float> buffer) noexcept
+{
+    // Returns the number of frames rendered before the end of the sample.
+    // All positions are taken relative to streamOrigin, which is the stream frame
+    // at the start of the current lap around the streaming buffer. The interpolation
+    // reads up to lookahead frames past each position, so the voice ends that many
+    // frames before the end of the sample.
+    const auto jump = pitchRatio * speedRatio;
+    const auto lookahead = interpolationLookahead(interpolator);
+    const auto numAvailableFrames = streamingBuffer->availableFrames(ticket) - streamOrigin;
+    const auto lastPosition = floatPosition + buffer.getNumFrames() * jump;
+
+    auto numFrames = buffer.getNumFrames();
+    if (!region->shouldLoop() && lastPosition + lookahead >= streamLength - streamOrigin) {
+        if (numAvailableFrames < streamLength - streamOrigin)
+            return buffer.getNumFrames(); // Underrun: the loader did not keep up
+        const auto framesToEnd = static_cast<int>(std::ceil((streamLength - streamOrigin - lookahead - floatPosition) / jump)) - 1;
+        numFrames = min(static_cast<size_t>(std::max(framesToEnd, 0)), numFrames);
+    } else if (lastPosition + lookahead >= numAvailableFrames) {
+        return buffer.getNumFrames(); // Underrun: the loader did not keep up
     }
 
-    if (!region->shouldLoop() && (floatPosition + 1.01) > source.getNumFrames()) {
-        DBG("Releasing " << region->sample);
-        auto last = std::distance(indices.begin(), absl::c_find(indices, region->trueSampleEnd() - 1));
-        release(last);
+    if (numFrames > 0) {
+        auto indices = indexSpan.first(numFrames);
+        auto jumps = tempSpan1.first(numFrames);
+        auto leftCoeffs = tempSpan1.first(numFrames);
+        auto rightCoeffs = tempSpan2.first(numFrames);
+        const auto capacity = streamingBuffer->getCapacity();
+
+        ::fill<float>(jumps, jump);
+        const auto newPosition = ::loopingSFZIndex<float, false>(
+            jumps,
+            leftCoeffs,
+            rightCoeffs,
+            indices,
+            floatPosition,
+            static_cast<float>(capacity),
+            0.0f);
+
+        if (newPosition < floatPosition)
+            streamOrigin += capacity;
+        floatPosition = newPosition;
+
+        // The padded spans start with the history frames
+        const auto history = static_cast<int>(streamingBuffer->getNumHistoryFrames());
+        for (auto& index : indices)
+            index += history;
+
+        if (region->isStereo())
+            fillInterpolated({ streamingBuffer->getPaddedSpan(0), streamingBuffer->getPaddedSpan(1) }, buffer.first(numFrames));
+        else
+            fillInterpolated({ streamingBuffer->getPaddedSpan(0) }, buffer.first(numFrames));
+
+        streamingBuffer->consume(streamOrigin + static_cast<uint32_t>(floatPosition));
+    }
+
+    return numFrames;
+}
+
+void sfz::Voice::fillInterpolated(AudioSpan<const float> source, AudioSpan<float> buffer) noexcept
+{
+    const auto numFrames = buffer.getNumFrames();
+    if (numFrames == 0)
+        return;
+
+    auto indices = indexSpan.first(numFrames);
+    auto leftCoeffs = tempSpan1.first(numFrames);
+    auto rightCoeffs = tempSpan2.first(numFrames);
+
+    // Without pitch change and on whole frames, the interpolation is a straight copy
+    const bool copyFrames = pitchRatio * speedRatio == 1.0f
+        && rightCoeffs.front() == 0.0f && rightCoeffs.back() == 0.0f
+        && indices.back() - indices.front() == static_cast<int>(numFrames) - 1;
+
+    for (int i = 0; i < source.getNumChannels(); ++i) {
+        const auto input = source.getConstSpan(i);
+        const auto output = buffer.getSpan(i);
+        if (copyFrames) {
+            ::copy<float>(input.subspan(indices.front(), numFrames), output);
+            continue;
+        }
+
+        switch (interpolator) {
+        case InterpolatorModel::Linear:
+            ::interpolateLinear<float>(indices, leftCoeffs, rightCoeffs, input, output);
+            break;
+        case InterpolatorModel::Hermite:
+            ::interpolateHermite<float>(indices, rightCoeffs, input, output);
+            break;
+        default:
+            ::interpolateSinc<float>(indices, rightCoeffs, input, output, sincTable->getCoefficients(), sincTable->getNumTaps());
+            break;
+        }
     }
 }
 
@@ -409,9 +538,12 @@ void sfz::Voice::fillWithGenerator(AudioSpan<float> buffer) noexcept
         return;
 
     float step = baseFrequency * twoPi<float> / sampleRate;
-    phase = ::linearRamp<float>(tempSpan1, phase, step);
+    auto phases = tempSpan1.first(buffer.getNumFrames());
+    phase = ::linearRamp<float>(phases, phase, step);
+    // Keep the phase small, where the vectorized sine stays accurate
+    phase = std::fmod(phase, twoPi<float>);
 
-    ::sin<float>(tempSpan1.first(buffer.getNumFrames()), buffer.getSpan(0));
+    ::sin<float>(phases, buffer.getSpan(0));
     ::copy<float>(buffer.getSpan(0), buffer.getSpan(1));
 
     sourcePosition += buffer.getNumFrames();
@@ -420,7 +552,6 @@ void sfz::Voice::fillWithGenerator(AudioSpan<float> buffer) noexcept
 bool sfz::Voice::checkOffGroup(int delay, uint32_t group) noexcept
 {
     if (region != nullptr && triggerType == TriggerType::NoteOn && region->offBy && *region->offBy == group) {
-        DBG("Off group of sample " << region->sample);
         release(delay);
         return true;
     }
@@ -448,26 +579,49 @@ sfz::Voice::TriggerType sfz::Voice::getTriggerType() const noexcept
     return triggerType;
 }
 
+void sfz::Voice::steal(int delay) noexcept
+{
+    ASSERT(delay >= 0);
+    stolen = true;
+    state = State::release;
+    egEnvelope.startFastRelease(delay, static_cast<int>(config::fastReleaseDuration * sampleRate));
+}
+
 void sfz::Voice::reset() noexcept
 {
-    dataReady.store(false);
+    if (streamingBuffer != nullptr)
+        streamingBuffer->stop();
+    streaming = false;
+    endsAtStreamSwitch = false;
     state = State::idle;
-    if (region != nullptr) {
-        DBG("Reset voice with sample " << region->sample);
-    }
     sourcePosition = 0;
     floatPosition = 0.0f;
+    releasePreloadedData();
+    fileDataNeeded = false;
     region = nullptr;
     noteIsOff = false;
 }
 
-void sfz::Voice::garbageCollect() noexcept
+void sfz::Voice::releasePreloadedData() noexcept
 {
-    if (state == State::idle && region == nullptr)
-        fileData.reset();
+    if (preloadedData != nullptr) {
+        region->cachedSample->releasePreload();
+        preloadedData = nullptr;
+    }
 }
 
-void sfz::Voice::expectFileData(unsigned ticket)
+void sfz::Voice::expectFileData(StreamingBuffer* buffer, unsigned ticket) noexcept
 {
+    ASSERT(buffer != nullptr);
+    streamingBuffer = buffer;
     this->ticket = ticket;
+    streamingBuffer->start(ticket);
+}
+
+void sfz::Voice::skipFileData() noexcept
+{
+    if (preloadedData == nullptr || streaming)
+        reset();
+    else
+        endsAtStreamSwitch = true;
 }
\ No newline at end of file
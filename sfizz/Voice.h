@@ -28,9 +28,12 @@
 #include "Region.h"
 #include "AudioBuffer.h"
 #include "AudioSpan.h"
+#include "Interpolators.h"
 #include "LeakDetector.h"
+#include "StreamingBuffer.h"
 #include <absl/types/span.h>
-#include <atomic>
+#include <optional>
+#include <utility>
 
 namespace sfz {
 class Voice {
@@ -44,17 +47,46 @@ public:
     };
     void setSampleRate(float sampleRate) noexcept;
     void setSamplesPerBlock(int samplesPerBlock) noexcept;
+    // Latched when the voice starts, see Synth::setSampleQuality
+    void setSampleQuality(int quality) noexcept;
     
     void startVoice(Region* region, int delay, int channel, int number, uint8_t value, TriggerType triggerType) noexcept;
 
-    void expectFileData(unsigned ticket);
-    void setFileData(std::unique_ptr<AudioBuffer<float>> file, unsigned ticket) noexcept;
+    /**
+     * Hands the voice the streaming buffer that the loader fills under this ticket. The
+     * voice keeps the buffer until takeStreamingBuffer; without one, call skipFileData.
+     */
+    void expectFileData(StreamingBuffer* buffer, unsigned ticket) noexcept;
+    /**
+     * For a voice that needs file data but got no streaming buffer: the voice plays its
+     * preloaded data and fades out over config::fastReleaseDuration before its end, or
+     * stops at once when it has nothing preloaded to play.
+     */
+    void skipFileData() noexcept;
+    StreamingBuffer* getStreamingBuffer() noexcept { return streamingBuffer; }
+    StreamingBuffer* takeStreamingBuffer() noexcept { return std::exchange(streamingBuffer, nullptr); }
+    uint32_t getStreamStart() const noexcept { return streamStart; }
+    bool needsFileData() const noexcept { return fileDataNeeded; }
+    bool hasPreloadedData() const noexcept { return preloadedData != nullptr; }
+    // Whether the stream already holds the frames the next block of this size reads
+    bool isStreamReady(size_t numFrames) const noexcept;
     void registerNoteOff(int delay, int channel, int noteNumber, uint8_t velocity) noexcept;
     void registerCC(int delay, int channel, int ccNumber, uint8_t ccValue) noexcept;
     void registerPitchWheel(int delay, int channel, int pitch) noexcept;
     void registerAftertouch(int delay, int channel, uint8_t aftertouch) noexcept;
     void registerTempo(int delay, float secondsPerQuarter) noexcept;
     bool checkOffGroup(int delay, uint32_t group) noexcept;
+    /**
+     * Fades the voice out over config::fastReleaseDuration so that its note can be dropped
+     * without clicking.
+     */
+    void steal(int delay) noexcept;
+    bool isStolen() const noexcept { return stolen; }
+    bool isReleased() const noexcept { return state == State::release; }
+    float getEnvelopeLevel() const noexcept { return egEnvelope.getCurrentValue(); }
+    // Orders the voices by age
+    void setStartOrder(uint64_t order) noexcept { startOrder = order; }
+    uint64_t getStartOrder() const noexcept { return startOrder; }
 
     void renderBlock(AudioSpan<float, 2> buffer) noexcept;
 
@@ -65,13 +97,18 @@ public:
     TriggerType getTriggerType() const noexcept;
 
     void reset() noexcept;
-    void garbageCollect() noexcept;
 private:
-    void fillWithData(AudioSpan<float> buffer) noexcept;
+    // Both return the frame where the sample ends within the buffer, if it does
+    std::optional<size_t> fillWithData(AudioSpan<float> buffer) noexcept;
+    std::optional<size_t> fillWithPreloadedData(AudioSpan<float> buffer) noexcept;
+    size_t fillWithStream(AudioSpan<float> buffer) noexcept;
+    void fillInterpolated(AudioSpan<const float> source, AudioSpan<float> buffer) noexcept;
     void fillWithGenerator(AudioSpan<float> buffer) noexcept;
     void prepareEGEnvelope(int delay, uint8_t velocity) noexcept;
     void processMono(AudioSpan<float> buffer) noexcept;
     void processStereo(AudioSpan<float> buffer) noexcept;
+    // Multiplies the amplitude, amplitude EG and volume envelopes into the gain span
+    void computeGain(absl::Span<float> gain, absl::Span<float> temp) noexcept;
     void release(int delay) noexcept;
     Region* region { nullptr };
 
@@ -82,6 +119,8 @@ private:
     };
     State state { State::idle };
     bool noteIsOff { false };
+    bool stolen { false };
+    uint64_t startOrder { 0 };
 
     TriggerType triggerType;
     int triggerNumber;
@@ -100,11 +139,32 @@ private:
 
     uint32_t sourcePosition { 0 };
     float floatPosition { 0.0f };
+    // Frames before the voice starts playing, counted from the start of the next block
     uint32_t initialDelay { 0 };
 
-    std::atomic<bool> dataReady { false };
-    std::unique_ptr<AudioBuffer<float>> fileData { nullptr };
-    unsigned ticket { 0 };
+    // Acquired from the region's sample for the whole duration of the voice
+    const AudioBuffer<float>* preloadedData { nullptr };
+    // Frames of the preloaded data per sample frame; floatPosition counts them while the voice reads it
+    int oversampling { 1 };
+    void releasePreloadedData() noexcept;
+    bool fileDataNeeded { false };
+
+    int sampleQuality { config::defaultSampleQuality };
+    InterpolatorModel interpolator { InterpolatorModel::Linear };
+    const SincTable* sincTable { nullptr };
+
+    // Past the preloaded data, floatPosition is relative to the streaming buffer.
+    // The stream starts early enough to hold the frames that the interpolation reads
+    // before streamSwitch, the position where the voice switches to it.
+    // The buffer comes from the FilePool only while the voice needs file data.
+    StreamingBuffer* streamingBuffer { nullptr };
+    bool streaming { false };
+    bool endsAtStreamSwitch { false }; // see skipFileData
+    uint32_t streamSwitch { 0 };
+    uint32_t streamStart { 0 };
+    uint32_t streamLength { 0 };
+    uint32_t streamOrigin { 0 };
+    unsigned ticket { StreamingBuffer::noTicket };
 
     Buffer<float> tempBuffer1;
     Buffer<float> tempBuffer2;
@@ -0,0 +1,210 @@
+/* AVX2 and FMA implementation of sin, cos, exp and log
+
+   This is a port of sse_mathfun.h to 8-float vectors, following the same
+   cephes-based algorithms. The functions carry a target attribute so that
+   this header can be included in a translation unit compiled for the
+   baseline instruction set, and only called after checking that the CPU
+   supports AVX2 and FMA.
+*/
+
+/* Copyright (C) 2007  Julien Pommier
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+
+  (this is the zlib license)
+*/
+
+#pragma once
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+# define AVX_MATHFUN_TARGET __attribute__((target("avx2,fma")))
+#else
+# define AVX_MATHFUN_TARGET
+#endif
+
+typedef __m256 v8sf;  // vector of 8 float (avx)
+typedef __m256i v8si; // vector of 8 int (avx2)
+
+/* natural logarithm computed for 8 simultaneous float
+   return NaN for x <= 0
+*/
+AVX_MATHFUN_TARGET static inline v8sf log256_ps(v8sf x) {
+  const v8sf one = _mm256_set1_ps(1.0f);
+
+  const v8sf invalid_mask = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OS);
+
+  /* cut off denormalized stuff */
+  x = _mm256_max_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x00800000)));
+
+  /* part 1: x = frexpf(x, &e); */
+  v8si emm0 = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+  /* keep only the fractional part */
+  x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+  x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+
+  emm0 = _mm256_sub_epi32(emm0, _mm256_set1_epi32(0x7f));
+  v8sf e = _mm256_add_ps(_mm256_cvtepi32_ps(emm0), one);
+
+  /* part2:
+     if( x < SQRTHF ) {
+       e -= 1;
+       x = x + x - 1.0;
+     } else { x = x - 1.0; }
+  */
+  const v8sf mask = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OS);
+  v8sf tmp = _mm256_and_ps(x, mask);
+  x = _mm256_sub_ps(x, one);
+  e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+  x = _mm256_add_ps(x, tmp);
+
+  const v8sf z = _mm256_mul_ps(x, x);
+
+  v8sf y = _mm256_set1_ps(7.0376836292E-2f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.1514610310E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.1676998740E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.2420140846E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.4249322787E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.6668057665E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(2.0000714765E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-2.4999993993E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(3.3333331174E-1f));
+  y = _mm256_mul_ps(y, x);
+  y = _mm256_mul_ps(y, z);
+
+  y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+  y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+
+  x = _mm256_add_ps(x, y);
+  x = _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), x);
+  x = _mm256_or_ps(x, invalid_mask); // negative arg will be NAN
+  return x;
+}
+
+AVX_MATHFUN_TARGET static inline v8sf exp256_ps(v8sf x) {
+  const v8sf one = _mm256_set1_ps(1.0f);
+
+  x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+  x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+
+  /* express exp(x) as exp(g + n*log(2)) */
+  v8sf fx = _mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+
+  x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(0.693359375f), x);
+  x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(-2.12194440e-4f), x);
+
+  const v8sf z = _mm256_mul_ps(x, x);
+
+  v8sf y = _mm256_set1_ps(1.9875691500E-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507E-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073E-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894E-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459E-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201E-1f));
+  y = _mm256_fmadd_ps(y, z, x);
+  y = _mm256_add_ps(y, one);
+
+  /* build 2^n */
+  v8si emm0 = _mm256_cvttps_epi32(fx);
+  emm0 = _mm256_add_epi32(emm0, _mm256_set1_epi32(0x7f));
+  emm0 = _mm256_slli_epi32(emm0, 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(emm0));
+}
+
+/* computes both the sine and the cosine of 8 floats, for the cost of one */
+AVX_MATHFUN_TARGET static inline void sincos256_ps(v8sf x, v8sf *s, v8sf *c) {
+  const v8sf signMask = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000));
+
+  /* extract the sign bit (upper one) and take the absolute value */
+  v8sf sign_bit_sin = _mm256_and_ps(x, signMask);
+  x = _mm256_andnot_ps(signMask, x);
+
+  /* scale by 4/Pi */
+  v8sf y = _mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f));
+
+  /* store the integer part of y in emm2 */
+  v8si emm2 = _mm256_cvttps_epi32(y);
+
+  /* j=(j+1) & (~1) (see the cephes sources) */
+  emm2 = _mm256_add_epi32(emm2, _mm256_set1_epi32(1));
+  emm2 = _mm256_and_si256(emm2, _mm256_set1_epi32(~1));
+  y = _mm256_cvtepi32_ps(emm2);
+
+  v8si emm4 = emm2;
+
+  /* get the swap sign flag for the sine */
+  v8si emm0 = _mm256_and_si256(emm2, _mm256_set1_epi32(4));
+  emm0 = _mm256_slli_epi32(emm0, 29);
+  const v8sf swap_sign_bit_sin = _mm256_castsi256_ps(emm0);
+
+  /* get the polynom selection mask for the sine */
+  emm2 = _mm256_and_si256(emm2, _mm256_set1_epi32(2));
+  emm2 = _mm256_cmpeq_epi32(emm2, _mm256_setzero_si256());
+  const v8sf poly_mask = _mm256_castsi256_ps(emm2);
+
+  /* The magic pass: "Extended precision modular arithmetic"
+     x = ((x - y * DP1) - y * DP2) - y * DP3; */
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-0.78515625f), x);
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-2.4187564849853515625e-4f), x);
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-3.77489497744594108e-8f), x);
+
+  /* get the sign flag for the cosine */
+  emm4 = _mm256_sub_epi32(emm4, _mm256_set1_epi32(2));
+  emm4 = _mm256_andnot_si256(emm4, _mm256_set1_epi32(4));
+  emm4 = _mm256_slli_epi32(emm4, 29);
+  const v8sf sign_bit_cos = _mm256_castsi256_ps(emm4);
+
+  sign_bit_sin = _mm256_xor_ps(sign_bit_sin, swap_sign_bit_sin);
+
+  /* Evaluate the first polynom  (0 <= x <= Pi/4) */
+  const v8sf z = _mm256_mul_ps(x, x);
+  y = _mm256_set1_ps(2.443315711809948E-005f);
+  y = _mm256_fmadd_ps(y, z, _mm256_set1_ps(-1.388731625493765E-003f));
+  y = _mm256_fmadd_ps(y, z, _mm256_set1_ps(4.166664568298827E-002f));
+  y = _mm256_mul_ps(y, z);
+  y = _mm256_mul_ps(y, z);
+  y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+  y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+  /* Evaluate the second polynom  (Pi/4 <= x <= 0) */
+  v8sf y2 = _mm256_set1_ps(-1.9515295891E-4f);
+  y2 = _mm256_fmadd_ps(y2, z, _mm256_set1_ps(8.3321608736E-3f));
+  y2 = _mm256_fmadd_ps(y2, z, _mm256_set1_ps(-1.6666654611E-1f));
+  y2 = _mm256_mul_ps(y2, z);
+  y2 = _mm256_fmadd_ps(y2, x, x);
+
+  /* select the correct result from the two polynoms */
+  const v8sf xsin = _mm256_blendv_ps(y, y2, poly_mask);
+  const v8sf xcos = _mm256_blendv_ps(y2, y, poly_mask);
+
+  /* update the sign */
+  *s = _mm256_xor_ps(xsin, sign_bit_sin);
+  *c = _mm256_xor_ps(xcos, sign_bit_cos);
+}
+
+AVX_MATHFUN_TARGET static inline v8sf sin256_ps(v8sf x) {
+  v8sf s, c;
+  sincos256_ps(x, &s, &c);
+  return s;
+}
+
+AVX_MATHFUN_TARGET static inline v8sf cos256_ps(v8sf x) {
+  v8sf s, c;
+  sincos256_ps(x, &s, &c);
+  return c;
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "CommandQueue.h"
+#include "catch2/catch.hpp"
+#include <array>
+#include <thread>
+#include <vector>
+
+TEST_CASE("[CommandQueue] Bounded capacity")
+{
+    sfz::CommandQueue queue { 4 };
+    sfz::SynthCommand command;
+    for (int i = 0; i < 4; ++i) {
+        command.number = i;
+        REQUIRE(queue.push(command));
+    }
+    REQUIRE(!queue.push(command));
+
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(queue.pop(command));
+        REQUIRE(command.number == i);
+    }
+    REQUIRE(!queue.pop(command));
+}
+
+TEST_CASE("[CommandQueue] Slots reused over several laps")
+{
+    sfz::CommandQueue queue { 3 };
+    sfz::SynthCommand command;
+    for (int lap = 0; lap < 5; ++lap) {
+        for (int i = 0; i < 2; ++i) {
+            command.number = 2 * lap + i;
+            REQUIRE(queue.push(command));
+        }
+        for (int i = 0; i < 2; ++i) {
+            REQUIRE(queue.pop(command));
+            REQUIRE(command.number == 2 * lap + i);
+        }
+    }
+    REQUIRE(!queue.pop(command));
+}
+
+TEST_CASE("[CommandQueue] Several senders")
+{
+    // Each sender's commands arrive whole and in order, interleaved with the others
+    constexpr int numSenders { 4 };
+    constexpr int numCommands { 10000 };
+    sfz::CommandQueue queue { 64 };
+
+    std::vector<std::thread> senders;
+    for (int sender = 0; sender < numSenders; ++sender) {
+        senders.emplace_back([&queue, sender]() {
+            sfz::SynthCommand command;
+            command.channel = sender;
+            for (int i = 0; i < numCommands; ++i) {
+                command.number = i;
+                while (!queue.push(command))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::array<int, numSenders> nextNumbers {};
+    int numReceived { 0 };
+    bool ordered { true };
+    sfz::SynthCommand command;
+    while (numReceived < numSenders * numCommands) {
+        if (!queue.pop(command)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered &= (command.number == nextNumbers[command.channel]++);
+        numReceived++;
+    }
+
+    for (auto& sender : senders)
+        sender.join();
+
+    REQUIRE(ordered);
+    REQUIRE(!queue.pop(command));
+}
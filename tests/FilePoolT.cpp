@@ -0,0 +1,149 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Synth.h"
+#include "catch2/catch.hpp"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+using namespace Catch::literals;
+using namespace std::chrono_literals;
+
+namespace {
+// channels.sfz holds a mono sample on key 60 and a stereo sample on key 61
+constexpr size_t monoPreloadSize { sfz::config::preloadSize * sizeof(float) };
+constexpr size_t stereoPreloadSize { 2 * sfz::config::preloadSize * sizeof(float) };
+
+template <class Condition>
+bool waitFor(Condition&& condition)
+{
+    for (int i = 0; i < 200 && !condition(); ++i)
+        std::this_thread::sleep_for(10ms);
+    return condition();
+}
+}
+
+TEST_CASE("[FilePool] No eviction without a budget")
+{
+    sfz::Synth synth;
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+    const auto statistics = synth.getFilePoolStatistics();
+    REQUIRE(statistics.preloadedBytes == monoPreloadSize + stereoPreloadSize);
+    REQUIRE(statistics.evictions == 0);
+}
+
+TEST_CASE("[FilePool] Least recently used preloads are evicted and reloaded on demand")
+{
+    sfz::Synth synth;
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+    synth.setPreloadMemoryBudget(stereoPreloadSize);
+    REQUIRE(synth.getFilePoolStatistics().evictions == 1);
+    REQUIRE(synth.getFilePoolStatistics().preloadedBytes == stereoPreloadSize);
+
+    synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getFilePoolStatistics().fallbacks == 1);
+    REQUIRE(waitFor([&]() { return synth.getFilePoolStatistics().reloads == 1; }));
+    // The reloaded mono sample is now the most recently used one
+    REQUIRE(waitFor([&]() { return synth.getFilePoolStatistics().evictions == 2; }));
+    REQUIRE(synth.getFilePoolStatistics().preloadedBytes == monoPreloadSize);
+}
+
+TEST_CASE("[FilePool] Preloads used by voices are not evicted")
+{
+    sfz::Synth synth;
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+    synth.noteOn(0, 1, 61, 127);
+    synth.setPreloadMemoryBudget(1);
+    const auto statistics = synth.getFilePoolStatistics();
+    REQUIRE(statistics.evictions == 1);
+    REQUIRE(statistics.preloadedBytes == stereoPreloadSize);
+    REQUIRE(statistics.fallbacks == 0);
+}
+
+TEST_CASE("[FilePool] Streaming latencies")
+{
+    sfz::Synth synth;
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+    REQUIRE(synth.getFilePoolStatistics().timeToData.count == 0);
+
+    synth.noteOn(0, 1, 61, 127);
+    REQUIRE(waitFor([&]() { return synth.getFilePoolStatistics().timeToData.count == 1; }));
+    const auto statistics = synth.getFilePoolStatistics();
+    REQUIRE(statistics.queueLatency.count == 1);
+    REQUIRE(statistics.readLatency.count == 1);
+    REQUIRE(statistics.queueLatency.max <= statistics.timeToData.max);
+    REQUIRE(statistics.readLatency.max <= statistics.timeToData.max);
+    REQUIRE(statistics.timeToData.p50 == statistics.timeToData.max);
+    REQUIRE(statistics.streamedSamples > 0);
+    REQUIRE(statistics.streamedSamples % 2 == 0);
+    REQUIRE(statistics.fallbacks == 0);
+}
+
+TEST_CASE("[FilePool] Streaming buffers follow the streaming voices")
+{
+    sfz::Synth synth;
+    synth.setNumVoices(sfz::config::maxVoices);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+    REQUIRE(waitFor([&]() { return synth.getFilePoolStatistics().streamingBuffers == sfz::config::numSpareStreamingBuffers; }));
+
+    synth.noteOn(0, 1, 61, 127);
+    REQUIRE(waitFor([&]() { return synth.getFilePoolStatistics().streamingBuffers == sfz::config::numSpareStreamingBuffers + 1; }));
+    REQUIRE(synth.getFilePoolStatistics().missingStreamingBuffers == 0);
+
+    // The buffer of the reset voice is spare again
+    synth.setNumVoices(sfz::config::maxVoices);
+    synth.noteOn(0, 1, 61, 127);
+    std::this_thread::sleep_for(50ms);
+    REQUIRE(synth.getFilePoolStatistics().streamingBuffers == sfz::config::numSpareStreamingBuffers + 1);
+}
+
+TEST_CASE("[FilePool] Oversampled preloads")
+{
+    sfz::Synth synth;
+    REQUIRE(synth.getOversamplingFactor() == 1);
+    synth.setOversamplingFactor(3);
+    REQUIRE(synth.getOversamplingFactor() == 2);
+    synth.setOversamplingFactor(16);
+    REQUIRE(synth.getOversamplingFactor() == 4);
+    synth.setOversamplingFactor(0);
+    REQUIRE(synth.getOversamplingFactor() == 1);
+
+    sfz::Synth referenceSynth;
+    referenceSynth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+    synth.setOversamplingFactor(2);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+    REQUIRE(synth.getFilePoolStatistics().preloadedBytes == 2 * (monoPreloadSize + stereoPreloadSize));
+
+    // The oversampled preload is a separate copy, which keeps the original frames every other frame
+    const auto& referenceSample = referenceSynth.getRegionView(1)->cachedSample;
+    const auto& oversampledSample = synth.getRegionView(1)->cachedSample;
+    REQUIRE(oversampledSample != referenceSample);
+    REQUIRE(oversampledSample->numPreloadedFrames == referenceSample->numPreloadedFrames);
+    const auto& reference = *referenceSample->preloadedData;
+    const auto& oversampled = *oversampledSample->preloadedData;
+    REQUIRE(oversampled.getNumFrames() == 2 * reference.getNumFrames());
+    for (int channel = 0; channel < 2; ++channel) {
+        for (size_t i = 0; i < reference.getNumFrames(); ++i)
+            REQUIRE(oversampled.channelReader(channel)[2 * i] == Approx(reference.channelReader(channel)[i]).margin(1e-6));
+    }
+}
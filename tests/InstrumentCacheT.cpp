@@ -0,0 +1,222 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Synth.h"
+#include "catch2/catch.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+using namespace Catch::literals;
+using namespace std::chrono_literals;
+
+namespace {
+// A small instrument with defines, an include, a control header and an unknown opcode,
+// copied to a temporary directory so that its files can be touched
+struct CachedInstrument {
+    CachedInstrument(const std::string& name)
+        : directory(std::filesystem::temp_directory_path() / ("sfizz_instrument_cache_" + name))
+        , cacheDirectory(directory / "cache")
+        , sfzFile(directory / "main.sfz")
+    {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        const auto testFiles = std::filesystem::current_path() / "tests/TestFiles";
+        std::filesystem::copy_file(testFiles / "mono_sample.wav", directory / "mono_sample.wav");
+        std::filesystem::copy_file(testFiles / "stereo_sample.wav", directory / "stereo_sample.wav");
+        std::ofstream(sfzFile) << "#define $KEY 60\n"
+                               << "<control> set_cc20=64\n"
+                               << "<global> ampeg_release=0.5\n"
+                               << "<group> lovel=10 hivel=100 unknown_opcode=3\n"
+                               << "<region> key=$KEY sample=mono_sample.wav\n"
+                               << "#include \"included.sfz\"\n";
+        std::ofstream(directory / "included.sfz") << "<region> key=61 sample=stereo_sample.wav amp_velcurve_064=0.5 loop_mode=loop_continuous\n";
+    }
+    ~CachedInstrument()
+    {
+        std::filesystem::remove_all(directory);
+    }
+    void touch(const std::filesystem::path& file) const
+    {
+        std::filesystem::last_write_time(file, std::filesystem::last_write_time(file) + 1h);
+    }
+    std::filesystem::path directory;
+    std::filesystem::path cacheDirectory;
+    std::filesystem::path sfzFile;
+};
+
+bool loadsFromCache(const CachedInstrument& instrument)
+{
+    sfz::Synth synth;
+    synth.setInstrumentCacheDirectory(instrument.cacheDirectory);
+    return synth.loadSfzFile(instrument.sfzFile) && synth.isLoadedFromCache();
+}
+
+std::vector<float> getPreload(const sfz::Region& region, int channel)
+{
+    const auto& preloadedData = *region.cachedSample->preloadedData;
+    return std::vector<float>(preloadedData.channelReader(channel), preloadedData.channelReaderEnd(channel));
+}
+}
+
+TEST_CASE("[InstrumentCache] Instruments load from the cache once it is written")
+{
+    CachedInstrument instrument { "load" };
+    sfz::Synth parsedSynth;
+    parsedSynth.setInstrumentCacheDirectory(instrument.cacheDirectory);
+    REQUIRE(parsedSynth.loadSfzFile(instrument.sfzFile));
+    REQUIRE(!parsedSynth.isLoadedFromCache());
+    REQUIRE(std::filesystem::exists(instrument.cacheDirectory / sfz::InstrumentCache::getCacheFileName(instrument.sfzFile)));
+
+    sfz::Synth cachedSynth;
+    cachedSynth.setInstrumentCacheDirectory(instrument.cacheDirectory);
+    REQUIRE(cachedSynth.loadSfzFile(instrument.sfzFile));
+    REQUIRE(cachedSynth.isLoadedFromCache());
+
+    REQUIRE(cachedSynth.getNumRegions() == 2);
+    REQUIRE(cachedSynth.getNumRegions() == parsedSynth.getNumRegions());
+    REQUIRE(cachedSynth.getNumGroups() == parsedSynth.getNumGroups());
+    REQUIRE(cachedSynth.getDefines() == parsedSynth.getDefines());
+    REQUIRE(cachedSynth.getIncludedFiles() == parsedSynth.getIncludedFiles());
+    REQUIRE(cachedSynth.getUnknownOpcodes() == parsedSynth.getUnknownOpcodes());
+    for (int i = 0; i < parsedSynth.getNumRegions(); ++i) {
+        const auto parsedRegion = parsedSynth.getRegionView(i);
+        const auto cachedRegion = cachedSynth.getRegionView(i);
+        REQUIRE(cachedRegion->sample == parsedRegion->sample);
+        REQUIRE(cachedRegion->keyRange == parsedRegion->keyRange);
+        REQUIRE(cachedRegion->velocityRange == parsedRegion->velocityRange);
+        REQUIRE(cachedRegion->sampleEnd == parsedRegion->sampleEnd);
+        REQUIRE(cachedRegion->loopRange == parsedRegion->loopRange);
+        REQUIRE(cachedRegion->loopMode == parsedRegion->loopMode);
+        REQUIRE(cachedRegion->velocityPoints == parsedRegion->velocityPoints);
+        REQUIRE(cachedRegion->amplitudeEG.release == parsedRegion->amplitudeEG.release);
+        REQUIRE(cachedRegion->sampleRate == parsedRegion->sampleRate);
+        REQUIRE(cachedRegion->isStereo() == parsedRegion->isStereo());
+    }
+}
+
+TEST_CASE("[InstrumentCache] Preloads are restored from the cache")
+{
+    CachedInstrument instrument { "preloads" };
+    std::vector<float> monoPreload;
+    std::vector<float> rightPreload;
+    {
+        sfz::Synth synth;
+        synth.setInstrumentCacheDirectory(instrument.cacheDirectory);
+        REQUIRE(synth.loadSfzFile(instrument.sfzFile));
+        monoPreload = getPreload(*synth.getRegionView(0), 0);
+        rightPreload = getPreload(*synth.getRegionView(1), 1);
+    }
+
+    // The samples are released with the first synth, so the preloads cannot come from the sample cache
+    sfz::Synth synth;
+    synth.setInstrumentCacheDirectory(instrument.cacheDirectory);
+    REQUIRE(synth.loadSfzFile(instrument.sfzFile));
+    REQUIRE(synth.isLoadedFromCache());
+    REQUIRE(getPreload(*synth.getRegionView(0), 0) == monoPreload);
+    REQUIRE(getPreload(*synth.getRegionView(1), 1) == rightPreload);
+}
+
+TEST_CASE("[InstrumentCache] Preloads can be left out of the cache")
+{
+    CachedInstrument instrument { "no_preloads" };
+    {
+        sfz::Synth synth;
+        synth.setInstrumentCacheDirectory(instrument.cacheDirectory);
+        REQUIRE(synth.loadSfzFile(instrument.sfzFile));
+    }
+    const auto cacheFile = instrument.cacheDirectory / sfz::InstrumentCache::getCacheFileName(instrument.sfzFile);
+    const auto sizeWithPreloads = std::filesystem::file_size(cacheFile);
+
+    std::filesystem::remove(cacheFile);
+    std::vector<float> monoPreload;
+    {
+        sfz::Synth synth;
+        synth.setInstrumentCacheDirectory(instrument.cacheDirectory, false);
+        REQUIRE(synth.loadSfzFile(instrument.sfzFile));
+        monoPreload = getPreload(*synth.getRegionView(0), 0);
+    }
+    REQUIRE(std::filesystem::file_size(cacheFile) < sizeWithPreloads);
+
+    sfz::Synth synth;
+    synth.setInstrumentCacheDirectory(instrument.cacheDirectory, false);
+    REQUIRE(synth.loadSfzFile(instrument.sfzFile));
+    REQUIRE(synth.isLoadedFromCache());
+    REQUIRE(getPreload(*synth.getRegionView(0), 0) == monoPreload);
+}
+
+TEST_CASE("[InstrumentCache] Changed files invalidate the cache")
+{
+    CachedInstrument instrument { "invalidation" };
+    REQUIRE(!loadsFromCache(instrument));
+    REQUIRE(loadsFromCache(instrument));
+
+    SECTION("The sfz file")
+    {
+        instrument.touch(instrument.sfzFile);
+    }
+    SECTION("An included file")
+    {
+        instrument.touch(instrument.directory / "included.sfz");
+    }
+    SECTION("A sample")
+    {
+        instrument.touch(instrument.directory / "stereo_sample.wav");
+    }
+
+    REQUIRE(!loadsFromCache(instrument));
+    // The cache was written again
+    REQUIRE(loadsFromCache(instrument));
+}
+
+TEST_CASE("[InstrumentCache] Malformed caches are rejected")
+{
+    CachedInstrument instrument { "malformed" };
+    REQUIRE(!loadsFromCache(instrument));
+    const auto cacheFile = instrument.cacheDirectory / sfz::InstrumentCache::getCacheFileName(instrument.sfzFile);
+    const auto cacheSize = std::filesystem::file_size(cacheFile);
+
+    sfz::InstrumentCache cache;
+    REQUIRE(cache.open(cacheFile, instrument.sfzFile));
+    REQUIRE(cache.getHeaders().size() == 5);
+    REQUIRE(cache.getSamples().size() == 2);
+    cache.close();
+
+    SECTION("Built for another file")
+    {
+        REQUIRE(!cache.open(cacheFile, instrument.directory / "included.sfz"));
+        REQUIRE(!cache.isOpen());
+    }
+    SECTION("Truncated")
+    {
+        std::filesystem::resize_file(cacheFile, cacheSize - 1);
+        REQUIRE(!cache.open(cacheFile, instrument.sfzFile));
+        REQUIRE(!loadsFromCache(instrument));
+    }
+    SECTION("Garbage")
+    {
+        std::ofstream(cacheFile, std::ios::trunc) << "<region> sample=mono_sample.wav";
+        REQUIRE(!cache.open(cacheFile, instrument.sfzFile));
+        REQUIRE(!loadsFromCache(instrument));
+    }
+}
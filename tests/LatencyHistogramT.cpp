@@ -0,0 +1,98 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "LatencyHistogram.h"
+#include "catch2/catch.hpp"
+#include <chrono>
+#include <thread>
+#include <vector>
+using namespace std::chrono_literals;
+
+TEST_CASE("[LatencyHistogram] Empty histogram")
+{
+    sfz::LatencyHistogram histogram;
+    REQUIRE(histogram.getCount() == 0);
+    REQUIRE(histogram.getMax() == 0us);
+    REQUIRE(histogram.getPercentile(50.0) == 0us);
+}
+
+TEST_CASE("[LatencyHistogram] Small latencies are exact")
+{
+    sfz::LatencyHistogram histogram;
+    for (int i = 1; i <= 10; ++i)
+        histogram.record(std::chrono::microseconds(i));
+    REQUIRE(histogram.getCount() == 10);
+    REQUIRE(histogram.getPercentile(50.0) == 5us);
+    REQUIRE(histogram.getPercentile(100.0) == 10us);
+    REQUIRE(histogram.getMax() == 10us);
+}
+
+TEST_CASE("[LatencyHistogram] Percentiles")
+{
+    sfz::LatencyHistogram histogram;
+    for (int i = 1; i <= 10000; ++i)
+        histogram.record(std::chrono::microseconds(i));
+    REQUIRE(histogram.getCount() == 10000);
+    REQUIRE(histogram.getMax() == 10000us);
+
+    // The percentiles are the upper bounds of their buckets
+    const auto p50 = histogram.getPercentile(50.0).count();
+    REQUIRE(p50 >= 5000);
+    REQUIRE(p50 <= 5000 * 1.125);
+    const auto p99 = histogram.getPercentile(99.0).count();
+    REQUIRE(p99 >= 9900);
+    REQUIRE(p99 <= 10000);
+    REQUIRE(histogram.getPercentile(100.0) == 10000us);
+
+    histogram.clear();
+    REQUIRE(histogram.getCount() == 0);
+    REQUIRE(histogram.getPercentile(99.0) == 0us);
+}
+
+TEST_CASE("[LatencyHistogram] Out of range latencies")
+{
+    sfz::LatencyHistogram histogram;
+    histogram.record(std::chrono::microseconds(-5));
+    histogram.record(std::chrono::hours(24));
+    REQUIRE(histogram.getCount() == 2);
+    REQUIRE(histogram.getPercentile(50.0) == 0us);
+    REQUIRE(histogram.getMax() == std::chrono::hours(24));
+    REQUIRE(histogram.getPercentile(100.0) <= std::chrono::hours(24));
+}
+
+TEST_CASE("[LatencyHistogram] Concurrent recording")
+{
+    sfz::LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t]() {
+            for (int i = 0; i < 10000; ++i)
+                histogram.record(std::chrono::microseconds(t * 10000 + i));
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    REQUIRE(histogram.getCount() == 40000);
+    REQUIRE(histogram.getMax() == 39999us);
+}
@@ -109,6 +109,18 @@ TEST_CASE("[LinearEnvelope] 3 events, overlapping")
     REQUIRE(output == expected);
 }
 
+TEST_CASE("[LinearEnvelope] Simultaneous events keep their order")
+{
+    sfz::LinearEnvelope<float> envelope;
+    envelope.registerEvent(6, 3.0);
+    envelope.registerEvent(2, 1.0);
+    envelope.registerEvent(6, 2.0);
+    std::array<float, 8> output;
+    std::array<float, 8> expected { 0.5, 1, 1.5, 2.0, 2.5, 3.0, 2.0, 2.0 };
+    envelope.getBlock(absl::MakeSpan(output));
+    REQUIRE(output == expected);
+}
+
 TEST_CASE("[LinearEnvelope] 3 events, out of block")
 {
     sfz::LinearEnvelope<float> envelope;
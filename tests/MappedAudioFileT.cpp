@@ -0,0 +1,95 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "MappedAudioFile.h"
+#include "AudioBuffer.h"
+#include "AudioSpan.h"
+#include "catch2/catch.hpp"
+#include <filesystem>
+#include <sndfile.hh>
+using namespace Catch::literals;
+
+namespace {
+// Reads the whole file deinterleaved through libsndfile, as the reference
+AudioBuffer<float> readWithSndfile(const std::filesystem::path& path)
+{
+    SndfileHandle sndFile(reinterpret_cast<const char*>(path.c_str()));
+    const auto numChannels = sndFile.channels();
+    const auto numFrames = static_cast<int>(sndFile.frames());
+    AudioBuffer<float> interleaved { 1, numChannels * numFrames };
+    sndFile.readf(interleaved.channelWriter(0), numFrames);
+
+    AudioBuffer<float> output { numChannels, numFrames };
+    for (int frame = 0; frame < numFrames; ++frame) {
+        for (int channelIndex = 0; channelIndex < numChannels; ++channelIndex)
+            output.getSample(channelIndex, frame) = interleaved.getSample(0, frame * numChannels + channelIndex);
+    }
+    return output;
+}
+
+void compareWithSndfile(const std::filesystem::path& path)
+{
+    sfz::MappedAudioFile mappedFile;
+    REQUIRE(mappedFile.open(path));
+    auto reference = readWithSndfile(path);
+    REQUIRE(mappedFile.channels() == reference.getNumChannels());
+    REQUIRE(mappedFile.frames() == reference.getNumFrames());
+
+    // Read from the middle to check the offsets too
+    const uint32_t startFrame { 1000 };
+    AudioBuffer<float> output { mappedFile.channels(), 2048 };
+    REQUIRE(mappedFile.read(startFrame, AudioSpan<float>(output)) == 2048);
+    for (int channelIndex = 0; channelIndex < mappedFile.channels(); ++channelIndex) {
+        for (size_t frame = 0; frame < output.getNumFrames(); ++frame)
+            REQUIRE(output.getSample(channelIndex, frame) == reference.getSample(channelIndex, startFrame + frame));
+    }
+}
+}
+
+TEST_CASE("[MappedAudioFile] 16 bit mono file")
+{
+    compareWithSndfile(std::filesystem::current_path() / "tests/TestFiles/mono_sample.wav");
+}
+
+TEST_CASE("[MappedAudioFile] 24 bit stereo file")
+{
+    compareWithSndfile(std::filesystem::current_path() / "tests/TestFiles/stereo_sample.wav");
+}
+
+TEST_CASE("[MappedAudioFile] Reads stop at the end of the file")
+{
+    sfz::MappedAudioFile mappedFile;
+    REQUIRE(mappedFile.open(std::filesystem::current_path() / "tests/TestFiles/kick.wav"));
+    REQUIRE(mappedFile.sampleRate() == 44100.0);
+    AudioBuffer<float> output { 1, 100 };
+    REQUIRE(mappedFile.read(mappedFile.frames() - 10, AudioSpan<float>(output)) == 10);
+    REQUIRE(mappedFile.read(mappedFile.frames(), AudioSpan<float>(output)) == 0);
+}
+
+TEST_CASE("[MappedAudioFile] Non-WAV files are rejected")
+{
+    sfz::MappedAudioFile mappedFile;
+    REQUIRE(!mappedFile.open(std::filesystem::current_path() / "tests/TestFiles/basic_hierarchy.sfz"));
+    REQUIRE(!mappedFile.isOpen());
+    REQUIRE(!mappedFile.open(std::filesystem::current_path() / "tests/TestFiles/nonexistent.wav"));
+}
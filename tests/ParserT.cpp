@@ -0,0 +1,178 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Parser.h"
+#include "catch2/catch.hpp"
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace Catch::literals;
+
+namespace {
+// Collects the parser output as owned strings so that two runs can be compared
+class RecordingParser : public sfz::Parser {
+public:
+    using Members = std::vector<std::pair<std::string, std::string>>;
+    std::vector<std::pair<std::string, Members>> headers;
+protected:
+    void callback(std::string_view header, const std::vector<sfz::Opcode>& members) final
+    {
+        Members recordedMembers;
+        for (auto& member : members) {
+            auto opcode = std::string(member.opcode);
+            if (member.parameter)
+                opcode += std::to_string(*member.parameter);
+            recordedMembers.emplace_back(std::move(opcode), std::string(member.value));
+        }
+        headers.emplace_back(std::string(header), std::move(recordedMembers));
+    }
+};
+
+// Reads all the members of a string with both the lexer and the regex
+void compareMembers(std::string_view line)
+{
+    INFO("Members: " << line);
+    std::vector<std::pair<std::string_view, std::string_view>> lexed;
+    std::string_view members { line };
+    std::string_view opcode;
+    std::string_view value;
+    while (sfz::Lexer::readMember(members, opcode, value))
+        lexed.emplace_back(opcode, value);
+
+    std::vector<std::pair<std::string_view, std::string_view>> matched;
+    using svregex_iterator = std::regex_iterator<std::string_view::const_iterator>;
+    for (auto it = svregex_iterator(line.cbegin(), line.cend(), sfz::Regexes::members); it != svregex_iterator(); ++it) {
+        const auto& match = *it;
+        matched.emplace_back(std::string_view(&*match[1].first, match[1].length()), std::string_view(&*match[2].first, match[2].length()));
+    }
+    REQUIRE(lexed == matched);
+}
+
+void compareInclude(const std::string& line)
+{
+    INFO("Line: " << line);
+    std::smatch includeMatch;
+    const auto found = std::regex_search(line, includeMatch, sfz::Regexes::includes);
+    const auto include = sfz::Lexer::readInclude(line);
+    REQUIRE(found == include.has_value());
+    if (found)
+        REQUIRE(includeMatch[1] == std::string(*include));
+}
+
+void compareDefine(const std::string& line)
+{
+    INFO("Line: " << line);
+    std::smatch defineMatch;
+    const auto found = std::regex_search(line, defineMatch, sfz::Regexes::defines);
+    const auto define = sfz::Lexer::readDefine(line);
+    REQUIRE(found == define.has_value());
+    if (found) {
+        REQUIRE(defineMatch[1] == std::string(define->first));
+        REQUIRE(defineMatch[2] == std::string(define->second));
+    }
+}
+}
+
+TEST_CASE("[Lexer] #include")
+{
+    compareInclude("#include \"file.sfz\"");
+    compareInclude("#include \"../Programs/file.sfz\"");
+    compareInclude("#include \"..\\Programs\\file.sfz\"");
+    compareInclude("#include \"file$1.sfz\"");
+    compareInclude("#include \"rubbishCharactersAfter.sfz\" blabldaljf///df");
+    compareInclude("#include \"lazyMatching.sfz\" b\"");
+    compareInclude("#include\"noSpace.sfz\"");
+    compareInclude("#include noQuotes.sfz");
+    compareInclude("#include \"unterminated.sfz");
+    compareInclude("#include bad #include \"second.sfz\"");
+}
+
+TEST_CASE("[Lexer] #define")
+{
+    compareDefine("#define $number 1");
+    compareDefine("#define $letters QWERasdf");
+    compareDefine("#define  $whitespace   asr1t44   ");
+    compareDefine("#define $lazyMatching  matched  bfasd ");
+    compareDefine("#define $symbols# 1");
+    compareDefine("#define $symbolsAgain $1");
+    compareDefine("#define $trailingSymbols 1$");
+    compareDefine("#define $noValue");
+    compareDefine("#define$noSpace 12");
+    compareDefine("#define $ 12");
+    compareDefine("#define $bad 1$ #define $good 2");
+}
+
+TEST_CASE("[Lexer] Header")
+{
+    std::string_view content { "junk <header>param1=value1 param2=value2<next> a=b <unterminated" };
+    std::string_view header;
+    std::string_view members;
+    REQUIRE(sfz::Lexer::readHeader(content, header, members));
+    REQUIRE(header == "header");
+    REQUIRE(members == "param1=value1 param2=value2");
+    REQUIRE(sfz::Lexer::readHeader(content, header, members));
+    REQUIRE(header == "next");
+    REQUIRE(members == " a=b ");
+    REQUIRE(!sfz::Lexer::readHeader(content, header, members));
+}
+
+TEST_CASE("[Lexer] Member")
+{
+    compareMembers("param=value");
+    compareMembers("ampeg_sustain_oncc74=-100 lorand=0.750");
+    compareMembers("sample=value-()*");
+    compareMembers("sample=subdir space\\sample.wav next_member=value");
+    compareMembers("sample=..\\Samples\\SMD Cymbals Stereo (Samples)\\Hi-Hat (Samples)\\01 Hat Tight 1\\RR1\\09_Hat_Tight_Cnt_RR1.wav key=36");
+    compareMembers("lokey=c4 hikey=c#4 pitch_keycenter=60");
+    compareMembers("x=60  key=1\tvel=2 ");
+    compareMembers("a=b=c d=e");
+    compareMembers("x= y=1");
+    compareMembers("a=,b=1");
+    compareMembers("x=$y z=1");
+    compareMembers("foo-bar=1 baz='q' w=2");
+    compareMembers("=1 a=");
+}
+
+TEST_CASE("[Parser] The lexer and the regexes agree on the test files")
+{
+    const auto testFiles = std::filesystem::current_path() / "tests/TestFiles";
+    for (auto& entry : std::filesystem::recursive_directory_iterator(testFiles)) {
+        if (entry.path().extension() != ".sfz")
+            continue;
+
+        INFO("File: " << entry.path());
+        RecordingParser lexerParser;
+        lexerParser.enableRecursiveIncludeGuard();
+        REQUIRE(lexerParser.loadSfzFile(entry.path()));
+
+        RecordingParser regexParser;
+        regexParser.enableRecursiveIncludeGuard();
+        regexParser.enableRegexParsing();
+        REQUIRE(regexParser.loadSfzFile(entry.path()));
+
+        REQUIRE(lexerParser.headers == regexParser.headers);
+        REQUIRE(lexerParser.getDefines() == regexParser.getDefines());
+        REQUIRE(lexerParser.getIncludedFiles() == regexParser.getIncludedFiles());
+    }
+}
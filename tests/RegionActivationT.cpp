@@ -286,3 +286,49 @@ TEST_CASE("Region activation", "Region tests")
         REQUIRE(region.isSwitchedOn());
     }
 }
+
+TEST_CASE("[Region] Notes and CCs affecting a region", "Region tests")
+{
+    sfz::Region region {};
+    region.parseOpcode({ "sample", "*sine" });
+    region.parseOpcode({ "lokey", "60" });
+    region.parseOpcode({ "hikey", "62" });
+    SECTION("Key range")
+    {
+        REQUIRE(!region.isAffectedByNote(59));
+        REQUIRE(region.isAffectedByNote(60));
+        REQUIRE(region.isAffectedByNote(62));
+        REQUIRE(!region.isAffectedByNote(63));
+    }
+
+    SECTION("Last keyswitch")
+    {
+        region.parseOpcode({ "sw_lokey", "24" });
+        region.parseOpcode({ "sw_hikey", "28" });
+        region.parseOpcode({ "sw_last", "26" });
+        REQUIRE(!region.isAffectedByNote(23));
+        REQUIRE(region.isAffectedByNote(24));
+        REQUIRE(region.isAffectedByNote(28));
+        REQUIRE(!region.isAffectedByNote(29));
+        REQUIRE(region.isAffectedByNote(61));
+    }
+
+    SECTION("Keyswitches up and down")
+    {
+        region.parseOpcode({ "sw_down", "24" });
+        region.parseOpcode({ "sw_up", "26" });
+        REQUIRE(region.isAffectedByNote(24));
+        REQUIRE(!region.isAffectedByNote(25));
+        REQUIRE(region.isAffectedByNote(26));
+    }
+
+    SECTION("CC conditions and triggers")
+    {
+        REQUIRE(!region.isAffectedByCC(4));
+        region.parseOpcode({ "locc4", "56" });
+        region.parseOpcode({ "on_locc20", "10" });
+        REQUIRE(region.isAffectedByCC(4));
+        REQUIRE(region.isAffectedByCC(20));
+        REQUIRE(!region.isAffectedByCC(5));
+    }
+}
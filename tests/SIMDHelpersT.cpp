@@ -22,6 +22,7 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "SIMDHelpers.h"
+#include "Interpolators.h"
 #include "catch2/catch.hpp"
 #include <absl/algorithm/container.h>
 #include <absl/types/span.h>
@@ -511,6 +512,132 @@ TEST_CASE("[Helpers] SFZ saturating index (SIMD vs Scalar)")
         REQUIRE( static_cast<float>(indices[i]) + rightCoeffs[i] == Approx(static_cast<float>(indicesSIMD[i]) + rightCoeffsSIMD[i]));
 }
 
+TEST_CASE("[Helpers] Linear interpolation")
+{
+    std::array<float, 6> input { 0.0f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f };
+    std::array<int, 4> indices { 0, 2, 2, 4 };
+    std::array<float, 4> leftCoeffs { 1.0f, 0.5f, 0.25f, 0.0f };
+    std::array<float, 4> rightCoeffs { 0.0f, 0.5f, 0.75f, 1.0f };
+    std::array<float, 4> output;
+    std::array<float, 4> expected { 0.0f, 3.0f, 3.5f, 16.0f };
+    interpolateLinear<float, false>(indices, leftCoeffs, rightCoeffs, input, absl::MakeSpan(output));
+    REQUIRE(approxEqual<float>(output, expected));
+    interpolateLinear<float, true>(indices, leftCoeffs, rightCoeffs, input, absl::MakeSpan(output));
+    REQUIRE(approxEqual<float>(output, expected));
+}
+
+TEST_CASE("[Helpers] Linear interpolation (SIMD vs scalar)")
+{
+    std::vector<float> input(bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(input), 0.0f, 0.1f);
+    sin<float, false>(input, absl::MakeSpan(input));
+
+    std::vector<int> indices(medBufferSize);
+    std::vector<float> leftCoeffs(medBufferSize);
+    std::vector<float> rightCoeffs(medBufferSize);
+    std::vector<float> outputScalar(medBufferSize);
+    std::vector<float> outputSIMD(medBufferSize);
+
+    // Contiguous frames, mixed strides, and a short loop going backwards in the input
+    for (auto jump : { 1.0f, 0.7f, 1.3f, 2.5f }) {
+        std::vector<float> jumps(medBufferSize, jump);
+        loopingSFZIndex<float, false>(jumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), 10.25f, 60.0f, 30.0f);
+        interpolateLinear<float, false>(indices, leftCoeffs, rightCoeffs, input, absl::MakeSpan(outputScalar));
+        interpolateLinear<float, true>(indices, leftCoeffs, rightCoeffs, input, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqualMargin<float>(outputScalar, outputSIMD, 1e-6f));
+    }
+}
+
+TEST_CASE("[Helpers] Hermite interpolation")
+{
+    // The spline goes through quadratics exactly; the frames before the input are silent
+    std::array<float, 8> input { 0.0f, 1.0f, 4.0f, 9.0f, 16.0f, 25.0f, 36.0f, 49.0f };
+    std::array<int, 5> indices { 2, 3, 4, 4, 0 };
+    std::array<float, 5> coeffs { 0.0f, 0.5f, 0.25f, 0.75f, 0.5f };
+    std::array<float, 5> output;
+    std::array<float, 5> expected { 4.0f, 12.25f, 18.0625f, 22.5625f, 0.3125f };
+    interpolateHermite<float, false>(indices, coeffs, input, absl::MakeSpan(output));
+    REQUIRE(approxEqual<float>(output, expected));
+    interpolateHermite<float, true>(indices, coeffs, input, absl::MakeSpan(output));
+    REQUIRE(approxEqual<float>(output, expected));
+}
+
+TEST_CASE("[Helpers] Hermite interpolation (SIMD vs scalar)")
+{
+    std::vector<float> input(bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(input), 0.0f, 0.1f);
+    sin<float, false>(input, absl::MakeSpan(input));
+
+    std::vector<int> indices(medBufferSize);
+    std::vector<float> leftCoeffs(medBufferSize);
+    std::vector<float> rightCoeffs(medBufferSize);
+    std::vector<float> outputScalar(medBufferSize);
+    std::vector<float> outputSIMD(medBufferSize);
+
+    for (auto jump : { 1.0f, 0.7f, 1.3f, 2.5f }) {
+        std::vector<float> jumps(medBufferSize, jump);
+        loopingSFZIndex<float, false>(jumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), 0.25f, 60.0f, 30.0f);
+        interpolateHermite<float, false>(indices, rightCoeffs, input, absl::MakeSpan(outputScalar));
+        interpolateHermite<float, true>(indices, rightCoeffs, input, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqualMargin<float>(outputScalar, outputSIMD, 1e-6f));
+    }
+}
+
+TEST_CASE("[Helpers] Sinc interpolation")
+{
+    const sfz::SincTable table { 8, 1.0f };
+    std::vector<float> input(medBufferSize, 1.0f);
+    std::vector<int> indices { 1, 10, 10, 20, 20, 30, 40, static_cast<int>(input.size()) - 2 };
+    std::vector<float> coeffs { 0.5f, 0.0f, 0.3f, 0.5f, 0.999f, 0.125f, 0.75f, 0.5f };
+    std::vector<float> output(indices.size());
+
+    // The interpolation keeps a unit gain, except next to the silent edges
+    for (bool simd : { false, true }) {
+        if (simd)
+            interpolateSinc<float, true>(indices, coeffs, input, absl::MakeSpan(output), table.getCoefficients(), table.getNumTaps());
+        else
+            interpolateSinc<float, false>(indices, coeffs, input, absl::MakeSpan(output), table.getCoefficients(), table.getNumTaps());
+        for (size_t i = 1; i < output.size() - 1; ++i)
+            REQUIRE(output[i] == Approx(1.0f).margin(1e-5));
+        REQUIRE(output.front() != Approx(1.0f).margin(1e-3));
+        REQUIRE(output.back() != Approx(1.0f).margin(1e-3));
+    }
+
+    // A slow sine goes through unchanged
+    linearRamp<float, false>(absl::MakeSpan(input), 0.0f, 0.1f);
+    sin<float, false>(input, absl::MakeSpan(input));
+    for (size_t i = 1; i < output.size() - 1; ++i)
+        output[i] = std::sin(0.1f * (static_cast<float>(indices[i]) + coeffs[i]) + 0.1f);
+    std::vector<float> expected(output);
+    interpolateSinc<float, true>(indices, coeffs, input, absl::MakeSpan(output), table.getCoefficients(), table.getNumTaps());
+    for (size_t i = 1; i < output.size() - 1; ++i)
+        REQUIRE(output[i] == Approx(expected[i]).margin(1e-3));
+}
+
+TEST_CASE("[Helpers] Sinc interpolation (SIMD vs scalar)")
+{
+    std::vector<float> input(bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(input), 0.0f, 0.1f);
+    sin<float, false>(input, absl::MakeSpan(input));
+
+    std::vector<int> indices(medBufferSize);
+    std::vector<float> leftCoeffs(medBufferSize);
+    std::vector<float> rightCoeffs(medBufferSize);
+    std::vector<float> outputScalar(medBufferSize);
+    std::vector<float> outputSIMD(medBufferSize);
+
+    for (int numTaps : { 8, 16, 32 }) {
+        const sfz::SincTable table { numTaps, 1.5f };
+        for (auto jump : { 1.0f, 0.7f, 1.3f, 2.5f }) {
+            std::vector<float> jumps(medBufferSize, jump);
+            loopingSFZIndex<float, false>(jumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), 0.25f, 60.0f, 30.0f);
+            interpolateSinc<float, false>(indices, rightCoeffs, input, absl::MakeSpan(outputScalar), table.getCoefficients(), numTaps);
+            interpolateSinc<float, true>(indices, rightCoeffs, input, absl::MakeSpan(outputSIMD), table.getCoefficients(), numTaps);
+            REQUIRE(approxEqualMargin<float>(outputScalar, outputSIMD, 1e-5f));
+        }
+    }
+}
+
 TEST_CASE("[Helpers] Linear Ramp")
 {
     const float start { 0.0f };
@@ -684,3 +811,213 @@ TEST_CASE("[Helpers] copy (SIMD vs scalar)")
     add<float, true>(input, absl::MakeSpan(outputSIMD));
     REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
 }
+
+TEST_CASE("[Helpers] panMono matches the separate block operations")
+{
+    std::vector<float> gain(medBufferSize);
+    std::vector<float> pan(medBufferSize);
+    std::vector<float> left(medBufferSize);
+    std::vector<float> right(medBufferSize);
+    std::vector<float> expectedLeft(medBufferSize);
+    std::vector<float> expectedRight(medBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(gain), 0.1f, 0.005f);
+    linearRamp<float, false>(absl::MakeSpan(pan), -1.0f, 2.0f / medBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(left), -0.5f, 0.01f);
+
+    absl::c_copy(left, expectedLeft.begin());
+    for (int i = 0; i < medBufferSize; ++i) {
+        expectedLeft[i] *= gain[i];
+        expectedRight[i] = expectedLeft[i];
+        expectedLeft[i] *= std::cos(piFour<float> * (1.0f + pan[i]));
+        expectedRight[i] *= std::sin(piFour<float> * (1.0f + pan[i]));
+    }
+
+    panMono<float, false>(gain, pan, absl::MakeSpan(left), absl::MakeSpan(right));
+    REQUIRE(approxEqualMargin<float>(left, expectedLeft, 1e-6f));
+    REQUIRE(approxEqualMargin<float>(right, expectedRight, 1e-6f));
+}
+
+TEST_CASE("[Helpers] panMono (SIMD vs scalar)")
+{
+    std::vector<float> gain(bigBufferSize);
+    std::vector<float> pan(bigBufferSize);
+    std::vector<float> leftScalar(bigBufferSize);
+    std::vector<float> rightScalar(bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(gain), 0.0f, 1.0f / bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(pan), -1.0f, 2.0f / bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(leftScalar), -1.0f, 2.0f / bigBufferSize);
+    std::vector<float> leftSIMD { leftScalar };
+    std::vector<float> rightSIMD(bigBufferSize);
+
+    panMono<float, false>(gain, pan, absl::MakeSpan(leftScalar), absl::MakeSpan(rightScalar));
+    panMono<float, true>(gain, pan, absl::MakeSpan(leftSIMD), absl::MakeSpan(rightSIMD));
+    REQUIRE(approxEqualMargin<float>(leftScalar, leftSIMD, 1e-6f));
+    REQUIRE(approxEqualMargin<float>(rightScalar, rightSIMD, 1e-6f));
+}
+
+TEST_CASE("[Helpers] widthPosition matches the separate block operations")
+{
+    std::vector<float> gain(medBufferSize);
+    std::vector<float> width(medBufferSize);
+    std::vector<float> position(medBufferSize);
+    std::vector<float> left(medBufferSize);
+    std::vector<float> right(medBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(gain), 0.1f, 0.005f);
+    linearRamp<float, false>(absl::MakeSpan(width), -1.0f, 2.0f / medBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(position), 1.0f, -2.0f / medBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(left), -0.5f, 0.01f);
+    linearRamp<float, false>(absl::MakeSpan(right), 0.3f, -0.004f);
+
+    // The chain that the voices used before the fused kernel
+    std::vector<float> expectedLeft { left };
+    std::vector<float> expectedRight { right };
+    std::vector<float> temp1(medBufferSize);
+    std::vector<float> temp2(medBufferSize);
+    std::vector<float> temp3(medBufferSize);
+    auto leftSpan = absl::MakeSpan(expectedLeft);
+    auto rightSpan = absl::MakeSpan(expectedRight);
+    auto span1 = absl::MakeSpan(temp1);
+    auto span2 = absl::MakeSpan(temp2);
+    auto span3 = absl::MakeSpan(temp3);
+    applyGain<float, false>(gain, leftSpan);
+    applyGain<float, false>(gain, rightSpan);
+    copy<float, false>(rightSpan, span1);
+    add<float, false>(leftSpan, rightSpan);
+    subtract<float, false>(span1, leftSpan);
+    applyGain<float, false>(sqrtTwoInv<float>, leftSpan);
+    applyGain<float, false>(sqrtTwoInv<float>, rightSpan);
+    copy<float, false>(width, span1);
+    fill<float, false>(span2, 1.0f);
+    add<float, false>(span1, span2);
+    applyGain<float, false>(piFour<float>, span2);
+    cos<float, false>(span2, span1);
+    sin<float, false>(span2, span2);
+    applyGain<float, false>(span1, leftSpan);
+    applyGain<float, false>(span2, rightSpan);
+    copy<float, false>(position, span1);
+    fill<float, false>(span2, 1.0f);
+    add<float, false>(span1, span2);
+    applyGain<float, false>(piFour<float>, span2);
+    cos<float, false>(span2, span1);
+    sin<float, false>(span2, span2);
+    copy<float, false>(leftSpan, span3);
+    copy<float, false>(rightSpan, leftSpan);
+    multiplyAdd<float, false>(span1, span3, leftSpan);
+    multiplyAdd<float, false>(span2, span3, rightSpan);
+    applyGain<float, false>(sqrtTwoInv<float>, leftSpan);
+    applyGain<float, false>(sqrtTwoInv<float>, rightSpan);
+
+    widthPosition<float, false>(gain, width, position, absl::MakeSpan(left), absl::MakeSpan(right));
+    REQUIRE(approxEqualMargin<float>(left, expectedLeft, 1e-6f));
+    REQUIRE(approxEqualMargin<float>(right, expectedRight, 1e-6f));
+}
+
+TEST_CASE("[Helpers] widthPosition (SIMD vs scalar)")
+{
+    std::vector<float> gain(bigBufferSize);
+    std::vector<float> width(bigBufferSize);
+    std::vector<float> position(bigBufferSize);
+    std::vector<float> leftScalar(bigBufferSize);
+    std::vector<float> rightScalar(bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(gain), 0.0f, 1.0f / bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(width), -1.0f, 2.0f / bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(position), 1.0f, -2.0f / bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(leftScalar), -1.0f, 2.0f / bigBufferSize);
+    linearRamp<float, false>(absl::MakeSpan(rightScalar), 0.5f, -1.0f / bigBufferSize);
+    std::vector<float> leftSIMD { leftScalar };
+    std::vector<float> rightSIMD { rightScalar };
+
+    widthPosition<float, false>(gain, width, position, absl::MakeSpan(leftScalar), absl::MakeSpan(rightScalar));
+    widthPosition<float, true>(gain, width, position, absl::MakeSpan(leftSIMD), absl::MakeSpan(rightSIMD));
+    REQUIRE(approxEqualMargin<float>(leftScalar, leftSIMD, 1e-6f));
+    REQUIRE(approxEqualMargin<float>(rightScalar, rightSIMD, 1e-6f));
+}
+
+TEST_CASE("[Helpers] Runtime SIMD levels (SIMD vs scalar)")
+{
+    const auto initialLevel = getSIMDLevel();
+    REQUIRE(initialLevel == getSupportedSIMDLevel());
+    for (auto level : { SIMDLevel::Baseline, SIMDLevel::AVX2, SIMDLevel::AVX512 }) {
+        setSIMDLevel(level);
+        if (getSIMDLevel() != level)
+            continue;
+
+        // Sizes that are not a multiple of any vector size, so that the tails are used too
+        std::vector<float> input(medBufferSize);
+        std::vector<float> gain(medBufferSize);
+        std::vector<float> outputScalar(medBufferSize);
+        std::vector<float> outputSIMD(medBufferSize);
+        linearRamp<float, false>(absl::MakeSpan(input), -3.0f, 0.05f);
+        linearRamp<float, false>(absl::MakeSpan(gain), 0.0f, 0.01f);
+
+        applyGain<float, false>(1.3f, input, absl::MakeSpan(outputScalar));
+        applyGain<float, true>(1.3f, input, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        applyGain<float, false>(gain, input, absl::MakeSpan(outputScalar));
+        applyGain<float, true>(gain, input, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        multiplyAdd<float, false>(gain, input, absl::MakeSpan(outputScalar));
+        multiplyAdd<float, true>(gain, input, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        REQUIRE(linearRamp<float, false>(absl::MakeSpan(outputScalar), 1.0f, 0.1f) == Approx(linearRamp<float, true>(absl::MakeSpan(outputSIMD), 1.0f, 0.1f)));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        REQUIRE(multiplicativeRamp<float, false>(absl::MakeSpan(outputScalar), 1.0f, 1.01f) == Approx(multiplicativeRamp<float, true>(absl::MakeSpan(outputSIMD), 1.0f, 1.01f)));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        exp<float, false>(input, absl::MakeSpan(outputScalar));
+        exp<float, true>(input, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        sin<float, false>(input, absl::MakeSpan(outputScalar));
+        sin<float, true>(input, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqualMargin<float>(outputScalar, outputSIMD, 1e-6f));
+
+        cos<float, false>(input, absl::MakeSpan(outputScalar));
+        cos<float, true>(input, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqualMargin<float>(outputScalar, outputSIMD, 1e-6f));
+
+        log<float, false>(absl::MakeConstSpan(gain).subspan(1), absl::MakeSpan(outputScalar).subspan(1));
+        log<float, true>(absl::MakeConstSpan(gain).subspan(1), absl::MakeSpan(outputSIMD).subspan(1));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        // The loop is short enough for a vector to go around it several times
+        std::vector<float> jumps(medBufferSize);
+        linearRamp<float, false>(absl::MakeSpan(jumps), 0.9f, 0.001f);
+        std::vector<int> indices(medBufferSize);
+        std::vector<float> leftCoeffs(medBufferSize);
+        std::vector<float> rightCoeffs(medBufferSize);
+        std::vector<int> indicesSIMD(medBufferSize);
+        std::vector<float> leftCoeffsSIMD(medBufferSize);
+        std::vector<float> rightCoeffsSIMD(medBufferSize);
+        const auto endScalar = loopingSFZIndex<float, false>(jumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), 2.0f, 7.0f, 2.0f);
+        const auto endSIMD = loopingSFZIndex<float, true>(jumps, absl::MakeSpan(leftCoeffsSIMD), absl::MakeSpan(rightCoeffsSIMD), absl::MakeSpan(indicesSIMD), 2.0f, 7.0f, 2.0f);
+        REQUIRE(endSIMD == Approx(endScalar).margin(1e-3));
+        for (int i = 0; i < medBufferSize; ++i)
+            REQUIRE(static_cast<float>(indicesSIMD[i]) + rightCoeffsSIMD[i] == Approx(static_cast<float>(indices[i]) + rightCoeffs[i]).margin(1e-3));
+
+        saturatingSFZIndex<float, false>(jumps, absl::MakeSpan(leftCoeffs), absl::MakeSpan(rightCoeffs), absl::MakeSpan(indices), 1.0f, 100.0f);
+        saturatingSFZIndex<float, true>(jumps, absl::MakeSpan(leftCoeffsSIMD), absl::MakeSpan(rightCoeffsSIMD), absl::MakeSpan(indicesSIMD), 1.0f, 100.0f);
+        for (int i = 0; i < medBufferSize; ++i)
+            REQUIRE(static_cast<float>(indicesSIMD[i]) + rightCoeffsSIMD[i] == Approx(static_cast<float>(indices[i]) + rightCoeffs[i]).margin(1e-3));
+
+        std::vector<float> source(medBufferSize + 1);
+        linearRamp<float, false>(absl::MakeSpan(source), 0.0f, 0.5f);
+        interpolateLinear<float, false>(indices, leftCoeffs, rightCoeffs, source, absl::MakeSpan(outputScalar));
+        interpolateLinear<float, true>(indices, leftCoeffs, rightCoeffs, source, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        interpolateHermite<float, false>(indices, rightCoeffs, source, absl::MakeSpan(outputScalar));
+        interpolateHermite<float, true>(indices, rightCoeffs, source, absl::MakeSpan(outputSIMD));
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+
+        const sfz::SincTable table { 16, 1.0f };
+        interpolateSinc<float, false>(indices, rightCoeffs, source, absl::MakeSpan(outputScalar), table.getCoefficients(), table.getNumTaps());
+        interpolateSinc<float, true>(indices, rightCoeffs, source, absl::MakeSpan(outputSIMD), table.getCoefficients(), table.getNumTaps());
+        REQUIRE(approxEqual<float>(outputScalar, outputSIMD));
+    }
+    setSIMDLevel(initialLevel);
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SampleCache.h"
+#include "Synth.h"
+#include "catch2/catch.hpp"
+#include <filesystem>
+#include <memory>
+using namespace Catch::literals;
+
+TEST_CASE("[SampleCache] Synths share their preloaded samples")
+{
+    auto& cache = sfz::SampleCache::getInstance();
+    const auto sfzFile = std::filesystem::current_path() / "tests/TestFiles/channels.sfz";
+
+    sfz::Synth firstSynth;
+    firstSynth.loadSfzFile(sfzFile);
+    REQUIRE(firstSynth.getNumRegions() == 2);
+
+    const auto statistics = cache.getStatistics();
+    sfz::Synth secondSynth;
+    secondSynth.loadSfzFile(sfzFile);
+    REQUIRE(secondSynth.getNumRegions() == 2);
+    REQUIRE(cache.getStatistics().hits == statistics.hits + 2);
+    REQUIRE(cache.getStatistics().misses == statistics.misses);
+    REQUIRE(firstSynth.getRegionView(0)->cachedSample == secondSynth.getRegionView(0)->cachedSample);
+    REQUIRE(firstSynth.getRegionView(1)->cachedSample == secondSynth.getRegionView(1)->cachedSample);
+}
+
+TEST_CASE("[SampleCache] Samples are released with their last user")
+{
+    auto& cache = sfz::SampleCache::getInstance();
+    const auto identity = sfz::SampleCache::identify(std::filesystem::current_path() / "tests/TestFiles/mono_sample.wav");
+    REQUIRE(identity);
+
+    std::weak_ptr<sfz::CachedSample> cachedSample;
+    {
+        sfz::Synth synth;
+        synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+        cachedSample = synth.getRegionView(0)->cachedSample;
+        REQUIRE(cache.find(*identity));
+    }
+    REQUIRE(cachedSample.expired());
+    REQUIRE(!cache.find(*identity));
+}
+
+TEST_CASE("[SampleCache] File identities")
+{
+    const auto directory = std::filesystem::current_path() / "tests/TestFiles";
+    REQUIRE(!sfz::SampleCache::identify(directory / "nonexistent.wav"));
+
+    const auto identity = sfz::SampleCache::identify(directory / "mono_sample.wav");
+    const auto sameIdentity = sfz::SampleCache::identify(directory / "Regions/../mono_sample.wav");
+    const auto otherIdentity = sfz::SampleCache::identify(directory / "kick.wav");
+    REQUIRE(identity);
+    REQUIRE(sameIdentity);
+    REQUIRE(otherIdentity);
+    REQUIRE(*identity == *sameIdentity);
+    REQUIRE(!(*identity == *otherIdentity));
+}
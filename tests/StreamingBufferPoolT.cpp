@@ -0,0 +1,75 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "StreamingBufferPool.h"
+#include "catch2/catch.hpp"
+#include <vector>
+
+TEST_CASE("[StreamingBufferPool] Spare buffers are allocated upfront")
+{
+    sfz::StreamingBufferPool pool { 8, 2 };
+    REQUIRE(pool.getNumAllocated() == 2);
+    REQUIRE(pool.getNumSpare() == 2);
+    pool.replenish();
+    REQUIRE(pool.getNumAllocated() == 2);
+}
+
+TEST_CASE("[StreamingBufferPool] Acquire, release and replenish")
+{
+    sfz::StreamingBufferPool pool { 8, 2 };
+    auto first = pool.acquire();
+    auto second = pool.acquire();
+    REQUIRE(first != nullptr);
+    REQUIRE(second != nullptr);
+    REQUIRE(first != second);
+    REQUIRE(pool.acquire() == nullptr);
+    REQUIRE(pool.getNumSpare() == 0);
+
+    pool.replenish();
+    REQUIRE(pool.getNumAllocated() == 4);
+    REQUIRE(pool.getNumSpare() == 2);
+    REQUIRE(pool.acquire() != nullptr);
+
+    // Released buffers are handed out again before the new ones
+    pool.release(first);
+    REQUIRE(pool.acquire() == first);
+    pool.release(nullptr);
+    REQUIRE(pool.getNumSpare() == 1);
+}
+
+TEST_CASE("[StreamingBufferPool] No more buffers than the maximum")
+{
+    sfz::StreamingBufferPool pool { 3, 2 };
+    std::vector<sfz::StreamingBuffer*> buffers;
+    for (int i = 0; i < 4; ++i) {
+        pool.replenish();
+        while (auto buffer = pool.acquire())
+            buffers.push_back(buffer);
+    }
+    REQUIRE(buffers.size() == 3);
+    REQUIRE(pool.getNumAllocated() == 3);
+
+    for (auto buffer : buffers)
+        pool.release(buffer);
+    REQUIRE(pool.getNumSpare() == 3);
+}
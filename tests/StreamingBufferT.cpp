@@ -0,0 +1,168 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "StreamingBuffer.h"
+#include "AudioBuffer.h"
+#include "AudioSpan.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+using namespace Catch::literals;
+
+constexpr uint32_t testCapacity { 16 };
+
+TEST_CASE("[StreamingBuffer] Nothing is available before writing")
+{
+    sfz::StreamingBuffer buffer { 2, testCapacity };
+    buffer.start(1);
+    REQUIRE(buffer.availableFrames(1) == 0);
+    REQUIRE(buffer.freeFrames(0) == testCapacity);
+    REQUIRE(buffer.isCurrent(1));
+    REQUIRE(!buffer.isCurrent(2));
+}
+
+TEST_CASE("[StreamingBuffer] Write and read back")
+{
+    sfz::StreamingBuffer buffer { 2, testCapacity };
+    AudioBuffer<float> chunk { 2, 8 };
+    std::iota(chunk.channelWriter(0), chunk.channelWriterEnd(0), 0.0f);
+    std::iota(chunk.channelWriter(1), chunk.channelWriterEnd(1), 100.0f);
+
+    buffer.start(1);
+    REQUIRE(buffer.write(1, 0, AudioSpan<const float>(chunk)));
+    REQUIRE(buffer.availableFrames(1) == 8);
+    REQUIRE(buffer.freeFrames(8) == testCapacity - 8);
+    REQUIRE(buffer.getSpan(0)[0] == 0.0f);
+    REQUIRE(buffer.getSpan(0)[7] == 7.0f);
+    REQUIRE(buffer.getSpan(1)[7] == 107.0f);
+    // The guard frame mirrors the first frame
+    REQUIRE(buffer.getSpan(0)[testCapacity] == 0.0f);
+}
+
+TEST_CASE("[StreamingBuffer] Writes wrap around")
+{
+    sfz::StreamingBuffer buffer { 1, testCapacity };
+    AudioBuffer<float> chunk { 1, 12 };
+    std::iota(chunk.channelWriter(0), chunk.channelWriterEnd(0), 0.0f);
+
+    buffer.start(1);
+    REQUIRE(buffer.write(1, 0, AudioSpan<const float>(chunk)));
+    buffer.consume(10);
+    REQUIRE(buffer.freeFrames(12) == 14);
+    std::iota(chunk.channelWriter(0), chunk.channelWriterEnd(0), 12.0f);
+    REQUIRE(buffer.write(1, 12, AudioSpan<const float>(chunk)));
+    REQUIRE(buffer.availableFrames(1) == 24);
+    REQUIRE(buffer.getSpan(0)[15] == 15.0f);
+    REQUIRE(buffer.getSpan(0)[0] == 16.0f);
+    REQUIRE(buffer.getSpan(0)[7] == 23.0f);
+    REQUIRE(buffer.getSpan(0)[testCapacity] == 16.0f);
+}
+
+TEST_CASE("[StreamingBuffer] History and guard frames")
+{
+    sfz::StreamingBuffer buffer { 1, testCapacity, 3, 2 };
+    AudioBuffer<float> chunk { 1, 12 };
+    std::iota(chunk.channelWriter(0), chunk.channelWriterEnd(0), 1.0f);
+
+    buffer.start(1);
+    REQUIRE(buffer.getNumHistoryFrames() == 3);
+    REQUIRE(buffer.freeFrames(0) == testCapacity - 3);
+    REQUIRE(buffer.write(1, 0, AudioSpan<const float>(chunk)));
+    // The frames before the first lap are silent
+    const auto padded = buffer.getPaddedSpan(0);
+    REQUIRE(padded.size() == 3 + testCapacity + 2);
+    REQUIRE(padded[0] == 0.0f);
+    REQUIRE(padded[2] == 0.0f);
+    REQUIRE(padded[3] == 1.0f);
+    REQUIRE(buffer.getSpan(0)[0] == 1.0f);
+    REQUIRE(padded[3 + testCapacity] == 1.0f);
+    REQUIRE(padded[4 + testCapacity] == 2.0f);
+
+    // The reader may still need the history frames, which are not free
+    buffer.consume(10);
+    REQUIRE(buffer.freeFrames(12) == 11);
+    std::iota(chunk.channelWriter(0), chunk.channelWriterEnd(0), 13.0f);
+    REQUIRE(buffer.write(1, 12, AudioSpan<const float>(chunk).first(11)));
+    // The history mirrors the end of the ring and the guard its start
+    REQUIRE(padded[0] == 14.0f);
+    REQUIRE(padded[2] == 16.0f);
+    REQUIRE(buffer.getSpan(0)[0] == 17.0f);
+    REQUIRE(padded[3 + testCapacity] == 17.0f);
+    REQUIRE(padded[4 + testCapacity] == 18.0f);
+}
+
+TEST_CASE("[StreamingBuffer] Obsolete streams are not published")
+{
+    sfz::StreamingBuffer buffer { 1, testCapacity };
+    AudioBuffer<float> chunk { 1, 4 };
+    buffer.start(1);
+    buffer.start(2);
+    REQUIRE(!buffer.write(1, 0, AudioSpan<const float>(chunk)));
+    REQUIRE(buffer.availableFrames(1) == 0);
+    REQUIRE(buffer.availableFrames(2) == 0);
+    buffer.stop();
+    REQUIRE(!buffer.isCurrent(2));
+    REQUIRE(!buffer.write(2, 0, AudioSpan<const float>(chunk)));
+}
+
+TEST_CASE("[StreamingBuffer] Restarting waits for the obsolete writers")
+{
+    // The loader keeps copying under its ticket while the ring restarts under the next one
+    constexpr uint32_t capacity { 1024 };
+    constexpr uint32_t numHistoryFrames { 4 };
+    sfz::StreamingBuffer buffer { 1, capacity, numHistoryFrames };
+    AudioBuffer<float> stale { 1, capacity - numHistoryFrames };
+    AudioBuffer<float> fresh { 1, capacity - numHistoryFrames };
+    std::fill(stale.channelWriter(0), stale.channelWriterEnd(0), 1.0f);
+    std::fill(fresh.channelWriter(0), fresh.channelWriterEnd(0), 2.0f);
+
+    std::atomic<unsigned> loaderTicket { sfz::StreamingBuffer::noTicket };
+    std::atomic<bool> done { false };
+    std::thread loader([&]() {
+        while (!done)
+            buffer.write(loaderTicket, 0, AudioSpan<const float>(stale));
+    });
+
+    bool intact { true };
+    for (unsigned ticket = 1; ticket < 200 && intact; ticket += 2) {
+        buffer.start(ticket);
+        loaderTicket = ticket;
+        while (buffer.availableFrames(ticket) == 0)
+            std::this_thread::yield();
+
+        buffer.start(ticket + 1);
+        intact = buffer.write(ticket + 1, 0, AudioSpan<const float>(fresh));
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        const auto padded = buffer.getPaddedSpan(0);
+        intact = intact && std::all_of(padded.begin(), padded.begin() + numHistoryFrames, [](float x) { return x == 0.0f; });
+        const auto written = buffer.getSpan(0).first(capacity - numHistoryFrames);
+        intact = intact && std::all_of(written.begin(), written.end(), [](float x) { return x == 2.0f; });
+    }
+
+    done = true;
+    loader.join();
+    REQUIRE(intact);
+}
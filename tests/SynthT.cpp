@@ -0,0 +1,656 @@
+// Copyright (c) 2019, Paul Ferrand
+// All rights reserved.
+
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Synth.h"
+#include "RealtimeChecks.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+using namespace Catch::literals;
+
+namespace {
+constexpr int blockSize { 256 };
+
+void renderBlocks(sfz::Synth& synth, int numBlocks)
+{
+    AudioBuffer<float> buffer { 2, blockSize };
+    for (int i = 0; i < numBlocks; ++i)
+        synth.renderBlock(buffer);
+}
+
+void renderUntilSilent(sfz::Synth& synth)
+{
+    AudioBuffer<float> buffer { 2, blockSize };
+    for (int i = 0; i < 100 && synth.getNumActiveVoices() > 0; ++i)
+        synth.renderBlock(buffer);
+}
+
+void waitForLoading(const sfz::Synth& synth)
+{
+    while (synth.getLoadingStatus() == sfz::Synth::LoadingStatus::Loading)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+}
+
+TEST_CASE("[Synth] Active voices")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+    REQUIRE(synth.getNumActiveVoices() == 0);
+    synth.noteOn(0, 1, 60, 127);
+    synth.noteOn(0, 1, 62, 127);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+    synth.noteOff(0, 1, 60, 0);
+    synth.noteOff(0, 1, 62, 0);
+    renderUntilSilent(synth);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+}
+
+TEST_CASE("[Synth] Pitch wheel, aftertouch and tempo switches")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/performance_switches.sfz");
+    auto numVoicesStarted = [&](int note) {
+        const auto numVoices = synth.getNumActiveVoices();
+        synth.noteOn(0, 1, note, 127);
+        return synth.getNumActiveVoices() - numVoices;
+    };
+
+    synth.pitchWheel(0, 1, -100);
+    synth.aftertouch(0, 1, 10);
+    synth.tempo(0, 1.0f);
+    REQUIRE(numVoicesStarted(60) == 0);
+    REQUIRE(numVoicesStarted(62) == 0);
+    REQUIRE(numVoicesStarted(64) == 0);
+    REQUIRE(numVoicesStarted(66) == 1);
+
+    synth.pitchWheel(0, 1, 100);
+    synth.aftertouch(0, 1, 100);
+    synth.tempo(0, 0.5f);
+    REQUIRE(numVoicesStarted(60) == 1);
+    REQUIRE(numVoicesStarted(62) == 1);
+    REQUIRE(numVoicesStarted(64) == 1);
+    REQUIRE(numVoicesStarted(66) == 1);
+}
+
+TEST_CASE("[Synth] Freed voices are started again")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+    for (int i = 0; i < sfz::config::numVoices; ++i)
+        synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getNumActiveVoices() == sfz::config::numVoices);
+
+    synth.noteOff(0, 1, 60, 0);
+    renderUntilSilent(synth);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+    for (int i = 0; i < sfz::config::numVoices; ++i)
+        synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getNumActiveVoices() == sfz::config::numVoices);
+}
+
+TEST_CASE("[Synth] Polyphony")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+    REQUIRE(synth.getNumVoices() == sfz::config::numVoices);
+
+    synth.setNumVoices(0);
+    REQUIRE(synth.getNumVoices() == 1);
+    synth.setNumVoices(sfz::config::maxVoices + 1);
+    REQUIRE(synth.getNumVoices() == sfz::config::maxVoices);
+
+    synth.setNumVoices(1000);
+    for (int i = 0; i < 1000; ++i)
+        synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getNumActiveVoices() == 1000);
+
+    // The stolen voice fades out
+    synth.noteOn(0, 1, 61, 127);
+    REQUIRE(synth.getNumActiveVoices() == 1001);
+    renderBlocks(synth, 4);
+    REQUIRE(synth.getNumActiveVoices() == 1000);
+}
+
+TEST_CASE("[Synth] Too many voices fading out at once")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+    synth.setNumVoices(8);
+    // One voice is kept aside to fade out the stolen notes
+    for (int i = 0; i < 10; ++i)
+        synth.noteOn(0, 1, 60 + i, 127);
+    REQUIRE(synth.getNumActiveVoices() == 9);
+    // The last note cuts the oldest stolen voice short rather than being dropped
+    REQUIRE(synth.getNumDroppedNotes() == 0);
+    renderBlocks(synth, 4);
+    REQUIRE(synth.getNumActiveVoices() == 8);
+}
+
+TEST_CASE("[Synth] Voice stealing policies")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+    synth.setNumVoices(4);
+    for (int note = 60; note < 64; ++note)
+        synth.noteOn(0, 1, note, 127);
+
+    // Releasing a note that was stolen does not change the number of voices
+    auto isPlaying = [&](int note) {
+        const auto numActiveVoices = synth.getNumActiveVoices();
+        synth.noteOff(0, 1, note, 0);
+        renderBlocks(synth, 4);
+        return synth.getNumActiveVoices() < numActiveVoices;
+    };
+
+    SECTION("Oldest")
+    {
+        synth.setStealingPolicy(sfz::Synth::StealingPolicy::Oldest);
+        synth.noteOn(0, 1, 64, 127);
+        renderBlocks(synth, 4);
+        REQUIRE(synth.getNumActiveVoices() == 4);
+        REQUIRE(!isPlaying(60));
+        REQUIRE(isPlaying(61));
+    }
+
+    SECTION("Same note first")
+    {
+        synth.setStealingPolicy(sfz::Synth::StealingPolicy::SameNoteFirst);
+        synth.noteOn(0, 1, 62, 127);
+        renderBlocks(synth, 4);
+        REQUIRE(synth.getNumActiveVoices() == 4);
+        REQUIRE(isPlaying(60));
+        REQUIRE(isPlaying(61));
+        REQUIRE(isPlaying(62));
+        REQUIRE(synth.getNumActiveVoices() == 1);
+    }
+
+    SECTION("Released first")
+    {
+        synth.setStealingPolicy(sfz::Synth::StealingPolicy::ReleasedFirst);
+        synth.noteOff(0, 1, 62, 0);
+        synth.noteOn(0, 1, 64, 127);
+        renderBlocks(synth, 4);
+        REQUIRE(synth.getNumActiveVoices() == 4);
+        REQUIRE(isPlaying(60));
+    }
+
+    SECTION("Quietest")
+    {
+        synth.setStealingPolicy(sfz::Synth::StealingPolicy::Quietest);
+        synth.noteOff(0, 1, 61, 0);
+        renderBlocks(synth, 1);
+        synth.noteOn(0, 1, 64, 127);
+        renderBlocks(synth, 4);
+        REQUIRE(synth.getNumActiveVoices() == 4);
+        REQUIRE(isPlaying(60));
+    }
+}
+
+TEST_CASE("[Synth] Keyswitches outside of the key ranges")
+{
+    sfz::Synth synth;
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/keyswitches.sfz");
+    synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+    synth.noteOn(0, 1, 24, 127);
+    synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+    synth.noteOn(0, 1, 25, 127);
+    synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+    // Outside of the keyswitch range
+    synth.noteOn(0, 1, 26, 127);
+    synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getNumActiveVoices() == 3);
+}
+
+TEST_CASE("[Synth] Parallel rendering")
+{
+    sfz::Synth serialSynth;
+    sfz::Synth parallelSynth;
+    parallelSynth.setNumRenderThreads(3);
+    REQUIRE(parallelSynth.getNumRenderThreads() <= 3);
+    for (auto* synth : { &serialSynth, &parallelSynth }) {
+        synth->setSamplesPerBlock(blockSize);
+        synth->loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+        for (int note = 48; note < 72; ++note)
+            synth->noteOn(note, 1, note, 100);
+    }
+
+    AudioBuffer<float> serialBuffer { 2, blockSize };
+    AudioBuffer<float> parallelBuffer { 2, blockSize };
+    for (int block = 0; block < 20; ++block) {
+        if (block == 10) {
+            for (int note = 48; note < 72; ++note) {
+                serialSynth.noteOff(0, 1, note, 0);
+                parallelSynth.noteOff(0, 1, note, 0);
+            }
+        }
+        serialSynth.renderBlock(serialBuffer);
+        parallelSynth.renderBlock(parallelBuffer);
+        // The voices are summed in another order
+        for (int channel = 0; channel < 2; ++channel) {
+            for (int i = 0; i < blockSize; ++i)
+                REQUIRE(parallelBuffer.getSample(channel, i) == Approx(serialBuffer.getSample(channel, i)).margin(1e-4));
+        }
+        REQUIRE(parallelSynth.getNumActiveVoices() == serialSynth.getNumActiveVoices());
+    }
+    REQUIRE(parallelSynth.getNumActiveVoices() == 0);
+}
+
+TEST_CASE("[Synth] Sample quality")
+{
+    sfz::Synth synth;
+    REQUIRE(synth.getSampleQuality() == 0);
+    synth.setSampleQuality(7);
+    REQUIRE(synth.getSampleQuality() == 4);
+    synth.setSampleQuality(-1);
+    REQUIRE(synth.getSampleQuality() == 0);
+
+    // The interpolators all play the transposed sample at about the same level,
+    // from the preloaded data for the first blocks
+    std::vector<double> energies;
+    for (int quality = 0; quality <= 4; ++quality) {
+        sfz::Synth qualitySynth;
+        qualitySynth.setSampleQuality(quality);
+        qualitySynth.setSamplesPerBlock(blockSize);
+        qualitySynth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sample_quality.sfz");
+        qualitySynth.noteOn(0, 1, 64, 127);
+        AudioBuffer<float> buffer { 2, blockSize };
+        double energy { 0.0 };
+        for (int block = 0; block < 20; ++block) {
+            qualitySynth.renderBlock(buffer);
+            for (int i = 0; i < blockSize; ++i)
+                energy += buffer.getSample(0, i) * buffer.getSample(0, i);
+        }
+        energies.push_back(energy);
+    }
+    REQUIRE(energies[0] > 0.0);
+    for (auto energy : energies)
+        REQUIRE(energy == Approx(energies[0]).epsilon(0.05));
+}
+
+TEST_CASE("[Synth] Oversampling")
+{
+    // Linear interpolation gets closer to the 32-point sinc as the preloads are oversampled
+    auto render = [](int quality, int oversamplingFactor) {
+        sfz::Synth synth;
+        synth.setSampleQuality(quality);
+        synth.setOversamplingFactor(oversamplingFactor);
+        synth.setSamplesPerBlock(blockSize);
+        synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sample_quality.sfz");
+        synth.noteOn(0, 1, 64, 127);
+        AudioBuffer<float> buffer { 2, blockSize };
+        std::vector<float> output;
+        for (int block = 0; block < 20; ++block) {
+            synth.renderBlock(buffer);
+            output.insert(output.end(), buffer.channelReader(0), buffer.channelReaderEnd(0));
+        }
+        return output;
+    };
+
+    const auto reference = render(4, 1);
+    std::vector<double> errors;
+    for (int factor : { 1, 2, 4 }) {
+        const auto output = render(0, factor);
+        double error { 0.0 };
+        for (size_t i = 0; i < output.size(); ++i)
+            error += (output[i] - reference[i]) * (output[i] - reference[i]);
+        errors.push_back(error);
+    }
+    REQUIRE(errors[1] < errors[0] / 4);
+    REQUIRE(errors[2] < errors[1] / 4);
+}
+
+TEST_CASE("[Synth] Sinc interpolation of transposed oversampled preloads")
+{
+    // A 20 kHz sine played an octave up lies above the Nyquist frequency, so all that
+    // comes out is aliasing, which the sinc filters as well from the oversampled preloads
+    auto render = [](int oversamplingFactor, int noteNumber) {
+        sfz::Synth synth;
+        synth.setSampleQuality(4);
+        synth.setOversamplingFactor(oversamplingFactor);
+        synth.setSamplesPerBlock(blockSize);
+        synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/aliasing.sfz");
+        synth.noteOn(0, 1, noteNumber, 127);
+        AudioBuffer<float> buffer { 2, blockSize };
+        double energy { 0.0 };
+        for (int block = 0; block < 16; ++block) {
+            synth.renderBlock(buffer);
+            for (int i = 0; i < blockSize; ++i)
+                energy += buffer.getSample(0, i) * buffer.getSample(0, i);
+        }
+        return energy;
+    };
+
+    const auto sineEnergy = render(1, 60);
+    REQUIRE(sineEnergy > 0.0);
+    // The 32 taps spread over a step of 8 make a gentler filter at 4 times oversampling;
+    // choosing the band from the pitch alone lets through about half of the energy
+    for (int factor : { 1, 2, 4 })
+        REQUIRE(render(factor, 72) < 1e-2 * sineEnergy);
+}
+
+TEST_CASE("[Synth] Sample-accurate note starts")
+{
+    // A voice plays the same frames wherever it starts in the block, and the region
+    // delay can push it several blocks later
+    auto render = [](const std::string& file, int delay) {
+        sfz::Synth synth;
+        synth.setSamplesPerBlock(blockSize);
+        synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles" / file);
+        synth.noteOn(delay, 1, 60, 127);
+        AudioBuffer<float> buffer { 2, blockSize };
+        std::vector<float> output;
+        for (int block = 0; block < 8; ++block) {
+            synth.renderBlock(buffer);
+            output.insert(output.end(), buffer.channelReader(0), buffer.channelReaderEnd(0));
+        }
+        return output;
+    };
+
+    const auto reference = render("sample_quality.sfz", 0);
+    REQUIRE(reference.front() != 0.0f);
+    for (auto [file, delay, expectedDelay] : { std::make_tuple("sample_quality.sfz", 100, 100), std::make_tuple("sample_delay.sfz", 20, 500) }) {
+        const auto output = render(file, delay);
+        for (int i = 0; i < expectedDelay; ++i)
+            REQUIRE(output[i] == 0.0f);
+        for (size_t i = expectedDelay; i < output.size(); ++i)
+            REQUIRE(output[i] == reference[i - expectedDelay]);
+    }
+}
+
+TEST_CASE("[Synth] Delayed generators stay continuous")
+{
+    // A sine starting partway into a block carries on with the right phase in the next one
+    auto render = [](int delay) {
+        sfz::Synth synth;
+        synth.setSamplesPerBlock(blockSize);
+        synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+        synth.noteOn(delay, 1, 60, 127);
+        AudioBuffer<float> buffer { 2, blockSize };
+        std::vector<float> output;
+        for (int block = 0; block < 2; ++block) {
+            synth.renderBlock(buffer);
+            output.insert(output.end(), buffer.channelReader(0), buffer.channelReaderEnd(0));
+        }
+        return output;
+    };
+
+    const auto reference = render(0);
+    const int delay { blockSize - 56 };
+    const auto output = render(delay);
+    for (int i = 0; i < delay; ++i)
+        REQUIRE(output[i] == 0.0f);
+    for (size_t i = delay; i < output.size(); ++i)
+        REQUIRE(output[i] == Approx(reference[i - delay]).margin(1e-4));
+}
+
+TEST_CASE("[Synth] Commands from other threads")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sample_quality.sfz");
+    AudioBuffer<float> buffer { 2, blockSize };
+
+    // The commands wait for the next block
+    bool sent { true };
+    std::thread sender([&synth, &sent]() {
+        sent &= synth.sendSampleQuality(2);
+        sent &= synth.sendStealingPolicy(sfz::Synth::StealingPolicy::Quietest);
+        for (int note = 60; note < 64; ++note)
+            sent &= synth.sendNoteOn(0, 1, note, 127);
+    });
+    sender.join();
+    REQUIRE(sent);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+    REQUIRE(synth.getSampleQuality() == 0);
+
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 4);
+    REQUIRE(synth.getSampleQuality() == 2);
+    REQUIRE(synth.getStealingPolicy() == sfz::Synth::StealingPolicy::Quietest);
+
+    // Senders and rendering can run at the same time
+    std::atomic<bool> rendering { true };
+    std::thread renderer([&]() {
+        while (rendering)
+            synth.renderBlock(buffer);
+    });
+    std::vector<std::thread> senders;
+    for (int channel = 1; channel <= 4; ++channel) {
+        senders.emplace_back([&synth, channel]() {
+            for (int i = 0; i < 1000; ++i) {
+                while (!synth.sendCC(i % blockSize, channel, 7, static_cast<uint8_t>(i % 128)))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& sender : senders)
+        sender.join();
+    rendering = false;
+    renderer.join();
+
+    synth.renderBlock(buffer);
+    REQUIRE(synth.sendNoteOff(0, 1, 60, 0));
+}
+
+TEST_CASE("[Synth] Asynchronous loading")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+    synth.noteOn(0, 1, 60, 127);
+    renderBlocks(synth, 1);
+
+    REQUIRE(synth.loadSfzFileAsync(std::filesystem::current_path() / "tests/TestFiles/groups_avl.sfz"));
+    waitForLoading(synth);
+    REQUIRE(synth.getLoadingStatus() == sfz::Synth::LoadingStatus::Loaded);
+    REQUIRE(synth.getNumRegions() == 5);
+
+    // The held note keeps playing on the previous instrument
+    renderBlocks(synth, 1);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+    synth.noteOn(0, 1, 60, 127);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+    synth.noteOn(0, 1, 36, 127);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+    synth.noteOff(0, 1, 60, 0);
+    synth.noteOff(0, 1, 36, 0);
+    renderUntilSilent(synth);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+
+    // A failed load keeps the current instrument
+    REQUIRE(synth.loadSfzFileAsync(std::filesystem::current_path() / "tests/TestFiles/missing.sfz"));
+    waitForLoading(synth);
+    REQUIRE(synth.getLoadingStatus() == sfz::Synth::LoadingStatus::Failed);
+    REQUIRE(synth.getNumRegions() == 5);
+    renderBlocks(synth, 1);
+    synth.noteOn(0, 1, 36, 127);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+}
+
+TEST_CASE("[Synth] The CCs keep their values across instruments")
+{
+    // The new instrument only plays when CC 1 and CC 2 are both high, and defaults them to 0 and 127
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sine_release.sfz");
+    synth.cc(0, 1, 1, 100);
+    synth.noteOn(0, 1, 60, 127);
+    renderBlocks(synth, 1);
+
+    REQUIRE(synth.loadSfzFileAsync(std::filesystem::current_path() / "tests/TestFiles/cc_conditions.sfz"));
+    waitForLoading(synth);
+    renderBlocks(synth, 1);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+    synth.noteOn(0, 1, 62, 127);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+
+    synth.cc(0, 1, 2, 0);
+    synth.noteOn(0, 1, 64, 127);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+}
+
+TEST_CASE("[Synth] Loading while rendering")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    AudioBuffer<float> buffer { 2, blockSize };
+
+    std::atomic<bool> rendering { true };
+    std::thread renderer([&]() {
+        while (rendering) {
+            synth.renderBlock(buffer);
+            synth.sendNoteOn(0, 1, 36, 127);
+            synth.sendNoteOn(0, 1, 60, 127);
+            synth.sendNoteOff(blockSize / 2, 1, 60, 0);
+        }
+    });
+
+    // Each load replaces an instrument whose voices are still playing
+    for (int i = 0; i < 20; ++i) {
+        const auto file = (i % 2 == 0) ? "tests/TestFiles/groups_avl.sfz" : "tests/TestFiles/sine_release.sfz";
+        REQUIRE(synth.loadSfzFileAsync(std::filesystem::current_path() / file));
+        waitForLoading(synth);
+        REQUIRE(synth.getLoadingStatus() == sfz::Synth::LoadingStatus::Loaded);
+    }
+    rendering = false;
+    renderer.join();
+
+    REQUIRE(synth.getNumRegions() == 1);
+}
+
+TEST_CASE("[Synth] Freewheeling")
+{
+    // Without their preload the voices stream the whole sample, and the output has no gaps
+    auto render = [](bool evictPreloads) {
+        sfz::Synth synth;
+        synth.setSamplesPerBlock(blockSize);
+        synth.setFreewheeling(true);
+        synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/sample_quality.sfz");
+        if (evictPreloads)
+            synth.setPreloadMemoryBudget(1);
+        synth.noteOn(0, 1, 60, 127);
+
+        std::vector<float> output;
+        AudioBuffer<float> buffer { 2, blockSize };
+        for (int i = 0; i < 200; ++i) {
+            synth.renderBlock(buffer);
+            for (int frame = 0; frame < blockSize; ++frame)
+                output.push_back(buffer.channelReader(0)[frame]);
+        }
+        return output;
+    };
+
+    const auto preloaded = render(false);
+    const auto streamed = render(true);
+    REQUIRE(std::any_of(preloaded.begin(), preloaded.end(), [](float sample) { return sample != 0.0f; }));
+    // The preloaded voices switch to the stream midway, which rounds their position differently
+    for (size_t i = 0; i < preloaded.size(); ++i)
+        REQUIRE(streamed[i] == Approx(preloaded[i]).margin(1e-3));
+}
+
+TEST_CASE("[Synth] Streamed notes are kept when the streaming buffers run out")
+{
+    // More streamed notes at once than spare buffers: the loading threads cannot allocate
+    // them all in time, and the voices without one play their preloaded data
+    constexpr int numNotes { 4 * sfz::config::numSpareStreamingBuffers };
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(blockSize);
+    synth.setNumVoices(numNotes);
+    synth.loadSfzFile(std::filesystem::current_path() / "tests/TestFiles/channels.sfz");
+    for (int i = 0; i < numNotes; ++i)
+        synth.noteOn(0, 1, 61, 127);
+    REQUIRE(synth.getNumActiveVoices() == numNotes);
+
+    AudioBuffer<float> buffer { 2, blockSize };
+    bool finite { true };
+    for (int i = 0; i < 100; ++i) {
+        synth.renderBlock(buffer);
+        for (int channel = 0; channel < 2; ++channel)
+            finite = finite && std::all_of(buffer.channelReader(channel), buffer.channelReaderEnd(channel), [](float x) { return std::isfinite(x); });
+    }
+    REQUIRE(finite);
+}
+
+TEST_CASE("[Synth] Realtime sections")
+{
+    REQUIRE(!sfz::ScopedRealtimeSection::isActive());
+#ifdef SFIZZ_REALTIME_CHECKS
+    {
+        sfz::ScopedRealtimeSection outer;
+        {
+            sfz::ScopedRealtimeSection inner;
+            REQUIRE(sfz::ScopedRealtimeSection::isActive());
+            sfz::ScopedRealtimeExemption exemption;
+            REQUIRE(!sfz::ScopedRealtimeSection::isActive());
+        }
+        REQUIRE(sfz::ScopedRealtimeSection::isActive());
+    }
+    REQUIRE(!sfz::ScopedRealtimeSection::isActive());
+#endif
+}
+
+TEST_CASE("[Synth] Note storms do not allocate")
+{
+    // With the realtime checks any allocation on the audio path trips an assertion
+    for (const char* file : { "tests/TestFiles/sample_quality.sfz", "tests/TestFiles/sine_cc.sfz" }) {
+        sfz::Synth synth;
+        synth.setSamplesPerBlock(blockSize);
+        synth.setNumVoices(8);
+        synth.setNumRenderThreads(2);
+        synth.loadSfzFile(std::filesystem::current_path() / file);
+
+        AudioBuffer<float> buffer { 2, blockSize };
+        for (int block = 0; block < 100; ++block) {
+            for (int i = 0; i < 8; ++i) {
+                const int note = 36 + (block * 7 + i * 5) % 48;
+                synth.noteOn(i * 16, 1, note, 100);
+                synth.sendNoteOff(i * 16 + 8, 1, 36 + (block * 3 + i) % 48, 0);
+            }
+            synth.cc(0, 1, 1, static_cast<uint8_t>(block));
+            synth.sendCC(blockSize / 2, 1, 10, static_cast<uint8_t>(127 - block));
+            synth.pitchWheel(0, 1, block * 64);
+            synth.aftertouch(0, 1, static_cast<uint8_t>(block));
+            synth.sendTempo(0, 0.5f);
+            synth.renderBlock(buffer);
+        }
+        renderUntilSilent(synth);
+        REQUIRE(synth.getNumActiveVoices() <= 8);
+    }
+}